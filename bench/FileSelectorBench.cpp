@@ -0,0 +1,274 @@
+// FileSelectorBench.cpp
+// Micro benchmarks for the hot paths of the selector, run against generated trees.
+// Results are written as JSON so runs of different versions can be compared.
+//
+//   FileSelectorBench [--root <dir>] [--sizes 10000,100000,1000000] [--filter <name>]
+//                     [--min-time-ms <ms>] [--output <file>]
+#include "AllocTracker.hpp"
+#include "CommandProcessor.hpp"
+#include "ContentSniffer.hpp"
+#include "FileSystemManager.hpp"
+#include "FrecencyDatabase.hpp"
+#include "ListingCache.hpp"
+#include "OutputSinks.hpp"
+#include "SelectionPolicy.hpp"
+#include "TreeGenerator.hpp"
+#include "UIRenderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/os.h>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct BenchResult {
+    std::string name;
+    std::string tree;
+    size_t entries{0};
+    size_t iterations{0};
+    double minNs{0};
+    double medianNs{0};
+    double meanNs{0};
+    double maxNs{0};
+    double allocations{0}; // Per iteration, 0 unless built with ENABLE_ALLOC_TRACKING
+};
+
+class BenchRunner {
+public:
+    BenchRunner(std::string filter, std::chrono::milliseconds minTime)
+        : filter(std::move(filter)), minTime(minTime) {}
+
+    // Times body() until minTime has passed (at least 3 and at most 1000 iterations).
+    // setup() runs before every iteration and is not timed.
+    void run(const std::string &name, const std::string &tree, size_t entries,
+             const std::function<void()> &setup, const std::function<void()> &body) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+        std::vector<double> samples;
+        Clock::duration total{};
+        uint64_t allocations = 0;
+        setup();
+        body(); // Warm-up
+        while ((samples.size() < 3 || total < minTime) && samples.size() < 1000) {
+            setup();
+            const uint64_t allocations_before = AllocTracker::allocationCount();
+            auto start = Clock::now();
+            body();
+            auto elapsed = Clock::now() - start;
+            allocations += AllocTracker::allocationCount() - allocations_before;
+            total += elapsed;
+            samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        BenchResult result{name, tree, entries, samples.size(), samples.front(), samples[samples.size() / 2], 0, samples.back(),
+                           static_cast<double>(allocations) / static_cast<double>(samples.size())};
+        for (double sample : samples) {
+            result.meanNs += sample / static_cast<double>(samples.size());
+        }
+        fmt::print(stderr, "{:<28} {:<24} {:>8} entries  median {:>12.3f} ms  ({} runs)\n",
+                   name, tree, entries, result.medianNs / 1e6, result.iterations);
+        results.push_back(std::move(result));
+    }
+
+    void run(const std::string &name, const std::string &tree, size_t entries, const std::function<void()> &body) {
+        run(name, tree, entries, [] {}, body);
+    }
+
+    std::string toJson() const {
+        std::string json = "{\n  \"suite\": \"FileSelectorBench\",\n  \"version\": 2,\n";
+        json += fmt::format("  \"alloc_tracking\": {},\n  \"peak_rss_kb\": {},\n  \"live_bytes\": {{",
+                            AllocTracker::isCompiledIn(), AllocTracker::peakRssKb());
+        for (size_t i = 0; i < AllocTracker::SubsystemCount; ++i) {
+            auto subsystem = static_cast<AllocTracker::Subsystem>(i);
+            json += fmt::format("{}\"{}\": {}", i ? ", " : "", AllocTracker::name(subsystem), AllocTracker::liveBytes(subsystem));
+        }
+        json += "},\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto &r = results[i];
+            json += fmt::format("    {{\"name\": \"{}\", \"tree\": \"{}\", \"entries\": {}, \"iterations\": {}, "
+                                "\"min_ns\": {:.0f}, \"median_ns\": {:.0f}, \"mean_ns\": {:.0f}, \"max_ns\": {:.0f}, "
+                                "\"allocations\": {:.1f}}}{}\n",
+                                r.name, r.tree, r.entries, r.iterations, r.minNs, r.medianNs, r.meanNs, r.maxNs, r.allocations,
+                                i + 1 < results.size() ? "," : "");
+        }
+        json += "  ]\n}\n";
+        return json;
+    }
+
+private:
+    std::string filter;
+    std::chrono::milliseconds minTime;
+    std::vector<BenchResult> results;
+};
+
+static void benchTree(BenchRunner &runner, const std::string &tree, const fs::path &directory) {
+    FileSystemManager fsManager(directory);
+    fsManager.refreshDirectory(false);
+    const size_t entry_count = fsManager.getEntries().size();
+
+    // Cold scans, then hits in the process-wide listing cache (one stat each).
+    runner.run("refreshDirectory", tree, entry_count,
+               [] { ListingCache::instance().clear(); }, [&] { fsManager.refreshDirectory(false); });
+    runner.run("refreshDirectory[cached]", tree, entry_count, [&] { fsManager.refreshDirectory(false); });
+
+    // Sorting starts from the same shuffled listing every iteration.
+    std::vector<FileSystemManager::Entry> shuffled = fsManager.getEntries();
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{42});
+    std::vector<FileSystemManager::Entry> listing;
+    for (const std::string policy : {"dir", "name", "natural", "iname", "time", "type", "size", "dir,type,name"}) {
+        fsManager.setSortPolicy(policy);
+        runner.run("sortEntries[" + policy + "]", tree, entry_count,
+                   [&] { listing = shuffled; }, [&] { fsManager.sortEntries(listing); });
+    }
+    fsManager.setSortPolicy("dir,type,name");
+    fsManager.refreshDirectory(false);
+
+    fsManager.searchName = "12";
+    runner.run("search", tree, entry_count, [&] { fsManager.search(); });
+    fsManager.searchName.clear();
+    fsManager.search();
+
+    fsManager.setFilters("txt, mindes");
+    size_t matched = 0;
+    runner.run("matchesFilter", tree, entry_count, [&] {
+        for (const auto &entry : fsManager.getEntries()) {
+            matched += fsManager.matchesFilter(entry.path());
+        }
+    });
+    fsManager.setFilters("");
+
+    // Content filter: every head read (in parallel), then only stats against the signature cache.
+    fsManager.setFilters("kind:mindes");
+    runner.run("refreshDirectory[kind:mindes]", tree, entry_count, [] {
+        ListingCache::instance().clear();
+        ContentSniffer::instance().clear();
+    }, [&] { fsManager.refreshDirectory(false); });
+    runner.run("refreshDirectory[kind:mindes,sniffed]", tree, entry_count,
+               [] { ListingCache::instance().clear(); }, [&] { fsManager.refreshDirectory(false); });
+    fsManager.setFilters("");
+    fsManager.refreshDirectory(false);
+
+    // Ranges over regular files only: directories in a range are rejected by design.
+    fsManager.setSortPolicy("dir");
+    fsManager.refreshDirectory(false);
+    const auto &entries = fsManager.getEntries();
+    size_t first_file = std::find_if(entries.begin(), entries.end(), [](const auto &e) { return !e.is_directory(); }) - entries.begin();
+    if (first_file < entries.size()) {
+        CommandProcessor cmdProcessor(fsManager);
+        const std::string range = fmt::format("{}-{}", first_file + 1, entries.size());
+        runner.run("processNumberInput[range]", tree, entries.size() - first_file,
+                   [&] { cmdProcessor.processNumberInput(range, MultipleSelection{}); });
+    }
+    fsManager.setSortPolicy("dir,type,name");
+    fsManager.refreshDirectory(false);
+
+    // Rendering into a sink that drops the bytes: full redraws, and one-row scrolling (diff path).
+    NullOutputSink sink(50);
+    UIRenderer uiRenderer;
+    std::set<fs::path> selected;
+    size_t cursor = entry_count / 2;
+    auto draw_frame = [&] {
+        uiRenderer.beginFrame(sink.screenRows());
+        uiRenderer.drawHeader(directory.string(), {}, false, "", false, true);
+        uiRenderer.drawFooter(selected, true, MultipleSelection{}.describe(selected.size()));
+        uiRenderer.drawFileList(fsManager.getEntries(), cursor, selected);
+        sink.present(uiRenderer.endFrame(), 0);
+    };
+    runner.run("drawFileList[full]", tree, entry_count, [&] { uiRenderer.invalidate(); }, draw_frame);
+    runner.run("drawFileList[scroll]", tree, entry_count,
+               [&] { cursor = entry_count ? (cursor + 1) % entry_count : 0; }, draw_frame);
+
+    // Tree view with every top-level directory expanded; bottom-up, so the rows above stay put.
+    fsManager.setTreeView(true, 0);
+    bool has_directories = false;
+    for (size_t row = entry_count; row-- > 0;) {
+        has_directories |= fsManager.toggleExpanded(row);
+    }
+    if (has_directories) {
+        const size_t row_count = fsManager.entryCount();
+        runner.run("toggleExpanded[tree]", tree, row_count, [&] { fsManager.toggleExpanded(0); });
+        cursor = row_count / 2;
+        runner.run("drawFileList[tree]", tree, row_count, [&] { uiRenderer.invalidate(); }, [&] {
+            uiRenderer.beginFrame(sink.screenRows());
+            uiRenderer.drawFileList(fsManager.shareTreeRows(), cursor, selected);
+            sink.present(uiRenderer.endFrame(), 0);
+        });
+    }
+    fsManager.setTreeView(false, 0);
+}
+
+static std::vector<size_t> parseSizes(const std::string &list) {
+    std::vector<size_t> sizes;
+    std::istringstream iss(list);
+    std::string token;
+    while (std::getline(iss, token, ',')) {
+        sizes.push_back(std::stoul(token));
+    }
+    return sizes;
+}
+
+int main(int argc, char *argv[]) {
+    fs::path root = fs::temp_directory_path() / "FileSelectorBench";
+    std::vector<size_t> sizes{10'000, 100'000};
+    std::string filter;
+    std::string output;
+    long min_time_ms = 200;
+    FrecencyDatabase::instance().setFile({}); // Navigating generated trees must not reach the user's :z
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--root") {
+                root = value();
+            } else if (arg == "--sizes") {
+                sizes = parseSizes(value());
+            } else if (arg == "--filter") {
+                filter = value();
+            } else if (arg == "--min-time-ms") {
+                min_time_ms = std::stol(value());
+            } else if (arg == "--output") {
+                output = value();
+            } else {
+                throw std::invalid_argument("Unknown argument: " + arg);
+            }
+        }
+
+        TreeGenerator generator(root);
+        BenchRunner runner(filter, std::chrono::milliseconds(min_time_ms));
+        for (size_t size : sizes) {
+            benchTree(runner, fmt::format("flat_{}", size), generator.flat(size));
+        }
+        benchTree(runner, "deep_4x6x20", generator.deep(4, 6, 20));
+        benchTree(runner, "series_50000", generator.series(50'000));
+        benchTree(runner, "hidden_20000", generator.mixedHidden(20'000));
+
+        if (output.empty()) {
+            fmt::print("{}", runner.toJson());
+        } else {
+            auto out = fmt::output_file(output);
+            out.print("{}", runner.toJson());
+        }
+    } catch (const std::exception &e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+// PtyLatencyBench.cpp
+// End-to-end latency of the interactive selector: runs FileSelectorApp on a pseudo-terminal, types
+// keys at a controlled rate and times the frame output each key brings out, so the whole path from
+// the terminal through the session threads and the renderer back to the terminal is measured:
+//
+//   FileSelectorPtyBench [--app bin/linux/Release/FileSelectorApp] [--root <dir>] [--size 100000]
+//                        [--keys 200] [--interval-ms 30] [--filter <name>] [--output <file>]
+//
+// A key is answered by the burst of output that follows it; the burst ends once the terminal has
+// been quiet for quiet_gap. Latency runs from writing the key to the last byte of its burst (the
+// quiet gap itself is not counted). The next key goes out interval after the previous one, or as
+// soon as the answer is complete if that takes longer, so slow frames do not pile keys up.
+#include "TreeGenerator.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/os.h>
+
+#include <poll.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+constexpr unsigned short screen_rows = 50;
+constexpr unsigned short screen_columns = 160;
+constexpr auto quiet_gap = std::chrono::milliseconds(15);
+constexpr auto key_timeout = std::chrono::seconds(2);       // A key with no output by then is missed
+constexpr auto settle_gap = std::chrono::milliseconds(500); // Startup is done when quiet this long
+constexpr auto startup_timeout = std::chrono::seconds(60);
+constexpr auto quit_timeout = std::chrono::seconds(30); // Quitting waits for scans still running
+
+// FileSelectorApp on the slave side of a pseudo-terminal, as if started in a terminal window.
+class PtySession {
+public:
+    struct Burst {
+        std::string output;
+        std::optional<Clock::time_point> lastByte; // Unset if nothing came
+    };
+
+    PtySession(const fs::path &app, const std::vector<std::string> &arguments) {
+        winsize size{};
+        size.ws_row = screen_rows;
+        size.ws_col = screen_columns;
+        int slave = -1;
+        if (::openpty(&master, &slave, nullptr, nullptr, &size) != 0) {
+            throw std::system_error(errno, std::generic_category(), "openpty");
+        }
+        child = ::fork();
+        if (child < 0) {
+            const int error = errno;
+            ::close(master);
+            ::close(slave);
+            throw std::system_error(error, std::generic_category(), "fork");
+        }
+        if (child == 0) {
+            ::setsid();
+            ::ioctl(slave, TIOCSCTTY, 0);
+            ::dup2(slave, STDIN_FILENO);
+            ::dup2(slave, STDOUT_FILENO);
+            ::dup2(slave, STDERR_FILENO);
+            ::close(slave);
+            ::close(master);
+            std::vector<char *> argv{const_cast<char *>(app.c_str())};
+            for (const auto &argument : arguments) {
+                argv.push_back(const_cast<char *>(argument.c_str()));
+            }
+            argv.push_back(nullptr);
+            ::execv(app.c_str(), argv.data());
+            ::_exit(127);
+        }
+        ::close(slave);
+    }
+
+    ~PtySession() {
+        if (child > 0) {
+            ::kill(child, SIGKILL);
+            ::waitpid(child, nullptr, 0);
+        }
+        ::close(master);
+    }
+
+    PtySession(const PtySession &) = delete;
+    PtySession &operator=(const PtySession &) = delete;
+
+    void send(std::string_view keys) {
+        while (!keys.empty()) {
+            const ssize_t count = ::write(master, keys.data(), keys.size());
+            if (count < 0 && errno != EINTR) {
+                throw std::system_error(errno, std::generic_category(), "write to pty");
+            }
+            keys.remove_prefix(count < 0 ? 0 : static_cast<size_t>(count));
+        }
+    }
+
+    // Reads until the output has been quiet for quiet (after at least one byte) or timeout has passed.
+    Burst readBurst(Clock::duration quiet, Clock::duration timeout) {
+        Burst burst;
+        const auto deadline = Clock::now() + timeout;
+        char buffer[65536];
+        while (true) {
+            const auto now = Clock::now();
+            if (now >= deadline || (burst.lastByte && now - *burst.lastByte >= quiet)) {
+                return burst;
+            }
+            const auto until = burst.lastByte ? std::min(*burst.lastByte + quiet, deadline) : deadline;
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(until - now);
+            pollfd descriptor{master, POLLIN, 0};
+            const int ready = ::poll(&descriptor, 1, static_cast<int>(wait.count()));
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+            const ssize_t count = ::read(master, buffer, sizeof(buffer));
+            if (count <= 0) {
+                return burst; // EIO: the application has exited
+            }
+            burst.output.append(buffer, static_cast<size_t>(count));
+            burst.lastByte = Clock::now();
+        }
+    }
+
+    // Quits the application and waits for it; returns its exit status, or -1 if it had to be killed.
+    int finish() {
+        send("q");
+        const auto deadline = Clock::now() + quit_timeout;
+        int status = 0;
+        while (Clock::now() < deadline) {
+            readBurst(std::chrono::milliseconds(50), std::chrono::milliseconds(100));
+            if (::waitpid(child, &status, WNOHANG) == child) {
+                child = -1;
+                return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            }
+        }
+        return -1;
+    }
+
+private:
+    int master{-1};
+    pid_t child{-1};
+};
+
+struct Scenario {
+    std::string name;
+    std::string tree;
+    fs::path directory;
+    std::vector<std::string> keystrokes; // Typed in turn, from the start again when used up
+};
+
+struct LatencyResult {
+    std::string name;
+    std::string tree;
+    size_t keys{0};
+    size_t missed{0};
+    double p50Ms{0};
+    double p99Ms{0};
+    double maxMs{0};
+    double bytesPerKey{0};
+    bool isListed{true}; // False if the app could not list the directory, so keys ran on an empty list
+    int exitStatus{0};
+};
+
+// The keystrokes of typing text and then Enter (which a terminal sends as CR).
+std::vector<std::string> typed(std::string_view text) {
+    std::vector<std::string> keystrokes;
+    for (char c : text) {
+        keystrokes.emplace_back(1, c);
+    }
+    keystrokes.emplace_back("\r");
+    return keystrokes;
+}
+
+double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+LatencyResult runScenario(const fs::path &app, const Scenario &scenario, size_t key_count,
+                          std::chrono::milliseconds interval) {
+    PtySession session(app, {"--start", scenario.directory.string(), "--output", "/dev/null", "--frecency", "",
+                             "--keymap", ""});
+    // First frame and the background fills behind it. A directory that misses the app's scan deadline
+    // is shown as not listable; its keys are still timed, but the result says so.
+    const bool is_listed =
+        session.readBurst(settle_gap, startup_timeout).output.find("Cannot list this directory") == std::string::npos;
+
+    std::vector<double> latencies;
+    size_t bytes = 0;
+    size_t missed = 0;
+    auto next_key = Clock::now();
+    for (size_t i = 0; i < key_count; ++i) {
+        std::this_thread::sleep_until(next_key);
+        const auto sent = Clock::now();
+        session.send(scenario.keystrokes[i % scenario.keystrokes.size()]);
+        const auto burst = session.readBurst(quiet_gap, key_timeout);
+        bytes += burst.output.size();
+        if (burst.lastByte) {
+            latencies.push_back(std::chrono::duration<double, std::milli>(*burst.lastByte - sent).count());
+        } else {
+            ++missed;
+        }
+        next_key = sent + interval;
+    }
+    // Finish a half-typed command untimed, so that the closing "q" is a key and not command text.
+    for (size_t i = key_count; i % scenario.keystrokes.size() != 0; ++i) {
+        session.send(scenario.keystrokes[i % scenario.keystrokes.size()]);
+        session.readBurst(quiet_gap, key_timeout);
+    }
+
+    LatencyResult result{scenario.name, scenario.tree, key_count, missed};
+    result.isListed = is_listed;
+    result.exitStatus = session.finish();
+    std::sort(latencies.begin(), latencies.end());
+    result.p50Ms = percentile(latencies, 0.50);
+    result.p99Ms = percentile(latencies, 0.99);
+    result.maxMs = latencies.empty() ? 0 : latencies.back();
+    result.bytesPerKey = key_count ? static_cast<double>(bytes) / static_cast<double>(key_count) : 0;
+    fmt::print(stderr, "{:<28} {:<24} {:>5} keys  p50 {:>8.2f} ms  p99 {:>8.2f} ms  {:>8.0f} bytes/key{}{}\n",
+               result.name, result.tree, result.keys, result.p50Ms, result.p99Ms, result.bytesPerKey,
+               missed ? fmt::format("  ({} missed)", missed) : "", is_listed ? "" : "  (not listed)");
+    return result;
+}
+
+std::string toJson(const std::vector<LatencyResult> &results) {
+    std::string json = fmt::format("{{\n  \"suite\": \"FileSelectorPtyBench\",\n  \"version\": 1,\n"
+                                   "  \"rows\": {}, \"columns\": {},\n  \"results\": [\n",
+                                   screen_rows, screen_columns);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &r = results[i];
+        json += fmt::format("    {{\"name\": \"{}\", \"tree\": \"{}\", \"keys\": {}, \"missed\": {}, "
+                            "\"p50_ms\": {:.3f}, \"p99_ms\": {:.3f}, \"max_ms\": {:.3f}, \"bytes_per_key\": {:.1f}, "
+                            "\"listed\": {}, \"exit_status\": {}}}{}\n",
+                            r.name, r.tree, r.keys, r.missed, r.p50Ms, r.p99Ms, r.maxMs, r.bytesPerKey, r.isListed,
+                            r.exitStatus,
+                            i + 1 < results.size() ? "," : "");
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    fs::path app;
+    fs::path root = fs::temp_directory_path() / "FileSelectorBench";
+    size_t size = 100'000;
+    size_t key_count = 200;
+    long interval_ms = 30;
+    std::string filter;
+    std::string output;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--app") {
+                app = value();
+            } else if (arg == "--root") {
+                root = value();
+            } else if (arg == "--size") {
+                size = std::stoul(value());
+            } else if (arg == "--keys") {
+                key_count = std::stoul(value());
+            } else if (arg == "--interval-ms") {
+                interval_ms = std::stol(value());
+            } else if (arg == "--filter") {
+                filter = value();
+            } else if (arg == "--output") {
+                output = value();
+            } else {
+                throw std::invalid_argument("Unknown argument: " + arg);
+            }
+        }
+        if (app.empty()) {
+            app = fs::read_symlink("/proc/self/exe").parent_path() / "FileSelectorApp"; // Built next to this one
+        }
+        if (::access(app.c_str(), X_OK) != 0) {
+            throw std::invalid_argument("Cannot run " + app.string() + " (use --app)");
+        }
+
+        TreeGenerator generator(root);
+        const std::string flat_tree = fmt::format("flat_{}", size);
+        const fs::path flat = generator.flat(size);
+        const fs::path deep = generator.deep(4, 6, 20);
+        std::vector<std::string> search = typed(":search 12");
+        for (auto &keystroke : typed(":search")) {
+            search.push_back(std::move(keystroke));
+        }
+        const std::vector<Scenario> scenarios{
+            {"scroll", flat_tree, flat, {"j"}},
+            {"search", flat_tree, flat, search},
+            {"enter", "deep_4x6x20", deep, {"l", "l", "h", "h"}},
+        };
+
+        std::vector<LatencyResult> results;
+        for (const auto &scenario : scenarios) {
+            if (filter.empty() || scenario.name.find(filter) != std::string::npos) {
+                results.push_back(runScenario(app, scenario, key_count, std::chrono::milliseconds(interval_ms)));
+            }
+        }
+
+        if (output.empty()) {
+            fmt::print("{}", toJson(results));
+        } else {
+            auto out = fmt::output_file(output);
+            out.print("{}", toJson(results));
+        }
+    } catch (const std::exception &e) {
+        fmt::print(stderr, "Error: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
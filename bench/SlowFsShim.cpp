@@ -0,0 +1,104 @@
+// SlowFsShim.cpp
+// LD_PRELOAD library that makes part of the filesystem slow, to try the selector's behaviour on a
+// slow or hung mount (NFS, Lustre) without having one:
+//
+//   LD_PRELOAD=bin/linux/Release/libSlowFsShim.so SLOWFS_PREFIX=/tmp/slow bin/linux/Release/FileSelectorApp /tmp
+//
+// stat, lstat, opendir and open/openat of absolute paths under SLOWFS_PREFIX wait SLOWFS_DELAY_MS
+// (default 1000) before doing the real call; a negative delay hangs them for good. Without
+// SLOWFS_PREFIX nothing is slowed down.
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace {
+struct Settings {
+    std::string_view prefix;
+    long delayMs{1000};
+};
+
+const Settings &settings() {
+    static const Settings loaded = [] {
+        Settings settings;
+        if (const char *prefix = std::getenv("SLOWFS_PREFIX")) {
+            settings.prefix = prefix;
+        }
+        if (const char *delay = std::getenv("SLOWFS_DELAY_MS")) {
+            settings.delayMs = std::strtol(delay, nullptr, 10);
+        }
+        return settings;
+    }();
+    return loaded;
+}
+
+void delayFor(const char *path) {
+    const auto &slow = settings();
+    if (slow.prefix.empty() || !path || std::string_view(path).substr(0, slow.prefix.size()) != slow.prefix) {
+        return;
+    }
+    if (slow.delayMs < 0) {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(slow.delayMs));
+}
+
+template <typename Function>
+Function real(const char *name) {
+    return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+}
+} // namespace
+
+extern "C" {
+int stat(const char *path, struct stat *buffer) {
+    static const auto real_stat = real<int (*)(const char *, struct stat *)>("stat");
+    delayFor(path);
+    return real_stat(path, buffer);
+}
+
+int lstat(const char *path, struct stat *buffer) {
+    static const auto real_lstat = real<int (*)(const char *, struct stat *)>("lstat");
+    delayFor(path);
+    return real_lstat(path, buffer);
+}
+
+DIR *opendir(const char *path) {
+    static const auto real_opendir = real<DIR *(*)(const char *)>("opendir");
+    delayFor(path);
+    return real_opendir(path);
+}
+
+int open(const char *path, int flags, ...) {
+    static const auto real_open = real<int (*)(const char *, int, ...)>("open");
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list arguments;
+        va_start(arguments, flags);
+        mode = va_arg(arguments, mode_t);
+        va_end(arguments);
+    }
+    delayFor(path);
+    return real_open(path, flags, mode);
+}
+
+int openat(int directoryFd, const char *path, int flags, ...) {
+    static const auto real_openat = real<int (*)(int, const char *, int, ...)>("openat");
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list arguments;
+        va_start(arguments, flags);
+        mode = va_arg(arguments, mode_t);
+        va_end(arguments);
+    }
+    delayFor(path);
+    return real_openat(directoryFd, path, flags, mode);
+}
+}
@@ -0,0 +1,132 @@
+// TreeGenerator.cpp
+#include "TreeGenerator.hpp"
+
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr const char *marker_name = ".bench_tree_complete";
+constexpr std::array<const char *, 8> flat_extensions{"txt", "mindes", "dat", "vts", "cpp", "log", "png", "h5"};
+} // namespace
+
+TreeGenerator::TreeGenerator(const fs::path &root) : root(root) {
+    fs::create_directories(root);
+}
+
+bool TreeGenerator::isComplete(const fs::path &directory, const std::string &spec) {
+    std::ifstream marker(directory / marker_name);
+    std::string recorded;
+    return marker && std::getline(marker, recorded) && recorded == spec;
+}
+
+void TreeGenerator::markComplete(const fs::path &directory, const std::string &spec) {
+    std::ofstream marker(directory / marker_name);
+    marker << spec << '\n';
+}
+
+void TreeGenerator::createFile(const fs::path &file, size_t index) {
+    int fd = open(file.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create " + file.string());
+    }
+    // Sparse sizes from a few bytes up to ~1 GiB, and one mtime per minute going back in time.
+    const off_t size = static_cast<off_t>((index * 2654435761u) % (1u << 30));
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to size " + file.string());
+    }
+    const timespec mtime{static_cast<time_t>(1'700'000'000 - static_cast<time_t>(index) * 60), 0};
+    const timespec times[2]{mtime, mtime};
+    futimens(fd, times);
+    close(fd);
+}
+
+fs::path TreeGenerator::flat(size_t count) {
+    const fs::path directory = root / fmt::format("flat_{}", count);
+    const std::string spec = fmt::format("flat {}", count);
+    if (isComplete(directory, spec)) {
+        return directory;
+    }
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    for (size_t i = 0; i < count; ++i) {
+        createFile(directory / fmt::format("file_{:07d}.{}", i, flat_extensions[i % flat_extensions.size()]), i);
+    }
+    // A handful of subdirectories so "dir" sorting has something to move.
+    for (size_t i = 0; i < std::min<size_t>(count / 100, 100); ++i) {
+        fs::create_directory(directory / fmt::format("subdir_{:03d}", i));
+    }
+    markComplete(directory, spec);
+    return directory;
+}
+
+fs::path TreeGenerator::deep(size_t depth, size_t fanout, size_t filesPerDirectory) {
+    const fs::path directory = root / fmt::format("deep_{}x{}x{}", depth, fanout, filesPerDirectory);
+    const std::string spec = fmt::format("deep {} {} {}", depth, fanout, filesPerDirectory);
+    if (isComplete(directory, spec)) {
+        return directory;
+    }
+    fs::remove_all(directory);
+
+    size_t file_index = 0;
+    auto populate = [&](auto &self, const fs::path &parent, size_t level) -> void {
+        fs::create_directories(parent);
+        for (size_t i = 0; i < filesPerDirectory; ++i) {
+            createFile(parent / fmt::format("data_{:04d}.dat", i), file_index++);
+        }
+        if (level == depth) {
+            return;
+        }
+        for (size_t i = 0; i < fanout; ++i) {
+            self(self, parent / fmt::format("case_{:02d}", i), level + 1);
+        }
+    };
+    populate(populate, directory, 0);
+    markComplete(directory, spec);
+    return directory;
+}
+
+fs::path TreeGenerator::series(size_t steps) {
+    const fs::path directory = root / fmt::format("series_{}", steps);
+    const std::string spec = fmt::format("series {}", steps);
+    if (isComplete(directory, spec)) {
+        return directory;
+    }
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    for (size_t i = 0; i < steps; ++i) {
+        createFile(directory / fmt::format("step_{:06d}.vts", i * 100), i);
+    }
+    createFile(directory / "input.mindes", steps);
+    createFile(directory / "log.dat", steps + 1);
+    createFile(directory / "output.txt", steps + 2);
+    markComplete(directory, spec);
+    return directory;
+}
+
+fs::path TreeGenerator::mixedHidden(size_t count) {
+    const fs::path directory = root / fmt::format("hidden_{}", count);
+    const std::string spec = fmt::format("hidden {}", count);
+    if (isComplete(directory, spec)) {
+        return directory;
+    }
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    for (size_t i = 0; i < count; ++i) {
+        const char *prefix = (i % 2 == 0) ? "." : "";
+        if (i % 10 == 0) {
+            fs::create_directory(directory / fmt::format("{}dir_{:07d}", prefix, i));
+        } else {
+            createFile(directory / fmt::format("{}file_{:07d}.{}", prefix, i, flat_extensions[i % flat_extensions.size()]), i);
+        }
+    }
+    markComplete(directory, spec);
+    return directory;
+}
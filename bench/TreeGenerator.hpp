@@ -0,0 +1,31 @@
+// TreeGenerator.hpp
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+namespace fs = std::filesystem;
+
+// Builds synthetic directory trees for the benchmarks.
+// Files are created empty and then given sparse sizes and spread-out modification times,
+// so sorting by size or time has real work to do without costing disk space.
+// A tree is only generated once: a marker file records the finished spec and later runs reuse it.
+class TreeGenerator {
+public:
+    explicit TreeGenerator(const fs::path &root);
+
+    // count files in one directory, mixed extensions (txt, mindes, dat, vts, cpp, ...).
+    fs::path flat(size_t count);
+    // fanout^depth directories, each holding filesPerDirectory files.
+    fs::path deep(size_t depth, size_t fanout, size_t filesPerDirectory);
+    // MInDes style output series: step_%06d.vts plus a few input/log files.
+    fs::path series(size_t steps);
+    // Visible and hidden (dot) files and directories in equal parts.
+    fs::path mixedHidden(size_t count);
+
+private:
+    fs::path root;
+
+    static bool isComplete(const fs::path &directory, const std::string &spec);
+    static void markComplete(const fs::path &directory, const std::string &spec);
+    static void createFile(const fs::path &file, size_t index);
+};
@@ -1,33 +1,272 @@
 #include "src/FileSelector.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <fmt/core.h>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#ifdef __unix__
+#include "src/BufferedFdWriter.hpp"
+#include "src/ContentSniffer.hpp"
+#include "src/ListingCache.hpp"
+#include "src/OutputSinks.hpp"
+#include "src/ScriptDriver.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iostream>
+#endif
+
 namespace fs = std::filesystem;
 
-int main() {
-    std::vector<fs::path> files;
+static const char *usage =
+    "Usage: FileSelectorApp [options] [start]\n"
+    "\n"
+    "Browse from <start> (default: the current directory) and write the selected paths to stdout,\n"
+    "one per line. The selector itself is drawn on the terminal, so the output can be piped.\n"
+    "\n"
+    "  --start <dir>      Directory to start in (same as the positional argument)\n"
+    "  --ext <list>       Only offer files with these extensions, comma separated; repeatable\n"
+    "  --single           Select one file instead of many\n"
+    "  --up-to <n>        Select at most <n> files\n"
+    "  --exactly <n>      Select exactly <n> files (e.g. --exactly 2 for a diff)\n"
+    "  --print0           Terminate paths with NUL instead of newline (for xargs -0)\n"
+    "  --stdin            Choose from the paths read from stdin, one per line, instead of browsing\n"
+    "  --read0            Like --stdin, with NUL-terminated paths (find -print0)\n"
+    "  --output <file>    Write the selection to <file> instead of stdout\n"
+    "  --script <file>    Replay a keystroke script without a terminal; step timings go to stderr\n"
+    "  --session <file>   Resume the session (directory, selection, filter, sort, history) kept in\n"
+    "                     <file>, and keep this one there for next time\n"
+    "  --frecency <file>  Remember the directories entered, for :z, in <file> instead of\n"
+    "                     $XDG_DATA_HOME/FileSelector/frecency (script replays use none by default)\n"
+    "  --keymap <file>    Bind keys as in <file> instead of $XDG_CONFIG_HOME/FileSelector/keymap\n"
+    "                     (script replays use the built-in bindings by default)\n"
+    "  --help             Show this help\n";
+
+struct Options {
+    fs::path start{"."};
+    std::vector<std::string> extensions;
+    bool isSingle{false};
+    size_t upTo{0};    // 0: no bound
+    size_t exactly{0}; // 0: any number
+    bool isPrint0{false};
+    bool isStdin{false};
+    char inputSeparator{'\n'};
+    fs::path output;
+    fs::path script;
+    fs::path session;
+    std::optional<fs::path> frecency;
+    std::optional<fs::path> keymap;
+};
+
+static Options parseArguments(int argc, char *argv[]) {
+    Options options;
+    bool has_start = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        auto count = [&]() -> size_t {
+            const std::string text = value();
+            size_t n = 0;
+            auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), n);
+            if (ec != std::errc() || end != text.data() + text.size() || n == 0) {
+                throw std::invalid_argument(arg + " needs a positive number, got: " + text);
+            }
+            return n;
+        };
+        if (arg == "--start") {
+            options.start = value();
+            has_start = true;
+        } else if (arg == "--ext") {
+            std::istringstream iss(value());
+            std::string ext;
+            while (std::getline(iss, ext, ',')) {
+                if (!ext.empty() && ext[0] == '.') {
+                    ext.erase(0, 1);
+                }
+                if (!ext.empty()) {
+                    options.extensions.push_back(ext);
+                }
+            }
+        } else if (arg == "--single") {
+            options.isSingle = true;
+        } else if (arg == "--up-to") {
+            options.upTo = count();
+        } else if (arg == "--exactly") {
+            options.exactly = count();
+        } else if (arg == "--print0") {
+            options.isPrint0 = true;
+        } else if (arg == "--stdin") {
+            options.isStdin = true;
+        } else if (arg == "--read0") {
+            options.isStdin = true;
+            options.inputSeparator = '\0';
+        } else if (arg == "--output") {
+            options.output = value();
+        } else if (arg == "--script") {
+            options.script = value();
+        } else if (arg == "--session") {
+            options.session = value();
+        } else if (arg == "--frecency") {
+            options.frecency = value();
+        } else if (arg == "--keymap") {
+            options.keymap = value();
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option: " + arg);
+        } else if (!has_start) {
+            options.start = arg;
+            has_start = true;
+        } else {
+            throw std::invalid_argument("Unexpected argument: " + arg);
+        }
+    }
+    if (options.isSingle + (options.upTo != 0) + (options.exactly != 0) > 1) {
+        throw std::invalid_argument("--single, --up-to and --exactly cannot be combined");
+    }
+    return options;
+}
+
+#ifdef __unix__
+static void printTimings(const ScriptDriver &driver) {
+    fmt::print(stderr, "{:>4}  {:>10}  {:>5}  {:>6}  {:>9}  {}\n", "step", "ms", "keys", "frames", "bytes", "script");
+    size_t step = 0;
+    for (const auto &timing : driver.timings()) {
+        const double milliseconds = std::chrono::duration<double, std::milli>(timing.elapsed).count();
+        fmt::print(stderr, "{:>4}  {:>10.3f}  {:>5}  {:>6}  {:>9}  {}\n",
+                   ++step, milliseconds, timing.keyCount, timing.frames, timing.bytes, timing.description);
+    }
+    const auto cache = ListingCache::instance().stats();
+    fmt::print(stderr, "listing cache: {} hits, {} misses ({} stale), {} evictions, {} listings, {} bytes\n",
+               cache.hits, cache.misses, cache.stale, cache.evictions, cache.listings, cache.bytes);
+    const auto sniffed = ContentSniffer::instance().stats();
+    if (sniffed.hits + sniffed.reads > 0) {
+        fmt::print(stderr, "content sniffer: {} hits, {} heads read, {} signatures\n",
+                   sniffed.hits, sniffed.reads, sniffed.signatures);
+    }
+}
+#endif
+
+static int run(const Options &options) {
+    const char terminator = options.isPrint0 ? '\0' : '\n';
+#ifdef __unix__
+    int output_fd = STDOUT_FILENO;
+    if (!options.output.empty()) {
+        output_fd = open(options.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (output_fd < 0) {
+            throw std::runtime_error("Failed to open output: " + options.output.string());
+        }
+    }
+    BufferedFdWriter writer(output_fd);
+    auto emit = [&](const fs::path &path) {
+        writer.write(path.native());
+        writer.put(terminator);
+    };
+#else
+    if (!options.script.empty()) {
+        throw std::runtime_error("Script replay is not supported on this platform");
+    }
+    std::ofstream output_file;
+    if (!options.output.empty()) {
+        output_file.open(options.output, std::ios::binary | std::ios::trunc);
+        if (!output_file) {
+            throw std::runtime_error("Failed to open output: " + options.output.string());
+        }
+    }
+    std::ostream &output = options.output.empty() ? std::cout : output_file;
+    auto emit = [&](const fs::path &path) { output << path.string() << terminator; };
+#endif
+
+    if (options.frecency) {
+        FileSelector::setFrecencyFile(*options.frecency);
+    } else if (!options.script.empty()) {
+        FileSelector::setFrecencyFile({}); // A replay should not change which directories :z prefers
+    }
+
+#ifdef __unix__
+    // Headless replay: the script is both the key source and the frame sink.
+    std::shared_ptr<ScriptDriver> driver;
+    if (!options.script.empty()) {
+        driver = std::make_shared<ScriptDriver>(ScriptDriver::load(options.script), std::make_shared<NullOutputSink>());
+    }
+    FileSelector selector = driver ? FileSelector(options.start, options.extensions, driver, driver)
+                                   : FileSelector(options.start, options.extensions);
+    constexpr int stdin_fd = STDIN_FILENO;
+#else
+    constexpr bool driver = false;
+    FileSelector selector(options.start, options.extensions);
+    constexpr int stdin_fd = 0; // The C runtime's stdin as well
+#endif
+    if (options.isStdin) {
+        selector.readCandidatesFrom(stdin_fd, options.inputSeparator);
+    }
+    if (!options.session.empty()) {
+        selector.resumeSession(options.session);
+    }
+    if (options.keymap) {
+        selector.setKeymap(*options.keymap);
+    } else if (driver) {
+        selector.setKeymap({}); // Scripts are written against the built-in bindings
+    }
+    if (options.isSingle) {
+        fs::path file = selector.selectSingleFile();
+        if (!file.empty()) {
+            emit(file);
+        }
+    } else if (options.upTo != 0 || options.exactly != 0) {
+        for (const auto &file : options.upTo != 0 ? selector.selectUpTo(options.upTo)
+                                                  : selector.selectExactly(options.exactly)) {
+            emit(file);
+        }
+    } else {
+        selector.selectMultipleFile(emit);
+    }
+#ifdef __unix__
+    writer.flush();
+    if (output_fd != STDOUT_FILENO) {
+        close(output_fd);
+    }
+
+    if (driver) {
+        printTimings(*driver);
+    }
+#else
+    output.flush();
+#endif
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
     try {
-        FileSelector selector("~", {"mindes", "txt"});
-        files = selector.selectMultipleFile();
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--help") {
+                fmt::print("{}", usage);
+                return 0;
+            }
+        }
+        options = parseArguments(argc, argv);
     } catch (const std::exception &e) {
-        fmt::print("Error: {}\n", e.what());
-        return 1;
+        fmt::print(stderr, "Error: {}\n\n{}", e.what(), usage);
+        return 2;
     }
 
-    fs::path file;
     try {
-        FileSelector singleSelector{"~", {}};
-        file = singleSelector.selectSingleFile();
+        return run(options);
     } catch (const std::exception &e) {
-        fmt::print("Error: {}\n", e.what());
+        fmt::print(stderr, "Error: {}\n", e.what());
         return 1;
     }
-
-    for (auto &f : files) {
-        fmt::print("{}\n", f.string());
-    }
-    fmt::print("Single File selection:\n{}\n", file.string());
-    return 0;
 }
@@ -0,0 +1,146 @@
+// AllocTracker.cpp
+#include "AllocTracker.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+namespace {
+std::array<std::atomic<uint64_t>, AllocTracker::SubsystemCount> allocation_counts{};
+std::array<std::atomic<int64_t>, AllocTracker::SubsystemCount> live_bytes{};
+thread_local AllocTracker::Subsystem current_subsystem = AllocTracker::Other;
+} // namespace
+
+const char *AllocTracker::name(Subsystem subsystem) {
+    constexpr const char *names[SubsystemCount] = {"other", "fs", "cmd", "render", "input"};
+    return names[subsystem];
+}
+
+uint64_t AllocTracker::allocationCount() {
+    uint64_t total = 0;
+    for (const auto &count : allocation_counts) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t AllocTracker::allocationCount(Subsystem subsystem) {
+    return allocation_counts[subsystem].load(std::memory_order_relaxed);
+}
+
+int64_t AllocTracker::liveBytes(Subsystem subsystem) {
+    return live_bytes[subsystem].load(std::memory_order_relaxed);
+}
+
+size_t AllocTracker::peakRssKb() {
+#ifdef __unix__
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<size_t>(usage.ru_maxrss); // Kilobytes on Linux
+    }
+#endif
+    return 0;
+}
+
+AllocTracker::Subsystem AllocTracker::current() {
+    return current_subsystem;
+}
+
+AllocTracker::Subsystem AllocTracker::exchangeCurrent(Subsystem subsystem) {
+    Subsystem previous = current_subsystem;
+    current_subsystem = subsystem;
+    return previous;
+}
+
+#ifdef FILESELECTOR_TRACK_ALLOC
+// Every block carries a header right below the returned pointer, so delete knows the size and
+// the subsystem to credit without any lookup.
+namespace {
+struct BlockHeader {
+    uint64_t size;
+    uint32_t subsystem;
+    uint32_t offset; // From the start of the underlying malloc block to the user pointer
+};
+static_assert(sizeof(BlockHeader) == 16);
+
+void *trackedAllocate(size_t size, size_t alignment) {
+    const size_t offset = alignment > sizeof(BlockHeader) ? alignment : sizeof(BlockHeader);
+    while (true) {
+        void *base = nullptr;
+        if (alignment > alignof(std::max_align_t)) {
+            // aligned_alloc needs the size to be a multiple of the alignment
+            size_t total = (offset + size + alignment - 1) / alignment * alignment;
+            base = std::aligned_alloc(alignment, total);
+        } else {
+            base = std::malloc(offset + size);
+        }
+        if (base) {
+            auto *user = static_cast<char *>(base) + offset;
+            const AllocTracker::Subsystem subsystem = AllocTracker::current();
+            new (user - sizeof(BlockHeader)) BlockHeader{size, static_cast<uint32_t>(subsystem), static_cast<uint32_t>(offset)};
+            allocation_counts[subsystem].fetch_add(1, std::memory_order_relaxed);
+            live_bytes[subsystem].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+            return user;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            return nullptr;
+        }
+        handler();
+    }
+}
+
+void trackedFree(void *ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    auto *user = static_cast<char *>(ptr);
+    const auto *header = reinterpret_cast<const BlockHeader *>(user - sizeof(BlockHeader));
+    live_bytes[header->subsystem].fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+    std::free(user - header->offset);
+}
+
+void *allocateOrThrow(size_t size, size_t alignment) {
+    void *ptr = trackedAllocate(size, alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+} // namespace
+
+void *operator new(size_t size) { return allocateOrThrow(size, 0); }
+void *operator new[](size_t size) { return allocateOrThrow(size, 0); }
+void *operator new(size_t size, std::align_val_t align) { return allocateOrThrow(size, static_cast<size_t>(align)); }
+void *operator new[](size_t size, std::align_val_t align) { return allocateOrThrow(size, static_cast<size_t>(align)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return trackedAllocate(size, 0);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return trackedAllocate(size, 0);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void *ptr) noexcept { trackedFree(ptr); }
+void operator delete(void *ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { trackedFree(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { trackedFree(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { trackedFree(ptr); }
+#endif // FILESELECTOR_TRACK_ALLOC
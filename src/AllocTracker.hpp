@@ -0,0 +1,59 @@
+// AllocTracker.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Heap accounting per subsystem, compiled in with -DENABLE_ALLOC_TRACKING=ON (which defines
+// FILESELECTOR_TRACK_ALLOC). The global operator new/delete are then replaced: every block is
+// charged to the subsystem of the innermost AllocScope on the allocating thread, and released
+// from it again on delete, whichever thread frees it.
+// Without the option AllocScope compiles to nothing and all counters stay zero.
+class AllocTracker {
+public:
+    enum Subsystem {
+        Other,
+        FileSystem,
+        Commands,
+        Render,
+        Input,
+        SubsystemCount
+    };
+
+    static constexpr bool isCompiledIn() {
+#ifdef FILESELECTOR_TRACK_ALLOC
+        return true;
+#else
+        return false;
+#endif
+    }
+    static const char *name(Subsystem subsystem);
+
+    // Allocations made so far by the whole process, and by one subsystem.
+    static uint64_t allocationCount();
+    static uint64_t allocationCount(Subsystem subsystem);
+    // Bytes currently allocated and not yet freed.
+    static int64_t liveBytes(Subsystem subsystem);
+    // Peak resident set size of the process, 0 where unknown.
+    static size_t peakRssKb();
+
+    static Subsystem current();
+    static Subsystem exchangeCurrent(Subsystem subsystem);
+};
+
+// Charges the allocations of the enclosing scope (on this thread) to one subsystem.
+class AllocScope {
+public:
+#ifdef FILESELECTOR_TRACK_ALLOC
+    explicit AllocScope(AllocTracker::Subsystem subsystem) : previous(AllocTracker::exchangeCurrent(subsystem)) {}
+    ~AllocScope() { AllocTracker::exchangeCurrent(previous); }
+#else
+    explicit AllocScope(AllocTracker::Subsystem) {}
+#endif
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+
+#ifdef FILESELECTOR_TRACK_ALLOC
+private:
+    AllocTracker::Subsystem previous;
+#endif
+};
@@ -0,0 +1,63 @@
+// BufferedFdWriter.cpp
+#ifdef __unix__
+#include "BufferedFdWriter.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+BufferedFdWriter::BufferedFdWriter(int fd, size_t capacity) : fd(fd), capacity(capacity) {
+    buffer.reserve(capacity);
+}
+
+BufferedFdWriter::~BufferedFdWriter() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void BufferedFdWriter::write(std::string_view bytes) {
+    if (buffer.size() + bytes.size() > capacity) {
+        flush();
+        if (bytes.size() >= capacity) {
+            writeAll(bytes.data(), bytes.size());
+            return;
+        }
+    }
+    buffer.append(bytes);
+}
+
+void BufferedFdWriter::put(char byte) {
+    if (buffer.size() == capacity) {
+        flush();
+    }
+    buffer.push_back(byte);
+}
+
+void BufferedFdWriter::flush() {
+    try {
+        writeAll(buffer.data(), buffer.size());
+    } catch (...) {
+        buffer.clear(); // Not retried by the destructor
+        throw;
+    }
+    buffer.clear();
+}
+
+void BufferedFdWriter::writeAll(const char *data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = ::write(fd, data + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write output: ") + std::strerror(errno));
+        }
+        written += static_cast<size_t>(result);
+    }
+}
+#endif // __unix__
@@ -0,0 +1,31 @@
+// BufferedFdWriter.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Collects small writes into one buffer and hands it to write(2) when full.
+// Throws std::runtime_error when the descriptor fails (e.g. the reading end of a pipe is gone).
+class BufferedFdWriter {
+public:
+    static constexpr size_t default_capacity = 64 * 1024;
+
+    explicit BufferedFdWriter(int fd, size_t capacity = default_capacity);
+    // Flushes what is left; errors at this point are dropped.
+    ~BufferedFdWriter();
+    BufferedFdWriter(const BufferedFdWriter &) = delete;
+    BufferedFdWriter &operator=(const BufferedFdWriter &) = delete;
+
+    void write(std::string_view bytes);
+    void put(char byte);
+    void flush();
+
+private:
+    int fd;
+    size_t capacity;
+    std::string buffer;
+
+    void writeAll(const char *data, size_t size);
+};
+#endif // __unix__
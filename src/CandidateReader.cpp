@@ -0,0 +1,114 @@
+// CandidateReader.cpp
+#ifdef __unix__
+#include "CandidateReader.hpp"
+#include "AllocTracker.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include <poll.h>
+#include <unistd.h>
+
+CandidateReader::CandidateReader(int fd, char separator)
+    : fd(fd), separator(separator), reader(&CandidateReader::readLoop, this) {}
+
+CandidateReader::~CandidateReader() {
+    isStopping.store(true);
+    reader.join(); // The reader polls, so it notices within one interval
+}
+
+void CandidateReader::setOnAppended(std::function<void()> callback) {
+    std::lock_guard lock(mutex);
+    onAppended = std::move(callback);
+}
+
+size_t CandidateReader::takeNew(std::vector<fs::directory_entry> &listing) {
+    std::lock_guard lock(mutex);
+    const size_t added = pending.size();
+    listing.insert(listing.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+    pending.clear();
+    pendingCount.store(0);
+    return added;
+}
+
+void CandidateReader::readLoop() {
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    constexpr size_t read_size = 64 * 1024;
+    std::vector<char> buffer(read_size);
+    std::vector<fs::directory_entry> batch;
+    pollfd input_poll{fd, POLLIN, 0};
+
+    while (!isStopping.load()) {
+        int ready = poll(&input_poll, 1, static_cast<int>(notify_interval.count()));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            break;
+        }
+        if (ready == 0) {
+            publish(batch, false); // Hand over what a slow producer has sent so far
+            continue;
+        }
+        ssize_t read_length = read(fd, buffer.data(), buffer.size());
+        if (read_length < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (read_length <= 0) {
+            break;
+        }
+
+        const char *data = buffer.data();
+        const char *end = data + read_length;
+        while (const char *found = static_cast<const char *>(std::memchr(data, separator, end - data))) {
+            if (partial.empty()) {
+                addRecord(std::string_view(data, found - data), batch);
+            } else {
+                partial.append(data, found);
+                addRecord(partial, batch);
+                partial.clear();
+            }
+            data = found + 1;
+        }
+        partial.append(data, end);
+        publish(batch, false);
+    }
+    if (!partial.empty()) {
+        addRecord(partial, batch);
+        partial.clear();
+    }
+    finished.store(true);
+    publish(batch, true);
+}
+
+void CandidateReader::addRecord(std::string_view record, std::vector<fs::directory_entry> &batch) {
+    if (!record.empty() && record.back() == '\r' && separator == '\n') {
+        record.remove_suffix(1);
+    }
+    if (record.empty()) {
+        return;
+    }
+    std::error_code ec;
+    fs::directory_entry entry(fs::path(record), ec);
+    if (!ec && entry.exists(ec)) {
+        batch.push_back(std::move(entry));
+        total.fetch_add(1);
+    }
+}
+
+void CandidateReader::publish(std::vector<fs::directory_entry> &batch, bool force) {
+    const auto now = std::chrono::steady_clock::now();
+    if (!force && (batch.empty() || now - lastNotify < notify_interval)) {
+        return;
+    }
+    lastNotify = now;
+    std::lock_guard lock(mutex);
+    pending.insert(pending.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    pendingCount.store(pending.size());
+    batch.clear();
+    if (onAppended) {
+        onAppended();
+    }
+}
+#endif // __unix__
@@ -0,0 +1,59 @@
+// CandidateReader.hpp
+#ifdef __unix__
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Reads a list of paths (one per separator-terminated record) from a descriptor on its own
+// thread, e.g. the output of find piped into stdin. Paths that do not exist are skipped.
+// The selector takes what has arrived so far with takeNew(), so the list can be browsed
+// while the producer is still running.
+class CandidateReader {
+public:
+    CandidateReader(int fd, char separator);
+    ~CandidateReader();
+    CandidateReader(const CandidateReader &) = delete;
+    CandidateReader &operator=(const CandidateReader &) = delete;
+
+    // Called on the reader thread when new candidates are ready, at most every notify_interval
+    // and once more at the end of the input. It runs under the reader's lock, so once
+    // setOnAppended({}) returns the previous callback is not running any more.
+    void setOnAppended(std::function<void()> callback);
+    // Moves the candidates that arrived since the last call to the end of listing.
+    // Returns how many were added.
+    size_t takeNew(std::vector<fs::directory_entry> &listing);
+    bool hasNew() const { return pendingCount.load() > 0; }
+    bool isFinished() const { return finished.load(); }
+    size_t count() const { return total.load(); }
+
+private:
+    static constexpr std::chrono::milliseconds notify_interval{50};
+
+    const int fd;
+    const char separator;
+    std::string partial; // Unterminated tail of the last read
+    std::chrono::steady_clock::time_point lastNotify{};
+    std::atomic<bool> isStopping{false};
+    std::atomic<bool> finished{false};
+    std::atomic<size_t> total{0};
+    std::atomic<size_t> pendingCount{0};
+
+    std::mutex mutex; // Guards pending and onAppended
+    std::vector<fs::directory_entry> pending;
+    std::function<void()> onAppended;
+    std::thread reader;
+
+    void readLoop();
+    void addRecord(std::string_view record, std::vector<fs::directory_entry> &batch);
+    void publish(std::vector<fs::directory_entry> &batch, bool force);
+};
+#endif // __unix__
@@ -0,0 +1,87 @@
+// CommandCompleter.cpp
+#ifdef __unix__
+#include "CommandCompleter.hpp"
+#include "CommandProcessor.hpp"
+#include "FileSeries.hpp"
+
+#include <algorithm>
+
+namespace {
+template <typename Words>
+void addWords(const Words &words, const std::string &prefix, const char *suffix,
+              LineEditor::Completion &completion) {
+    for (std::string_view word : words) {
+        if (word.substr(0, prefix.size()) == prefix) {
+            completion.candidates.push_back(std::string(word) + suffix);
+            ++completion.total;
+        }
+    }
+}
+} // namespace
+
+CommandCompleter::CommandCompleter(const FileSystemManager &fsManager) : fsManager(fsManager) {}
+
+FileSystemManager::ScanOptions CommandCompleter::listingOptions(bool showHidden) {
+    return FileSystemManager::ScanOptions{showHidden, {}, {"name"}};
+}
+
+LineEditor::Completion CommandCompleter::complete(const std::string &line, size_t cursor) const {
+    LineEditor::Completion completion;
+    const std::string typed = line.substr(0, cursor);
+    const size_t command_end = typed.find(' ');
+    if (command_end == std::string::npos) {
+        // The first word is a command, or the start of a path to jump to.
+        addWords(CommandProcessor::command_names, typed, " ", completion);
+        addPaths(typed, completion);
+        return completion;
+    }
+    const std::string command = typed.substr(0, command_end);
+    if (command == "sort") {
+        completion.start = typed.find_last_of(" ,") + 1;
+        addWords(FileSystemManager::sort_keys, typed.substr(completion.start), "", completion);
+    } else if (command == "select") {
+        std::vector<std::string> names;
+        for (const auto &series : fsManager.listSeries()) {
+            names.push_back(series->name());
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        completion.start = command_end + 1;
+        addWords(names, typed.substr(completion.start), "[", completion);
+    } else if (std::find(CommandProcessor::command_names.begin(), CommandProcessor::command_names.end(), command) ==
+               CommandProcessor::command_names.end()) {
+        addPaths(typed, completion); // The whole line is a path, spaces and all
+    }
+    return completion;
+}
+
+void CommandCompleter::addPaths(const std::string &word, LineEditor::Completion &completion) const {
+    const size_t slash = word.rfind('/');
+    const std::string directory_text = (slash == std::string::npos) ? std::string() : word.substr(0, slash + 1);
+    const std::string name_prefix = word.substr(directory_text.size());
+    fs::path directory = directory_text.empty() ? fsManager.getCurrentDirectory()
+                                                : FileSystemManager::expandTilde(directory_text);
+    if (directory.is_relative()) {
+        directory = fsManager.getCurrentDirectory() / directory;
+    }
+    std::error_code ec;
+    if (!fs::is_directory(directory, ec)) {
+        return;
+    }
+
+    using Entry = FileSystemManager::Entry;
+    const auto listing = FileSystemManager::loadListing(
+        directory, listingOptions(!name_prefix.empty() && name_prefix[0] == '.'));
+    const auto first = std::partition_point(listing->begin(), listing->end(), [&](const Entry &entry) {
+        return entry.path().filename().native() < name_prefix;
+    });
+    const auto last = std::partition_point(first, listing->end(), [&](const Entry &entry) {
+        return entry.path().filename().native().compare(0, name_prefix.size(), name_prefix) == 0;
+    });
+    completion.total += static_cast<size_t>(last - first);
+    for (auto it = first; it != last && completion.candidates.size() < max_candidates; ++it) {
+        completion.candidates.push_back(directory_text + it->path().filename().native() +
+                                        (it->is_directory(ec) ? "/" : ""));
+    }
+}
+#endif // __unix__
@@ -0,0 +1,28 @@
+// CommandCompleter.hpp
+#ifdef __unix__
+#pragma once
+#include "FileSystemManager.hpp"
+#include "LineEditor.hpp"
+
+#include <string>
+
+// Tab completion for the command line: command names, the keys of :sort, the series :select takes
+// and paths to jump to.
+// Paths are completed from listings sorted by name in the shared ListingCache, so the names with a
+// given prefix are found by binary search and only the first Tab in a directory scans it.
+class CommandCompleter {
+public:
+    static constexpr size_t max_candidates = 1000;
+
+    explicit CommandCompleter(const FileSystemManager &fsManager);
+
+    LineEditor::Completion complete(const std::string &line, size_t cursor) const;
+    // How the listings to complete from are scanned; hidden names are only offered for a '.' prefix.
+    static FileSystemManager::ScanOptions listingOptions(bool showHidden);
+
+private:
+    const FileSystemManager &fsManager;
+
+    void addPaths(const std::string &word, LineEditor::Completion &completion) const;
+};
+#endif // __unix__
@@ -1,131 +1,80 @@
 // CommandProcessor.cpp
 #ifdef __unix__
 #include "CommandProcessor.hpp"
-#include "KeyEnum.hpp"
+#include "FileSeries.hpp"
+#include "FrecencyDatabase.hpp"
+#include "TreeRows.hpp"
 #include <algorithm>
+#include <charconv>
 #include <filesystem>
 #include <iostream>
 #include <sstream>
 
+#include <fmt/core.h>
+
 // Assume a namespace alias for filesystem:
 namespace fs = std::filesystem;
 
-CommandProcessor::CommandProcessor(FileSystemManager &fsMgr, UIRenderer &renderer)
-    : fsManager(fsMgr), uiRenderer(renderer), cursor(0), quit(false) {}
+CommandProcessor::CommandProcessor(FileSystemManager &fsMgr)
+    : fsManager(fsMgr), cursor(0), quit(false),
+      selectedPaths(std::make_shared<std::set<fs::path>>()) {}
 
-void CommandProcessor::processImmediateInput(int key) {
+template <typename Policy>
+Result<void> CommandProcessor::processImmediateInput(int key, const Policy &policy) {
     // Immediate mode: navigation and selection commands.
-    switch (key) {
-    case KEY_ARROW_LEFT:
-    case 'h':
-    case 127: // Backspace
-        // Navigate to parent directory.
-        fsManager.navigateParent();
-        cursor = 0;
+    switch (keymap.find(key)) {
+    case Keymap::Action::Leave:
+        leaveRow();
         break;
-    case KEY_ARROW_RIGHT:
-    case 'l':
-    case ' ': {
-        const auto &entries = fsManager.getEntries();
-        if (cursor < entries.size()) {
-            const auto &entry = entries[cursor];
-            if (entry.is_directory()) {
-                fsManager.navigateTo(entry.path());
-                cursor = 0;
+    case Keymap::Action::Open:
+        if (cursor < fsManager.entryCount()) {
+            const auto &entry = fsManager.entryAt(cursor);
+            if (entry.is_directory() || fsManager.seriesAt(cursor)) {
+                openDirectoryAt(cursor);
             } else if (entry.is_regular_file()) {
                 // Toggle selection if a regular file.
-                toggleSelectionAtIndex(cursor, false);
+                toggleSelectionAtIndex(cursor, false, policy);
             }
         }
-    } break;
-    case KEY_ARROW_UP:
-    case 'k':
+        break;
+    case Keymap::Action::MoveUp:
         moveCursor(-1);
         break;
-    case KEY_ARROW_DOWN:
-    case 'j':
+    case Keymap::Action::MoveDown:
         moveCursor(1);
         break;
-    case 'q':
-    case '\n':
-    case '\r':
+    case Keymap::Action::Quit:
         quit = true;
         break;
-    case '!':
+    case Keymap::Action::ToggleHint:
         isShowHint = !isShowHint;
         break;
-    case '?':
-        uiRenderer.drawHelp(true);
+    case Keymap::Action::ShowHelp:
+        requestedPager = PagerView::Help;
         break;
-    case 'H':
+    case Keymap::Action::ToggleHidden:
         isShowHidden = !isShowHidden;
         break;
-    case 'S':
+    case Keymap::Action::ToggleSelected:
         isShowSelected = !isShowSelected;
         break;
-    default:
-        throw std::invalid_argument("Invalid Input");
+    case Keymap::Action::TogglePerfHud:
+        isShowPerfHud = !isShowPerfHud;
         break;
-    }
-}
-
-void CommandProcessor::processImmediateInputSingle(int key) {
-    // Immediate mode: navigation and selection commands.
-    switch (key) {
-    case KEY_ARROW_LEFT:
-    case 'h':
-    case 127: // Backspace
-        // Navigate to parent directory.
-        fsManager.navigateParent();
-        cursor = 0;
+    case Keymap::Action::ToggleTreeView:
+        cursor = fsManager.setTreeView(!fsManager.isTreeView(), cursor);
         break;
-    case KEY_ARROW_RIGHT:
-    case 'l':
-    case ' ': {
-        const auto &entries = fsManager.getEntries();
-        if (cursor < entries.size()) {
-            const auto &entry = entries[cursor];
-            if (entry.is_directory()) {
-                fsManager.navigateTo(entry.path());
-                cursor = 0;
-            } else if (entry.is_regular_file()) {
-                // Toggle selection if a regular file.
-                toggleSelectionAtIndexSingle(cursor);
-            }
-        }
-    } break;
-    case KEY_ARROW_UP:
-    case 'k':
-        moveCursor(-1);
-        break;
-    case KEY_ARROW_DOWN:
-    case 'j':
-        moveCursor(1);
-        break;
-    case 'q':
-    case '\n':
-    case '\r':
-        quit = true;
-        break;
-    case '!':
-        isShowHint = !isShowHint;
-        break;
-    case '?':
-        uiRenderer.drawHelp(true);
-        break;
-    case 'H':
-        isShowHidden = !isShowHidden;
-        break;
-    case 'S':
-        isShowSelected = !isShowSelected;
-        break;
-    default:
-        throw std::invalid_argument("Invalid Input");
+    case Keymap::Action::TogglePreview:
+        isShowPreview = !isShowPreview;
         break;
+    case Keymap::Action::None:
+        return Error{"Invalid Input"};
     }
+    return {};
 }
 
-void CommandProcessor::processCommandInput(const std::string &command) {
+template <typename Policy>
+void CommandProcessor::processCommandInput(const std::string &command, const Policy &policy) {
     std::stringstream command_stream{command};
     std::string command_token{};
     const auto trim_whitespace = [](const std::string &s) {
@@ -157,90 +106,142 @@ void CommandProcessor::processCommandInput(const std::string &command) {
         } else {
             fsManager.searchName = search_name;
         }
+    } else if (command_token == "stats") {
+        if (fsManager.isCandidateList()) {
+            throw std::invalid_argument("Statistics need a directory listing");
+        }
+        std::string scope;
+        command_stream >> scope;
+        if (scope != "all" && !scope.empty()) {
+            throw std::invalid_argument("Usage: :stats [all]");
+        }
+        fsManager.setDirectorySizes(true); // The counts come from the same walk
+        if (scope == "all") {
+            requestedPager = PagerView::Stats;
+        } else {
+            isShowStats = !isShowStats;
+        }
+    } else if (command_token == "sizes") {
+        if (fsManager.isCandidateList()) {
+            throw std::invalid_argument("Directory sizes need a directory listing");
+        }
+        fsManager.setDirectorySizes(!fsManager.isDirectorySizing());
+    } else if (command_token == "selected") {
+        requestedPager = PagerView::Selection;
+    } else if (command_token == "select") {
+        std::string pattern;
+        std::getline(command_stream, pattern);
+        selectSteps(trim_whitespace(pattern), policy);
+    } else if (command_token == "group") {
+        // Series rows are tree rows, so grouping turns the tree view on (and fails for candidate lists).
+        const bool is_grouping = !fsManager.isSeriesGrouping();
+        if (is_grouping) {
+            cursor = fsManager.setTreeView(true, cursor);
+        }
+        fsManager.setSeriesGrouping(is_grouping);
+        const size_t count = fsManager.entryCount();
+        cursor = count ? std::min(cursor, count - 1) : 0;
+    } else if (command_token == "z") {
+        // The best matches are tried in turn (a directory may be gone); the ones after the
+        // directory jumped to are loaded in the background, in case a refined :z picks one of them.
+        constexpr size_t jump_candidates = 4;
+        std::string fragment;
+        std::getline(command_stream, fragment);
+        fragment = trim_whitespace(fragment);
+        if (fragment.empty()) {
+            throw std::invalid_argument("Usage: :z <part of a visited directory>");
+        }
+        if (fsManager.isCandidateList()) {
+            throw std::invalid_argument("Jumping needs a directory listing");
+        }
+        auto matches = FrecencyDatabase::instance().query(fragment, jump_candidates);
+        auto jumped = std::find_if(matches.begin(), matches.end(),
+                                   [this](const fs::path &directory) { return fsManager.navigateTo(directory); });
+        if (jumped == matches.end()) {
+            throw std::invalid_argument("No visited directory matches: " + fragment);
+        }
+        cursor = 0;
+        fsManager.preloadListings(std::vector<fs::path>(std::next(jumped), matches.end()));
     } else if (command_token == "help") {
-        uiRenderer.drawHelp(true);
+        requestedPager = PagerView::Help;
     } else {
         // Assume a path jump command.
         fs::path newPath = FileSystemManager::expandTilde(command);
-        if (fs::is_directory(newPath)) {
-            fsManager.navigateTo(newPath);
+        if (fsManager.navigateTo(newPath)) {
             cursor = 0;
-        } else {
-            if (!command.empty()) {
-                const std::string error_message = "Unkown path or command: " + command;
-                throw std::invalid_argument(error_message);
-            }
+        } else if (!command.empty()) {
+            const std::string error_message = "Unkown path or command: " + command;
+            throw std::invalid_argument(error_message);
         }
     }
 }
 
-void CommandProcessor::processNumberInput(const std::string &command) {
+template <typename Policy>
+void CommandProcessor::processNumberInput(const std::string &command, const Policy &policy) {
     std::istringstream iss(command);
     std::string token;
-    bool is_multi_mode = (command.find(',') != std::string::npos) or
-                         (command.find(' ') != std::string::npos) or
-                         (command.find('-') != std::string::npos);
+    // A replacing selection keeps one file, so only its directories are opened by number.
+    bool is_range = !Policy::is_replacing && ((command.find(',') != std::string::npos) or
+                                              (command.find(' ') != std::string::npos) or
+                                              (command.find('-') != std::string::npos));
 
-    size_t entry_size = fsManager.getEntries().size();
+    size_t entry_size = fsManager.entryCount();
 
     while (std::getline(iss, token, ',')) {
         size_t dash_position = token.find('-');
 
         if (dash_position != std::string::npos) {
+            if constexpr (Policy::is_replacing) {
+                throw std::invalid_argument("Single file selection mode, please input one single number only");
+            }
             // range mode
             size_t start = std::stoi(token.substr(0, dash_position));
             size_t end = std::stoi(token.substr(dash_position + 1));
             for (int index = std::max(static_cast<size_t>(1), start); index <= std::min(end, entry_size); ++index) {
-                toggleSelectionAtIndex(index - 1, is_multi_mode);
+                toggleSelectionAtIndex(index - 1, is_range, policy);
             }
         } else {
             // single mode
             size_t index = std::stoi(token);
             if (index >= 1 && index <= entry_size) {
-                toggleSelectionAtIndex(index - 1, is_multi_mode);
+                toggleSelectionAtIndex(index - 1, is_range, policy);
             }
         }
     }
 }
 
-void CommandProcessor::processNumberInputSingle(const std::string &command) {
-    std::istringstream iss(command);
-    std::string token;
-    bool is_multi_mode{false}; // In single file selection mode
-
-    size_t entry_size = fsManager.getEntries().size();
-
-    while (std::getline(iss, token, ',')) {
-        size_t dash_position = token.find('-');
-
-        if (dash_position != std::string::npos) {
-            throw std::invalid_argument("Single file selection mode, please input one single number only");
-        } else {
-            // single mode
-            size_t index = std::stoi(token);
-            if (index >= 1 && index <= entry_size) {
-                toggleSelectionAtIndex(index - 1, is_multi_mode);
-            }
-        }
+template <typename Policy>
+void CommandProcessor::toggleSelectionAtIndex(size_t index, bool isRange, const Policy &policy) {
+    if (index >= fsManager.entryCount()) {
+        return;
     }
-}
-
-void CommandProcessor::toggleSelectionAtIndex(size_t index, bool is_multi_selection) {
-    const auto &entries = fsManager.getEntries();
-    if (index >= entries.size()) {
+    if (fsManager.seriesAt(index)) {
+        if (isRange) {
+            throw std::invalid_argument("Can't expand a series in range mode, use :select");
+        }
+        openDirectoryAt(index);
         return;
     }
-    const auto &entry = entries[index];
+    const auto &entry = fsManager.entryAt(index);
     fs::path canonical = fs::canonical(entry.path());
     // Toggle selection: if already selected, unselect it.
-    if (selectedMultiPaths.find(canonical) != selectedMultiPaths.end()) {
-        selectedMultiPaths.erase(canonical);
+    if (selectedPaths->find(canonical) != selectedPaths->end()) {
+        deselect(canonical);
     } else if (entry.is_regular_file()) {
-        selectedMultiPaths.insert(canonical);
+        // Only bounded policies check the size; for the others this is compiled out.
+        if constexpr (Policy::is_replacing) {
+            while (selectedPaths->size() >= policy.maximum()) {
+                deselect(*selectedPaths->begin());
+            }
+        } else if constexpr (Policy::is_bounded) {
+            if (selectedPaths->size() >= policy.maximum()) {
+                throw std::invalid_argument(fmt::format("At most {} files can be selected", policy.maximum()));
+            }
+        }
+        select(canonical);
     } else if (entry.is_directory()) {
-        if (!is_multi_selection) {
-            fsManager.navigateTo(entry.path());
-            cursor = 0;
+        if (!isRange) {
+            openDirectoryAt(index);
         } else {
             throw std::invalid_argument("Can't open a directory in range mode ");
         }
@@ -249,41 +250,142 @@ void CommandProcessor::toggleSelectionAtIndex(size_t index, bool is_multi_select
     }
 }
 
-void CommandProcessor::toggleSelectionAtIndexSingle(size_t index) {
-    const auto &entries = fsManager.getEntries();
-    if (index >= entries.size()) {
-        return;
+template <typename Policy>
+void CommandProcessor::selectSteps(const std::string &pattern, const Policy &policy) {
+    const std::string usage = "Usage: :select <series>[first:last:stride], e.g. :select phi_step[1000:50000:1000]";
+    const size_t open = pattern.find('[');
+    if (open == std::string::npos || open == 0 || pattern.back() != ']') {
+        throw std::invalid_argument(usage);
     }
-    const auto &entry = entries[index];
-    fs::path canonical = fs::canonical(entry.path());
-    // Toggle selection: only one file can be selected
+    std::string name = pattern.substr(0, open);
+    name.erase(name.find_last_not_of(" \t") + 1);
 
-    if (selectedSinglePath == canonical) {
-        selectedSinglePath.clear();
-    } else if (entry.is_regular_file()) {
-        selectedSinglePath = canonical;
+    // first, last and stride; each can be left out.
+    std::array<std::optional<uint64_t>, 3> bounds;
+    std::istringstream fields(pattern.substr(open + 1, pattern.size() - open - 2));
+    std::string field;
+    size_t field_count = 0;
+    while (std::getline(fields, field, ':')) {
+        if (field_count == bounds.size()) {
+            throw std::invalid_argument(usage);
+        }
+        field.erase(0, field.find_first_not_of(" \t"));
+        field.erase(field.find_last_not_of(" \t") + 1);
+        if (!field.empty()) {
+            uint64_t value = 0;
+            auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+            if (ec != std::errc() || end != field.data() + field.size()) {
+                throw std::invalid_argument(usage);
+            }
+            bounds[field_count] = value;
+        }
+        ++field_count;
+    }
+    if (bounds[2] && *bounds[2] == 0) {
+        throw std::invalid_argument("The stride of :select must be positive");
+    }
 
-    } else if (entry.is_directory()) {
-        fsManager.navigateTo(entry.path());
-        cursor = 0;
-    } else {
-        throw std::runtime_error("Invalid entry detected");
+    // The listing's directory is canonical, so only symbolic links need resolving.
+    std::vector<fs::path> picked;
+    bool has_series = false;
+    for (const auto &series : fsManager.listSeries()) {
+        if (series->name() != name && series->stem != name) {
+            continue;
+        }
+        has_series = true;
+        for (size_t position : series->select(bounds[0], bounds[1], bounds[2])) {
+            const auto &file = series->files[position];
+            std::error_code ec;
+            picked.push_back(file.is_symlink(ec) ? fs::canonical(file.path(), ec) : file.path());
+        }
+    }
+    if (!has_series) {
+        throw std::invalid_argument("No series called " + name);
+    }
+    if (picked.empty()) {
+        throw std::invalid_argument(fmt::format("No steps of {} in {}", name, pattern.substr(open)));
+    }
+
+    std::vector<fs::path> fresh;
+    std::copy_if(picked.begin(), picked.end(), std::back_inserter(fresh),
+                 [this](const fs::path &path) { return !selectedPaths->count(path); });
+    if constexpr (Policy::is_replacing) {
+        if (picked.size() > policy.maximum()) {
+            throw std::invalid_argument(fmt::format("{} steps match, only {} can be selected", picked.size(),
+                                                    policy.maximum()));
+        }
+        while (!fresh.empty() && selectedPaths->size() + fresh.size() > policy.maximum()) {
+            deselect(*selectedPaths->begin());
+        }
+    } else if constexpr (Policy::is_bounded) {
+        if (selectedPaths->size() + fresh.size() > policy.maximum()) {
+            throw std::invalid_argument(fmt::format("At most {} files can be selected, {} more match",
+                                                    policy.maximum(), fresh.size()));
+        }
+    }
+    for (const auto &path : fresh) {
+        select(path);
+    }
+}
+
+void CommandProcessor::select(const fs::path &path) {
+    mutableSelectedPaths().insert(path);
+    if (onSelectionChanged) {
+        onSelectionChanged(path, true);
+    }
+}
+
+void CommandProcessor::deselect(const fs::path &path) {
+    const fs::path deselected = path; // path may point into the set
+    mutableSelectedPaths().erase(deselected);
+    if (onSelectionChanged) {
+        onSelectionChanged(deselected, false);
     }
 }
 
 void CommandProcessor::moveCursor(int delta) {
-    size_t count = fsManager.getEntries().size();
+    size_t count = fsManager.entryCount();
     if (count == 0)
         return;
-    int newCursor = static_cast<int>(cursor) + delta;
-    // Simple wrap-around logic:
+    // Wrap-around logic, also valid for coalesced deltas spanning several rows:
+    long long signed_count = static_cast<long long>(count);
+    long long newCursor = (static_cast<long long>(cursor) + delta) % signed_count;
     if (newCursor < 0)
-        newCursor = count - 1;
-    else if (newCursor >= static_cast<int>(count))
-        newCursor = 0;
+        newCursor += signed_count;
     cursor = static_cast<size_t>(newCursor);
 }
 
+void CommandProcessor::openDirectoryAt(size_t index) {
+    // The tree view expands in place; the list view enters the directory.
+    if (fsManager.isTreeView()) {
+        fsManager.toggleExpanded(index);
+    } else if (fsManager.navigateTo(fsManager.entryAt(index).path())) {
+        cursor = 0;
+    }
+}
+
+void CommandProcessor::leaveRow() {
+    // In the tree view, first collapse the directory, then step out to the row of its parent.
+    if (fsManager.isExpanded(cursor)) {
+        fsManager.toggleExpanded(cursor);
+    } else if (size_t parent = fsManager.parentRow(cursor); parent != TreeRows::npos) {
+        cursor = parent;
+    } else if (fsManager.navigateParent()) {
+        cursor = 0;
+    }
+}
+
+int CommandProcessor::motionDelta(int key) const {
+    switch (keymap.find(key)) {
+    case Keymap::Action::MoveUp:
+        return -1;
+    case Keymap::Action::MoveDown:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 size_t CommandProcessor::getCursor() const {
     return cursor;
 }
@@ -292,12 +394,40 @@ bool CommandProcessor::shouldQuit() const {
     return quit;
 }
 
-const std::set<fs::path> &CommandProcessor::getSelectedMultiPaths() const {
-    return selectedMultiPaths;
+template <typename Policy>
+Result<void> CommandProcessor::checkFinish(const Policy &policy) {
+    const size_t count = selectedPaths->size();
+    if (count == 0 || count >= policy.minimum()) {
+        return {};
+    }
+    quit = false;
+    return Error{fmt::format("Select {} files to finish, {} so far (or none to cancel)", policy.minimum(), count)};
+}
+
+const std::set<fs::path> &CommandProcessor::getSelectedPaths() const {
+    return *selectedPaths;
+}
+
+std::shared_ptr<const std::set<fs::path>> CommandProcessor::shareSelectedPaths() const {
+    return selectedPaths;
+}
+
+void CommandProcessor::setOnSelectionChanged(std::function<void(const fs::path &, bool)> callback) {
+    onSelectionChanged = std::move(callback);
 }
 
-const fs::path &CommandProcessor::getSelectedSinglePath() const {
-    return selectedSinglePath;
+void CommandProcessor::restore(size_t cursor, std::set<fs::path> selection) {
+    const size_t count = fsManager.entryCount();
+    this->cursor = count ? std::min(cursor, count - 1) : 0;
+    selectedPaths = std::make_shared<std::set<fs::path>>(std::move(selection));
+}
+
+std::set<fs::path> &CommandProcessor::mutableSelectedPaths() {
+    // Only this thread creates new handles, so a count of one means nobody else can see the set.
+    if (selectedPaths.use_count() > 1) {
+        selectedPaths = std::make_shared<std::set<fs::path>>(*selectedPaths);
+    }
+    return *selectedPaths;
 }
 
 std::vector<std::string> CommandProcessor::split_multi_delim(const std::string &input, const std::string &delims) {
@@ -321,4 +451,18 @@ std::vector<std::string> CommandProcessor::split_multi_delim(const std::string &
 
     return result;
 }
+
+// The policies the selectors use (UnixFileSelectorUI).
+template void CommandProcessor::processCommandInput(const std::string &, const MultipleSelection &);
+template void CommandProcessor::processCommandInput(const std::string &, const SingleSelection &);
+template void CommandProcessor::processCommandInput(const std::string &, const BoundedSelection &);
+template Result<void> CommandProcessor::processImmediateInput(int, const MultipleSelection &);
+template Result<void> CommandProcessor::processImmediateInput(int, const SingleSelection &);
+template Result<void> CommandProcessor::processImmediateInput(int, const BoundedSelection &);
+template void CommandProcessor::processNumberInput(const std::string &, const MultipleSelection &);
+template void CommandProcessor::processNumberInput(const std::string &, const SingleSelection &);
+template void CommandProcessor::processNumberInput(const std::string &, const BoundedSelection &);
+template Result<void> CommandProcessor::checkFinish(const MultipleSelection &);
+template Result<void> CommandProcessor::checkFinish(const SingleSelection &);
+template Result<void> CommandProcessor::checkFinish(const BoundedSelection &);
 #endif // __unix__
\ No newline at end of file
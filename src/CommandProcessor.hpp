@@ -2,7 +2,12 @@
 #ifdef __unix__
 #pragma once
 #include "FileSystemManager.hpp"
-#include "UIRenderer.hpp"
+#include "Keymap.hpp"
+#include "Result.hpp"
+#include "SelectionPolicy.hpp"
+#include <array>
+#include <functional>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -10,52 +15,98 @@ namespace fs = std::filesystem;
 
 class CommandProcessor {
 public:
-    // Constructor: receives references to the filesystem manager and UI renderer.
-    CommandProcessor(FileSystemManager &fsMgr, UIRenderer &renderer);
-
-    // Process a keystroke that is not part of a colon command.
-    void processImmediateInput(int key);
-
-    void processImmediateInputSingle(int key);
-
-    // Process a full command string (that starts with a colon).
-    void processCommandInput(const std::string &command);
-
-    void processNumberInput(const std::string &command);
-
-    void processNumberInputSingle(const std::string &command);
-
-    // Toggle the selection state of the entry at the given index.
-    void toggleSelectionAtIndex(size_t index, bool is_multi_selection);
+    // The commands processCommandInput knows (besides q), for completion.
+    static constexpr std::array<std::string_view, 10> command_names{
+        "filter", "group", "help", "search", "select", "selected", "sizes", "sort", "stats", "z"};
+    // Views that are too long for the frame and are shown in the pager instead.
+    enum class PagerView {
+        None,
+        Help,
+        Selection,
+        Stats
+    };
+
+    // Constructor: receives a reference to the filesystem manager.
+    // The processor only updates state; drawing is left to whoever renders that state.
+    explicit CommandProcessor(FileSystemManager &fsMgr);
+
+    // Process a keystroke that is not part of a colon command, as bound by the keymap.
+    // A key without a binding is an error result; nothing is thrown for it.
+    // The selecting calls take the policy of the selection (SelectionPolicy.hpp) as a template
+    // argument; they are instantiated for each policy in CommandProcessor.cpp.
+    template <typename Policy>
+    Result<void> processImmediateInput(int key, const Policy &policy);
+
+    // Process a full command string (that starts with a colon); ":select" selects by the policy.
+    template <typename Policy>
+    void processCommandInput(const std::string &command, const Policy &policy);
+
+    // Toggle the entries numbered in command, e.g. "3", "1-5" or "1-3,5,7"; a replacing policy takes
+    // single numbers only.
+    template <typename Policy>
+    void processNumberInput(const std::string &command, const Policy &policy);
+
+    // Move the cursor up or down, wrapping around both ends of the list.
+    void moveCursor(int delta);
 
-    void toggleSelectionAtIndexSingle(size_t index);
+    // Cursor offset of a pure motion key (+1/-1), 0 for everything else.
+    // Consecutive motions can be summed and applied with a single moveCursor call.
+    int motionDelta(int key) const;
 
-    // Move the cursor up or down.
-    void moveCursor(int delta);
+    void setKeymap(const Keymap &keymap) { this->keymap = keymap; }
+    const Keymap &getKeymap() const { return keymap; }
 
     // Get current cursor position (index into the FileSystemManager entries).
     size_t getCursor() const;
 
     // Checks whether the quit command has been issued.
     bool shouldQuit() const;
-
-    // Access selected file path(s).
-    const std::set<fs::path> &getSelectedMultiPaths() const;
-    const fs::path &getSelectedSinglePath() const;
-
+    // Whether the selection can be finished: with no files (cancelled) or at least policy.minimum().
+    // Otherwise a pending quit is called off and the error says what is missing.
+    template <typename Policy>
+    Result<void> checkFinish(const Policy &policy);
+
+    // The selected files, canonical; a single selection holds at most one.
+    const std::set<fs::path> &getSelectedPaths() const;
+    // The set is copied on write, so a shared handle stays valid while selection goes on.
+    std::shared_ptr<const std::set<fs::path>> shareSelectedPaths() const;
+    // Called after a path joins or leaves the selection; pass {} to stop the calls.
+    void setOnSelectionChanged(std::function<void(const fs::path &, bool isSelected)> callback);
+    // Puts back the selection and cursor of an earlier session (the cursor is kept within the listing).
+    void restore(size_t cursor, std::set<fs::path> selection);
+
+    // Set by '?', ':help', ':selected' and ':stats all'; cleared by whoever opens the pager.
+    PagerView requestedPager{PagerView::None};
     bool isShowHint{false};
     bool isShowHidden{false};
     bool isShowSelected{true};
+    bool isShowPerfHud{false};
+    bool isShowStats{false}; // Toggled by ':stats'
+    bool isShowPreview{false};
 
 private:
     FileSystemManager &fsManager;
-    UIRenderer &uiRenderer;
+    Keymap keymap{Keymap::defaults()};
     size_t cursor;
     bool quit;
 
-    std::set<fs::path> selectedMultiPaths;
-    fs::path selectedSinglePath;
-
+    std::shared_ptr<std::set<fs::path>> selectedPaths;
+    std::function<void(const fs::path &, bool)> onSelectionChanged;
+
+    std::set<fs::path> &mutableSelectedPaths();
+    // Toggle the selection state of the entry at index. A directory is opened, unless it is part of a range.
+    template <typename Policy>
+    void toggleSelectionAtIndex(size_t index, bool isRange, const Policy &policy);
+    // ":select <series>[first:last:stride]": the files of the series whose steps are in the range,
+    // found by binary search over the steps (see FileSeries::select).
+    template <typename Policy>
+    void selectSteps(const std::string &pattern, const Policy &policy);
+    void select(const fs::path &path);
+    void deselect(const fs::path &path);
+    // Enters the directory at index, or expands/collapses it (or a series) in the tree view.
+    void openDirectoryAt(size_t index);
+    // The left key: collapse, go up one tree level, or go to the parent directory.
+    void leaveRow();
     std::vector<std::string> split_multi_delim(const std::string &input, const std::string &delims);
 };
 #endif // __unix__
\ No newline at end of file
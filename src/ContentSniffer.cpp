@@ -0,0 +1,174 @@
+// ContentSniffer.cpp
+#ifdef __unix__
+#include "ContentSniffer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+// A MInDes input deck is "Section.Key = value" lines (and # comments) under these top-level sections.
+constexpr std::array<std::string_view, 5> mindes_sections{"Solver", "Preprocess", "Postprocess", "ModelsManager",
+                                                          "Materials"};
+// Keys of those sections a head needs before it counts as a deck rather than a file that mentions one.
+constexpr size_t min_mindes_keys = 2;
+
+std::string_view trim(std::string_view text) {
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+bool isMInDesKey(std::string_view key) {
+    const size_t dot = key.find('.');
+    return dot != std::string_view::npos && dot + 1 < key.size() &&
+           std::find(mindes_sections.begin(), mindes_sections.end(), key.substr(0, dot)) != mindes_sections.end();
+}
+} // namespace
+
+ContentSniffer &ContentSniffer::instance() {
+    static ContentSniffer sniffer;
+    return sniffer;
+}
+
+std::optional<ContentSniffer::Kind> ContentSniffer::kindNamed(std::string_view name) {
+    for (size_t i = 1; i < kind_names.size(); ++i) {
+        if (kind_names[i] == name) {
+            return static_cast<Kind>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+ContentSniffer::Signature ContentSniffer::sniff(std::string_view head) {
+    Signature signature;
+    if (head.find('\0') != std::string_view::npos) {
+        return signature; // Binary
+    }
+    size_t mindes_keys = 0;
+    std::string_view nx, ny, nz;
+    while (!head.empty()) {
+        const size_t end = std::min(head.find('\n'), head.size());
+        std::string_view line = head.substr(0, end);
+        head.remove_prefix(std::min(end + 1, head.size()));
+
+        line = line.substr(0, line.find('#'));
+        const size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        const std::string_view key = trim(line.substr(0, equals));
+        if (!isMInDesKey(key)) {
+            continue;
+        }
+        ++mindes_keys;
+        const std::string_view value = trim(line.substr(equals + 1));
+        if (key == "Solver.Mesh.Nx") {
+            nx = value;
+        } else if (key == "Solver.Mesh.Ny") {
+            ny = value;
+        } else if (key == "Solver.Mesh.Nz") {
+            nz = value;
+        } else if (key == "Solver.Loop.end_step") {
+            signature.steps = value;
+        }
+    }
+    if (mindes_keys < min_mindes_keys) {
+        signature.steps.clear();
+        return signature;
+    }
+    signature.kind = Kind::MInDes;
+    for (std::string_view extent : {nx, ny, nz}) {
+        if (!extent.empty()) {
+            signature.mesh += signature.mesh.empty() ? "" : "x";
+            signature.mesh += extent;
+        }
+    }
+    return signature;
+}
+
+std::vector<ContentSniffer::SignaturePtr> ContentSniffer::classify(const std::vector<fs::path> &files) {
+    std::vector<SignaturePtr> results(files.size());
+    // Workers take the next file from a shared index, so a slow file holds up one worker only.
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            results[i] = classifyOne(files[i]);
+        }
+    };
+    const size_t worker_count = std::min(max_workers, files.size() / files_per_worker);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return results;
+}
+
+ContentSniffer::SignaturePtr ContentSniffer::classifyOne(const fs::path &file) {
+    // A hit costs a stat; only files not seen with their current mtime are opened.
+    struct stat status {};
+    if (::stat(file.c_str(), &status) != 0 || !S_ISREG(status.st_mode)) {
+        return nullptr;
+    }
+    if (auto cached = find(status)) {
+        ++hits;
+        return cached;
+    }
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::string head(head_bytes, '\0');
+    size_t length = 0;
+    while (length < head.size()) {
+        const ssize_t count = ::read(fd, head.data() + length, head.size() - length);
+        if (count <= 0) {
+            break;
+        }
+        length += static_cast<size_t>(count);
+    }
+    ::close(fd);
+    ++reads;
+    head.resize(length);
+    if (length == head_bytes) {
+        head.resize(head.rfind('\n') + 1); // The last line is cut off; none if there is no newline at all
+    }
+
+    auto signature = std::make_shared<const Signature>(sniff(head));
+    std::lock_guard lock(mutex);
+    if (signatures.size() >= max_signatures) {
+        signatures.clear();
+    }
+    signatures[Key{status.st_dev, status.st_ino}] =
+        Cached{status.st_mtim.tv_sec * 1'000'000'000 + status.st_mtim.tv_nsec, signature};
+    return signature;
+}
+
+ContentSniffer::SignaturePtr ContentSniffer::find(const struct stat &status) const {
+    std::lock_guard lock(mutex);
+    auto found = signatures.find(Key{status.st_dev, status.st_ino});
+    if (found == signatures.end() ||
+        found->second.modifiedTime != status.st_mtim.tv_sec * 1'000'000'000 + status.st_mtim.tv_nsec) {
+        return nullptr;
+    }
+    return found->second.signature;
+}
+
+void ContentSniffer::clear() {
+    std::lock_guard lock(mutex);
+    signatures.clear();
+}
+
+ContentSniffer::Stats ContentSniffer::stats() const {
+    std::lock_guard lock(mutex);
+    return Stats{hits.load(), reads.load(), signatures.size()};
+}
+#endif // __unix__
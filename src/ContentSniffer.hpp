@@ -0,0 +1,90 @@
+// ContentSniffer.hpp
+#ifdef __unix__
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+namespace fs = std::filesystem;
+
+// Tells what a file is from its first head_bytes rather than from its name, for ":filter kind:<kind>"
+// (a .txt can be an input deck, an .mindes a stray copy of anything). Batches are read in parallel,
+// and what a file turned out to be is cached by its (device, inode, mtime), so a directory is read
+// once and then costs a stat per file. Like the ListingCache, a file rewritten within the same
+// mtime tick is not read again.
+class ContentSniffer {
+public:
+    enum class Kind : uint8_t { Unknown, MInDes };
+    // Indexed by Kind; the names ":filter kind:" takes.
+    static constexpr std::array<std::string_view, 2> kind_names{"unknown", "mindes"};
+
+    // What was read from the head of a file: its kind, and header fields for the file list.
+    struct Signature {
+        Kind kind{Kind::Unknown};
+        std::string mesh;  // MInDes: Solver.Mesh Nx, Ny and Nz as "128x128x1", empty if not in the head
+        std::string steps; // MInDes: Solver.Loop.end_step
+    };
+    using SignaturePtr = std::shared_ptr<const Signature>;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t reads{0};
+        size_t signatures{0};
+    };
+
+    static constexpr size_t head_bytes = 4096;
+
+    static ContentSniffer &instance();
+    ContentSniffer(const ContentSniffer &) = delete;
+    ContentSniffer &operator=(const ContentSniffer &) = delete;
+
+    // The kind called name, or nullopt if there is none ("unknown" is not one to filter by).
+    static std::optional<Kind> kindNamed(std::string_view name);
+    // Signatures of files, in order; null for files that cannot be read. Uncached files are read on
+    // up to max_workers threads.
+    std::vector<SignaturePtr> classify(const std::vector<fs::path> &files);
+    // The cached signature of the file stat'ed as status, without reading it (null if not cached).
+    SignaturePtr find(const struct stat &status) const;
+    // Recognises a file from its head.
+    static Signature sniff(std::string_view head);
+    void clear();
+    Stats stats() const;
+
+private:
+    static constexpr size_t max_workers = 8;
+    static constexpr size_t files_per_worker = 64; // Smaller batches are not worth a thread
+    // Signatures beyond this are dropped all at once rather than tracked for LRU order.
+    static constexpr size_t max_signatures = 200'000;
+
+    struct Key {
+        dev_t device;
+        ino_t inode;
+        bool operator==(const Key &) const = default;
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const { return std::hash<uint64_t>()(key.inode * 31 + key.device); }
+    };
+    struct Cached {
+        int64_t modifiedTime; // Nanoseconds
+        SignaturePtr signature;
+    };
+
+    ContentSniffer() = default;
+    SignaturePtr classifyOne(const fs::path &file);
+
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Cached, KeyHash> signatures;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> reads{0};
+};
+#endif // __unix__
@@ -0,0 +1,105 @@
+// DeadlineExecutor.cpp
+#ifdef __unix__
+#include "DeadlineExecutor.hpp"
+#include "AllocTracker.hpp"
+
+#include <exception>
+#include <thread>
+
+struct DeadlineExecutor::Task {
+    std::function<void()> operation;
+    std::condition_variable finished;
+    bool isFinished{false};
+    bool isOverdue{false};
+    std::exception_ptr error;
+};
+
+DeadlineExecutor &DeadlineExecutor::instance() {
+    // Never destroyed: its workers are detached, and one may be stuck in a syscall that never returns.
+    static DeadlineExecutor *executor = new DeadlineExecutor();
+    return *executor;
+}
+
+bool DeadlineExecutor::run(std::function<void()> operation, Clock::duration deadline) {
+    return runWatched(std::move(operation), deadline, nullptr);
+}
+
+bool DeadlineExecutor::run(std::function<void()> operation, Clock::duration deadline,
+                           const std::atomic<uint64_t> &progress) {
+    return runWatched(std::move(operation), deadline, &progress);
+}
+
+bool DeadlineExecutor::runWatched(std::function<void()> operation, Clock::duration deadline,
+                                  const std::atomic<uint64_t> *progress) {
+    auto task = std::make_shared<Task>();
+    task->operation = std::move(operation);
+
+    std::unique_lock lock(mutex);
+    ++counters.operations;
+    queue.push_back(task);
+    if (idleWorkers == 0 && workers < max_workers) {
+        ++workers;
+        std::thread(&DeadlineExecutor::workerLoop, this).detach();
+    } else {
+        workAvailable.notify_one();
+    }
+
+    uint64_t seen_progress = progress ? progress->load() : 0;
+    while (!task->finished.wait_for(lock, deadline, [&task] { return task->isFinished; })) {
+        if (progress && progress->load() != seen_progress) {
+            seen_progress = progress->load();
+            continue;
+        }
+        // Still queued or running: it finishes late, and callers may be waiting for its effects.
+        ++counters.timeouts;
+        task->isOverdue = true;
+        ++counters.overdue;
+        return false;
+    }
+    if (task->error) {
+        std::rethrow_exception(task->error);
+    }
+    return true;
+}
+
+bool DeadlineExecutor::isSlow() const {
+    std::lock_guard lock(mutex);
+    return counters.overdue > 0;
+}
+
+DeadlineExecutor::Stats DeadlineExecutor::stats() const {
+    std::lock_guard lock(mutex);
+    return counters;
+}
+
+void DeadlineExecutor::setOnRecovered(std::function<void()> callback) {
+    std::lock_guard lock(mutex);
+    onRecovered = std::move(callback);
+}
+
+void DeadlineExecutor::workerLoop() {
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    std::unique_lock lock(mutex);
+    while (true) {
+        ++idleWorkers;
+        workAvailable.wait(lock, [this] { return !queue.empty(); });
+        --idleWorkers;
+        auto task = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        try {
+            task->operation();
+        } catch (...) {
+            task->error = std::current_exception();
+        }
+
+        lock.lock();
+        task->isFinished = true;
+        task->finished.notify_one();
+        if (task->isOverdue && --counters.overdue == 0 && onRecovered) {
+            onRecovered();
+        }
+    }
+}
+#endif // __unix__
@@ -0,0 +1,67 @@
+// DeadlineExecutor.hpp
+#ifdef __unix__
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Runs filesystem syscalls that the interactive threads would otherwise block on (listing and
+// stat'ing directories that may sit on a slow or hung mount) on worker threads, and waits for each
+// one only up to a deadline. An operation that misses its deadline goes on in the background, and
+// the filesystem counts as slow until it has finished. Workers are started as needed, up to
+// max_workers, so a few operations stuck in a hung mount do not hold up the others.
+class DeadlineExecutor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Metadata of the rows on screen, per frame; a directory listing, per scan.
+    static constexpr auto stat_deadline = std::chrono::milliseconds(150);
+    static constexpr auto scan_deadline = std::chrono::seconds(2);
+    static constexpr size_t max_workers = 8;
+
+    struct Stats {
+        uint64_t operations{0};
+        uint64_t timeouts{0};
+        size_t overdue{0}; // Timed out and still running
+    };
+
+    static DeadlineExecutor &instance();
+    DeadlineExecutor(const DeadlineExecutor &) = delete;
+    DeadlineExecutor &operator=(const DeadlineExecutor &) = delete;
+
+    // Runs operation on a worker and waits at most deadline for it. Returns false if it did not
+    // finish in time; its effects are then the operation's own business (write results through
+    // shared state). Exceptions thrown by an operation that finished in time are rethrown here.
+    bool run(std::function<void()> operation, Clock::duration deadline);
+    // As run, but deadline is how long progress may stand still rather than how long the whole
+    // operation may take: a scan of a huge directory that keeps advancing is not taken for a hung one.
+    bool run(std::function<void()> operation, Clock::duration deadline, const std::atomic<uint64_t> &progress);
+    // True while an operation that timed out is still queued or running.
+    bool isSlow() const;
+    Stats stats() const;
+    // Called on a worker thread when the last overdue operation finishes; pass {} to stop the calls.
+    void setOnRecovered(std::function<void()> callback);
+
+private:
+    struct Task;
+
+    DeadlineExecutor() = default;
+    ~DeadlineExecutor() = default;
+    bool runWatched(std::function<void()> operation, Clock::duration deadline, const std::atomic<uint64_t> *progress);
+    void workerLoop();
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::deque<std::shared_ptr<Task>> queue;
+    size_t workers{0};
+    size_t idleWorkers{0};
+    Stats counters{};
+    std::function<void()> onRecovered;
+};
+#endif // __unix__
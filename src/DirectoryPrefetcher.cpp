@@ -0,0 +1,153 @@
+// DirectoryPrefetcher.cpp
+#ifdef __unix__
+#include "DirectoryPrefetcher.hpp"
+#include "AllocTracker.hpp"
+#include "ListingCache.hpp"
+#include "Tracer.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <tuple>
+
+DirectoryPrefetcher::DirectoryPrefetcher(size_t maxConcurrentScans) {
+    for (size_t i = 0; i < std::max<size_t>(maxConcurrentScans, 1); ++i) {
+        std::thread(&DirectoryPrefetcher::workerLoop, state).detach();
+    }
+}
+
+DirectoryPrefetcher::~DirectoryPrefetcher() {
+    {
+        std::lock_guard lock(state->mutex);
+        state->isStopping = true;
+        state->onLoaded = {};
+    }
+    state->workAvailable.notify_all();
+}
+
+void DirectoryPrefetcher::prefetch(const std::vector<fs::path> &directories,
+                                   const FileSystemManager::ScanOptions &options) {
+    {
+        std::lock_guard lock(state->mutex);
+        state->wanted = directories;
+        state->wantedOptions = options;
+        state->queue.clear();
+        for (const auto &directory : directories) {
+            bool is_running = std::find(state->inFlight.begin(), state->inFlight.end(), directory) != state->inFlight.end();
+            if (!is_running && !ListingCache::instance().contains(directory, options)) {
+                state->queue.push_back(directory);
+            }
+        }
+    }
+    state->workAvailable.notify_all();
+}
+
+void DirectoryPrefetcher::load(const fs::path &directory, const FileSystemManager::ScanOptions &options) {
+    {
+        std::lock_guard lock(state->mutex);
+        // A prefetch of the same directory may be in flight, but it could still be cancelled.
+        state->loads.emplace_back(directory, options);
+    }
+    state->workAvailable.notify_one();
+}
+
+void DirectoryPrefetcher::setOnLoaded(std::function<void()> callback) {
+    std::lock_guard lock(state->mutex);
+    state->onLoaded = std::move(callback);
+}
+
+std::shared_ptr<const std::vector<fs::directory_entry>>
+DirectoryPrefetcher::takeUncached(const fs::path &directory, const FileSystemManager::ScanOptions &options) {
+    std::lock_guard lock(state->mutex);
+    auto found = state->findUncached(directory, options);
+    if (found == state->uncached.end()) {
+        return nullptr;
+    }
+    auto listing = std::move(found->listing);
+    state->uncached.erase(found);
+    return listing;
+}
+
+bool DirectoryPrefetcher::hasUncached(const fs::path &directory, const FileSystemManager::ScanOptions &options) const {
+    std::lock_guard lock(state->mutex);
+    return state->findUncached(directory, options) != state->uncached.end();
+}
+
+std::deque<DirectoryPrefetcher::Uncached>::iterator
+DirectoryPrefetcher::State::findUncached(const fs::path &directory, const FileSystemManager::ScanOptions &options) {
+    return std::find_if(uncached.begin(), uncached.end(), [&](const Uncached &kept) {
+        return kept.directory == directory && kept.options == options;
+    });
+}
+
+bool DirectoryPrefetcher::State::isWanted(const fs::path &directory, const FileSystemManager::ScanOptions &options) const {
+    return !isStopping && options == wantedOptions &&
+           std::find(wanted.begin(), wanted.end(), directory) != wanted.end();
+}
+
+void DirectoryPrefetcher::workerLoop(const std::shared_ptr<State> &state) {
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    State &shared = *state;
+    std::unique_lock lock(shared.mutex);
+    while (true) {
+        shared.workAvailable.wait(lock, [&shared] {
+            return shared.isStopping || !shared.queue.empty() || !shared.loads.empty();
+        });
+        if (shared.isStopping) {
+            return;
+        }
+        const bool is_load = !shared.loads.empty();
+        fs::path directory;
+        FileSystemManager::ScanOptions options;
+        if (is_load) {
+            std::tie(directory, options) = std::move(shared.loads.front());
+            shared.loads.pop_front();
+        } else {
+            directory = shared.queue.front();
+            shared.queue.pop_front();
+            options = shared.wantedOptions;
+        }
+        shared.inFlight.push_back(directory);
+        lock.unlock();
+
+        std::optional<std::vector<fs::directory_entry>> listing;
+        std::error_code ec;
+        const auto modified_time = fs::last_write_time(directory, ec);
+        if (ec) {
+            // Gone or unreadable: remembered, so whoever waits for the listing learns why it is not coming.
+            ListingCache::instance().insertFailure(directory, ec.message());
+        } else if (!(is_load && ListingCache::instance().contains(directory, options))) {
+            TraceSpan trace_span(Tracer::Prefetch);
+            try {
+                listing = FileSystemManager::scanDirectory(directory, options, [&] {
+                    std::lock_guard guard(shared.mutex);
+                    return is_load ? shared.isStopping : !shared.isWanted(directory, options);
+                });
+            } catch (const fs::filesystem_error &e) {
+                ListingCache::instance().insertFailure(directory, e.code().message());
+            }
+        }
+
+        std::shared_ptr<const std::vector<fs::directory_entry>> uncached;
+        if (listing) {
+            auto shared_listing = std::make_shared<const std::vector<fs::directory_entry>>(std::move(*listing));
+            if (!ListingCache::instance().insert(directory, options, modified_time, shared_listing) && is_load) {
+                uncached = std::move(shared_listing);
+            }
+        }
+        lock.lock();
+        shared.inFlight.erase(std::find(shared.inFlight.begin(), shared.inFlight.end(), directory));
+        if (uncached) {
+            if (auto kept = shared.findUncached(directory, options); kept != shared.uncached.end()) {
+                shared.uncached.erase(kept);
+            }
+            shared.uncached.push_back({directory, options, std::move(uncached)});
+            if (shared.uncached.size() > max_uncached_listings) {
+                shared.uncached.pop_front();
+            }
+        }
+        if (is_load && shared.onLoaded) {
+            shared.onLoaded();
+        }
+    }
+}
+#endif // __unix__
@@ -0,0 +1,72 @@
+// DirectoryPrefetcher.hpp
+#ifdef __unix__
+#pragma once
+#include "FileSystemManager.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Scans directories the user is likely to enter next on a few worker threads, into the ListingCache.
+// Each prefetch() call replaces the set of wanted directories: queued scans that are no longer
+// wanted are dropped and running ones are cancelled, so hovering over many directories in a
+// row costs at most one partial scan per worker. Scans asked for with load() are never cancelled
+// and go ahead of the prefetches; one whose listing is too big for the cache keeps that listing until
+// takeUncached collects it. Workers are detached and share the queues with the prefetcher, so
+// destroying it does not wait for a scan stuck in a hung mount.
+class DirectoryPrefetcher {
+public:
+    explicit DirectoryPrefetcher(size_t maxConcurrentScans = 2);
+    ~DirectoryPrefetcher();
+    DirectoryPrefetcher(const DirectoryPrefetcher &) = delete;
+    DirectoryPrefetcher &operator=(const DirectoryPrefetcher &) = delete;
+
+    // Directories already in the cache are skipped.
+    void prefetch(const std::vector<fs::path> &directories, const FileSystemManager::ScanOptions &options);
+    // Scans a directory that is needed, not just likely to be, and calls onLoaded once it is cached
+    // (or could not be listed, see ListingCache::findFailure).
+    void load(const fs::path &directory, const FileSystemManager::ScanOptions &options);
+    // A loaded listing the ListingCache had no room for, handed over once; nullptr if there is none.
+    std::shared_ptr<const std::vector<fs::directory_entry>> takeUncached(const fs::path &directory,
+                                                                         const FileSystemManager::ScanOptions &options);
+    bool hasUncached(const fs::path &directory, const FileSystemManager::ScanOptions &options) const;
+    // Called on a worker thread, under the prefetcher's lock; pass {} to stop the calls.
+    void setOnLoaded(std::function<void()> callback);
+
+private:
+    // Only the latest few are kept, since each one is over the cache's whole budget.
+    static constexpr size_t max_uncached_listings = 2;
+
+    struct Uncached {
+        fs::path directory;
+        FileSystemManager::ScanOptions options;
+        std::shared_ptr<const std::vector<fs::directory_entry>> listing;
+    };
+    // Everything the workers use; a worker that outlives the prefetcher keeps it alive.
+    struct State {
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        bool isStopping{false};
+        FileSystemManager::ScanOptions wantedOptions{};
+        std::vector<fs::path> wanted{};
+        std::deque<fs::path> queue{};
+        std::deque<std::pair<fs::path, FileSystemManager::ScanOptions>> loads{};
+        std::function<void()> onLoaded;
+        std::vector<fs::path> inFlight{};
+        std::deque<Uncached> uncached{}; // Oldest first
+
+        bool isWanted(const fs::path &directory, const FileSystemManager::ScanOptions &options) const;
+        std::deque<Uncached>::iterator findUncached(const fs::path &directory,
+                                                    const FileSystemManager::ScanOptions &options);
+    };
+    std::shared_ptr<State> state{std::make_shared<State>()};
+
+    static void workerLoop(const std::shared_ptr<State> &state);
+};
+#endif // __unix__
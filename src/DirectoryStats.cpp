@@ -0,0 +1,257 @@
+// DirectoryStats.cpp
+#ifdef __unix__
+#include "DirectoryStats.hpp"
+#include "AllocTracker.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <sys/stat.h>
+
+struct DirectoryStats::Walk {
+    fs::path root;
+    // Of the root, set when the root is read (before any other directory of the walk is); other
+    // filesystems (e.g. /proc) are not entered.
+    std::optional<dev_t> device;
+    std::atomic<bool> isCancelled{false};
+};
+
+struct DirectoryStats::Node {
+    fs::path path;
+    std::shared_ptr<Node> parent;
+    std::shared_ptr<Walk> walk;
+    std::atomic<size_t> pending{1}; // This directory itself, plus every subdirectory not finished yet
+    std::mutex mutex;                // Guards sum, which finished subdirectories add to
+    Breakdown sum;
+};
+
+DirectoryStats &DirectoryStats::instance() {
+    // Never destroyed: its workers are detached, and one may be stuck in a syscall that never returns.
+    static DirectoryStats *stats = new DirectoryStats();
+    return *stats;
+}
+
+void DirectoryStats::request(const fs::path &directory) {
+    {
+        std::lock_guard lock(mutex);
+        if (currentWalk && !currentWalk->isCancelled.load() && currentWalk->root == directory) {
+            return;
+        }
+        if (workers == 0) {
+            workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+            for (size_t i = 0; i < workers; ++i) {
+                std::thread(&DirectoryStats::workerLoop, this).detach();
+            }
+        }
+        if (currentWalk) {
+            currentWalk->isCancelled.store(true);
+        }
+        stack.clear();
+        currentWalk = std::make_shared<Walk>();
+        currentWalk->root = directory;
+        auto root = std::make_shared<Node>();
+        root->path = directory;
+        root->walk = currentWalk;
+        stack.push_back(std::move(root));
+    }
+    workAvailable.notify_one();
+}
+
+void DirectoryStats::cancel() {
+    std::lock_guard lock(mutex);
+    if (currentWalk) {
+        currentWalk->isCancelled.store(true);
+    }
+    stack.clear();
+}
+
+std::optional<DirectoryStats::Totals> DirectoryStats::total(const fs::path &directory) const {
+    std::lock_guard lock(mutex);
+    if (auto found = totals.find(directory.native()); found != totals.end()) {
+        return found->second;
+    }
+    return std::nullopt;
+}
+
+std::shared_ptr<const DirectoryStats::Breakdown> DirectoryStats::breakdown(const fs::path &directory) const {
+    std::lock_guard lock(mutex);
+    if (auto found = breakdowns.find(directory.native()); found != breakdowns.end()) {
+        return found->second;
+    }
+    return nullptr;
+}
+
+bool DirectoryStats::isWalking(const fs::path &directory) const {
+    std::lock_guard lock(mutex);
+    return currentWalk && !currentWalk->isCancelled.load() && currentWalk->root == directory;
+}
+
+void DirectoryStats::setOnUpdated(std::function<void()> callback) {
+    std::lock_guard lock(mutex);
+    onUpdated = std::move(callback);
+}
+
+void DirectoryStats::workerLoop() {
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    std::unique_lock lock(mutex);
+    while (true) {
+        workAvailable.wait(lock, [this] { return !stack.empty(); });
+        std::shared_ptr<Node> node = std::move(stack.back());
+        stack.pop_back();
+        lock.unlock();
+        process(node);
+        lock.lock();
+    }
+}
+
+void DirectoryStats::process(const std::shared_ptr<Node> &node) {
+    // A cancelled walk is dropped as it is; its finished records stay cached for the next one.
+    const auto directory_record = record(node->path, *node->walk);
+    if (!directory_record) {
+        return;
+    }
+    {
+        std::lock_guard lock(node->mutex);
+        node->sum.total.bytes += directory_record->files.total.bytes;
+        node->sum.total.files += directory_record->files.total.files;
+        for (const auto &[extension, totals] : directory_record->files.byExtension) {
+            node->sum.byExtension[extension].bytes += totals.bytes;
+            node->sum.byExtension[extension].files += totals.files;
+        }
+    }
+    if (!directory_record->subdirectories.empty()) {
+        node->pending.fetch_add(directory_record->subdirectories.size());
+        {
+            std::lock_guard lock(mutex);
+            if (node->walk->isCancelled.load()) {
+                return;
+            }
+            for (const auto &name : directory_record->subdirectories) {
+                auto child = std::make_shared<Node>();
+                child->path = node->path / name;
+                child->parent = node;
+                child->walk = node->walk;
+                stack.push_back(std::move(child));
+            }
+        }
+        workAvailable.notify_all();
+    }
+    finish(node);
+}
+
+void DirectoryStats::finish(std::shared_ptr<Node> node) {
+    while (node && node->pending.fetch_sub(1) == 1) {
+        if (node->walk->isCancelled.load()) {
+            return;
+        }
+        // Nothing else touches a finished node, so its sum can be read without its lock.
+        const bool is_root = !node->parent;
+        {
+            std::lock_guard lock(mutex);
+            totals[node->path.native()] = node->sum.total;
+            if (is_root) {
+                breakdowns[node->path.native()] = std::make_shared<const Breakdown>(std::move(node->sum));
+                if (currentWalk == node->walk) {
+                    currentWalk.reset();
+                }
+            }
+        }
+        if (is_root) {
+            notifyUpdated(true);
+            return;
+        }
+        {
+            std::lock_guard lock(node->parent->mutex);
+            auto &parent_sum = node->parent->sum;
+            parent_sum.total.bytes += node->sum.total.bytes;
+            parent_sum.total.files += node->sum.total.files;
+            for (const auto &[extension, totals] : node->sum.byExtension) {
+                parent_sum.byExtension[extension].bytes += totals.bytes;
+                parent_sum.byExtension[extension].files += totals.files;
+            }
+        }
+        notifyUpdated(false);
+        node = std::move(node->parent);
+    }
+}
+
+std::shared_ptr<const DirectoryStats::Record> DirectoryStats::record(const fs::path &directory, Walk &walk) {
+    // How many entries are enumerated between two looks at isCancelled.
+    constexpr size_t cancel_check_interval = 256;
+    const std::atomic<bool> &isCancelled = walk.isCancelled;
+
+    struct stat status {};
+    if (::lstat(directory.c_str(), &status) != 0) {
+        return std::make_shared<const Record>(); // Unreadable directories count as empty
+    }
+    if (!walk.device) {
+        walk.device = status.st_dev; // The root
+    } else if (status.st_dev != *walk.device) {
+        return std::make_shared<const Record>(); // So do mount points
+    }
+    const int64_t modified_time = static_cast<int64_t>(status.st_mtim.tv_sec) * 1'000'000'000 + status.st_mtim.tv_nsec;
+    std::error_code ec;
+    {
+        std::lock_guard lock(recordMutex);
+        if (auto found = records.find(directory.native());
+            found != records.end() && found->second->modifiedTime == modified_time) {
+            return found->second;
+        }
+    }
+
+    auto scanned = std::make_shared<Record>();
+    scanned->modifiedTime = modified_time;
+    size_t seen = 0;
+    for (fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (++seen % cancel_check_interval == 0 && isCancelled.load()) {
+            return nullptr;
+        }
+        // Symbolic links are neither followed nor counted, so every byte is counted once.
+        const auto status = it->symlink_status(ec);
+        if (ec) {
+            continue;
+        }
+        if (fs::is_directory(status)) {
+            scanned->subdirectories.push_back(it->path().filename().string());
+        } else if (fs::is_regular_file(status)) {
+            const uintmax_t size = it->file_size(ec);
+            if (ec) {
+                continue;
+            }
+            std::string extension = it->path().extension().string();
+            if (!extension.empty()) {
+                extension.erase(0, 1);
+            }
+            auto &by_extension = scanned->files.byExtension[extension];
+            by_extension.bytes += size;
+            by_extension.files += 1;
+            scanned->files.total.bytes += size;
+            scanned->files.total.files += 1;
+        }
+    }
+    if (isCancelled.load()) {
+        return nullptr;
+    }
+
+    std::lock_guard lock(recordMutex);
+    if (records.size() >= max_records) {
+        records.clear();
+    }
+    records[directory.native()] = scanned;
+    return scanned;
+}
+
+void DirectoryStats::notifyUpdated(bool force) {
+    std::lock_guard lock(mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (!force && now - lastNotify < notify_interval) {
+        return;
+    }
+    lastNotify = now;
+    updates.fetch_add(1);
+    if (onUpdated) {
+        onUpdated();
+    }
+}
+#endif // __unix__
@@ -0,0 +1,94 @@
+// DirectoryStats.hpp
+#ifdef __unix__
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Recursive byte and file totals of directories, computed in the background by a parallel walker.
+// A walk hands every directory of a subtree to a pool of workers; each directory is finished once
+// all of its subdirectories are, so totals appear bottom-up while the walk is still going.
+// Walks stay on the filesystem of the walked directory, like du -x.
+// What a directory holds itself (its files and subdirectory names) is cached by the directory's
+// mtime, so walking an unchanged tree again costs one stat per directory. Like the ListingCache,
+// this does not notice files that grow in place until their directory changes.
+class DirectoryStats {
+public:
+    struct Totals {
+        uint64_t bytes{0};
+        uint64_t files{0};
+    };
+    // Totals of a walked directory, split by file extension (without the dot, "" for none).
+    struct Breakdown {
+        Totals total;
+        std::map<std::string, Totals> byExtension;
+    };
+
+    static DirectoryStats &instance();
+    DirectoryStats(const DirectoryStats &) = delete;
+    DirectoryStats &operator=(const DirectoryStats &) = delete;
+
+    // Walks directory in the background. A running walk of another directory is cancelled.
+    void request(const fs::path &directory);
+    // Cancels the running walk, if any; totals already published are kept.
+    void cancel();
+    // The last known totals, possibly from an earlier walk; nothing while a directory is not walked yet.
+    std::optional<Totals> total(const fs::path &directory) const;
+    // Kept for walked directories only, not for every directory below them.
+    std::shared_ptr<const Breakdown> breakdown(const fs::path &directory) const;
+    bool isWalking(const fs::path &directory) const;
+    // Grows whenever new totals are published.
+    uint64_t generation() const { return updates.load(); }
+    // Called on a worker thread, under the walker's lock, at most every notify_interval and at the
+    // end of each walk; pass {} to stop the calls.
+    void setOnUpdated(std::function<void()> callback);
+
+private:
+    static constexpr std::chrono::milliseconds notify_interval{50};
+    // Directory records beyond this are dropped all at once rather than tracked for LRU order.
+    static constexpr size_t max_records = 500'000;
+
+    // What one directory holds directly.
+    struct Record {
+        int64_t modifiedTime{0}; // Nanoseconds
+        Breakdown files;
+        std::vector<std::string> subdirectories;
+    };
+    struct Walk;
+    struct Node;
+
+    DirectoryStats() = default;
+    ~DirectoryStats() = default;
+    void workerLoop();
+    void process(const std::shared_ptr<Node> &node);
+    // One less thing to wait for in node; finishes it, and then its parents, once nothing is left.
+    void finish(std::shared_ptr<Node> node);
+    std::shared_ptr<const Record> record(const fs::path &directory, Walk &walk);
+    void notifyUpdated(bool force);
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    size_t workers{0};
+    std::vector<std::shared_ptr<Node>> stack; // Depth first keeps the number of open directories small
+    std::shared_ptr<Walk> currentWalk;
+    std::unordered_map<std::string, Totals> totals;
+    std::unordered_map<std::string, std::shared_ptr<const Breakdown>> breakdowns;
+    std::chrono::steady_clock::time_point lastNotify{};
+    std::atomic<uint64_t> updates{0};
+    std::function<void()> onUpdated;
+
+    std::mutex recordMutex; // Guards records only, so lookups do not wait for the queue
+    std::unordered_map<std::string, std::shared_ptr<const Record>> records;
+};
+#endif // __unix__
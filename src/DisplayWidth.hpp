@@ -0,0 +1,27 @@
+// DisplayWidth.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Terminal column widths of UTF-8 text.
+// ASCII text, the common case for file names, is recognised 16 bytes at a time and takes one column
+// per byte. Other text is split into grapheme clusters (a character plus the combining marks,
+// variation selectors and zero-width-joined characters after it), whose widths come from East Asian
+// Width and combining-mark tables. Invalid UTF-8 takes one column per byte, like the replacement
+// character a terminal shows for it.
+class DisplayWidth {
+public:
+    static bool isAscii(std::string_view text);
+    static size_t of(std::string_view text);
+    // 0 for combining and format characters, 2 for wide and fullwidth ones, 1 otherwise.
+    static int codePointWidth(char32_t codePoint);
+
+    // text padded with spaces to exactly columns. Text that does not fit is cut after the last whole
+    // cluster that does and ends in an ellipsis.
+    static std::string fit(std::string_view text, size_t columns);
+    // Like fit, but keeps the end of text and puts the ellipsis in front (where paths differ).
+    static std::string fitTail(std::string_view text, size_t columns);
+};
+#endif // __unix__
@@ -0,0 +1,249 @@
+// FilePreviewer.cpp
+#ifdef __unix__
+#include "FilePreviewer.hpp"
+#include "AllocTracker.hpp"
+#include "Tracer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Files with a NUL byte this close to the start are shown as hex.
+constexpr size_t binary_sniff_bytes = 8 * 1024;
+constexpr size_t max_line_bytes = 256;
+constexpr size_t read_chunk_bytes = 16 * 1024;
+
+int64_t modifiedNs(const struct stat &status) {
+    return static_cast<int64_t>(status.st_mtim.tv_sec) * 1'000'000'000 + status.st_mtim.tv_nsec;
+}
+
+std::shared_ptr<const FilePreviewer::Preview> errorPreview(std::string message) {
+    auto preview = std::make_shared<FilePreviewer::Preview>();
+    preview->error = std::move(message);
+    return preview;
+}
+} // namespace
+
+FilePreviewer::FilePreviewer() {
+    std::thread([state = state] { state->readLoop(); }).detach();
+}
+
+FilePreviewer::~FilePreviewer() {
+    {
+        std::lock_guard lock(state->mutex);
+        state->isStopping = true;
+        state->onReady = {};
+        ++state->wantedSequence; // Stops a read in progress at its next page
+    }
+    state->workAvailable.notify_one();
+}
+
+void FilePreviewer::request(const fs::path &file) {
+    {
+        std::lock_guard lock(state->mutex);
+        if (file == state->wanted) {
+            // Asked again (every frame while the cursor rests on it): have the reader check that the
+            // file is unchanged, without cancelling a read of it in progress.
+            state->isRecheckWanted = true;
+        } else {
+            state->wanted = file;
+            ++state->wantedSequence;
+        }
+    }
+    state->workAvailable.notify_one();
+}
+
+std::shared_ptr<const FilePreviewer::Preview> FilePreviewer::find(const fs::path &file) const {
+    std::lock_guard lock(state->mutex);
+    if (auto found = state->index.find(file.native()); found != state->index.end()) {
+        return found->second->preview;
+    }
+    return nullptr;
+}
+
+void FilePreviewer::setOnReady(std::function<void()> callback) {
+    std::lock_guard lock(state->mutex);
+    state->onReady = std::move(callback);
+}
+
+void FilePreviewer::State::readLoop() {
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    std::unique_lock lock(mutex);
+    uint64_t done_sequence = 0;
+    while (true) {
+        workAvailable.wait(lock, [&] { return isStopping || isRecheckWanted || wantedSequence != done_sequence; });
+        if (isStopping) {
+            return;
+        }
+        const fs::path file = wanted;
+        const uint64_t sequence = wantedSequence;
+        done_sequence = sequence;
+        isRecheckWanted = false;
+        lock.unlock();
+
+        // The stat is the only syscall for files that are cached and unchanged.
+        struct stat status {};
+        const bool has_status = ::stat(file.c_str(), &status) == 0;
+        const int64_t modified_time = has_status ? modifiedNs(status) : 0;
+        bool is_cached = false;
+        {
+            std::lock_guard guard(mutex);
+            auto found = index.find(file.native());
+            // The size too: a file rewritten within one mtime tick usually changes length.
+            is_cached = found != index.end() && found->second->modifiedTime == modified_time &&
+                        found->second->preview->fileSize == static_cast<uint64_t>(has_status ? status.st_size : 0);
+            if (is_cached) {
+                lru.splice(lru.begin(), lru, found->second);
+            }
+        }
+        std::shared_ptr<const Preview> preview;
+        if (!is_cached) {
+            TraceSpan trace_span(Tracer::Preview);
+            if (!has_status) {
+                preview = errorPreview(std::strerror(errno));
+            } else if (!S_ISREG(status.st_mode)) {
+                preview = errorPreview("Not a regular file");
+            } else {
+                preview = readPreview(file, sequence);
+            }
+        }
+
+        lock.lock();
+        if (preview) {
+            insert(file.native(), modified_time, std::move(preview));
+            if (onReady) {
+                onReady();
+            }
+        }
+    }
+}
+
+std::shared_ptr<const FilePreviewer::Preview> FilePreviewer::State::readPreview(const fs::path &file,
+                                                                                uint64_t sequence) {
+    // O_NONBLOCK, in case the file was replaced by a FIFO since the stat.
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0) {
+        return errorPreview(std::strerror(errno));
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        const int error = errno;
+        ::close(fd);
+        return errorPreview(std::strerror(error));
+    }
+    if (!S_ISREG(status.st_mode)) {
+        ::close(fd);
+        return errorPreview("Not a regular file");
+    }
+
+    // Read rather than mapped: a file that shrinks meanwhile (a log being rewritten) just reads
+    // short, where touching a mapped page past its new end would raise SIGBUS. Chunk by chunk, so a
+    // slow disk holds up a superseded read by one chunk at most.
+    auto preview = std::make_shared<Preview>();
+    preview->fileSize = static_cast<uint64_t>(status.st_size);
+    std::string data(static_cast<size_t>(std::min<uint64_t>(preview->fileSize, max_preview_bytes)), '\0');
+    size_t length = 0;
+    while (length < data.size()) {
+        {
+            std::lock_guard lock(mutex);
+            if (sequence != wantedSequence) {
+                ::close(fd);
+                return nullptr;
+            }
+        }
+        const ssize_t count = ::pread(fd, data.data() + length, std::min(read_chunk_bytes, data.size() - length),
+                                      static_cast<off_t>(length));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        length += static_cast<size_t>(count);
+    }
+    ::close(fd);
+    preview->isTruncated = length < preview->fileSize;
+
+    preview->isBinary = std::memchr(data.data(), '\0', std::min(length, binary_sniff_bytes)) != nullptr;
+    if (preview->isBinary) {
+        describeBinary(*preview, reinterpret_cast<const unsigned char *>(data.data()), length);
+    } else {
+        describeText(*preview, data.data(), length);
+    }
+    return preview;
+}
+
+void FilePreviewer::describeText(Preview &preview, const char *data, size_t size) {
+    const char *end = data + size;
+    while (data < end) {
+        if (preview.lines.size() == max_text_lines) {
+            preview.isTruncated = true;
+            return;
+        }
+        const char *line_end = static_cast<const char *>(std::memchr(data, '\n', end - data));
+        if (!line_end) {
+            line_end = end;
+        }
+        std::string line;
+        for (const char *c = data; c < line_end && line.size() < max_line_bytes; ++c) {
+            if (*c == '\t') {
+                line += "    ";
+            } else if (*c == '\r') {
+                continue;
+            } else if (static_cast<unsigned char>(*c) < 0x20 || *c == 0x7f) {
+                line += '.'; // Control characters would move the terminal cursor
+            } else {
+                line += *c;
+            }
+        }
+        // Do not cut a UTF-8 sequence in half.
+        if (line.size() >= max_line_bytes) {
+            while (!line.empty() && (static_cast<unsigned char>(line.back()) & 0xC0) == 0x80) {
+                line.pop_back();
+            }
+            if (!line.empty() && static_cast<unsigned char>(line.back()) >= 0xC0) {
+                line.pop_back();
+            }
+        }
+        preview.lines.push_back(std::move(line));
+        data = line_end + 1;
+    }
+}
+
+void FilePreviewer::describeBinary(Preview &preview, const unsigned char *data, size_t size) {
+    constexpr size_t bytes_per_line = 16;
+    const size_t shown = std::min(size, hex_bytes);
+    for (size_t offset = 0; offset < shown; offset += bytes_per_line) {
+        std::string hex;
+        std::string text;
+        for (size_t i = offset; i < offset + bytes_per_line; ++i) {
+            if (i < shown) {
+                hex += fmt::format("{:02x} ", data[i]);
+                text += (data[i] >= 0x20 && data[i] < 0x7f) ? static_cast<char>(data[i]) : '.';
+            } else {
+                hex += "   ";
+            }
+        }
+        preview.lines.push_back(fmt::format("{:08x}  {} |{}|", offset, hex, text));
+    }
+}
+
+void FilePreviewer::State::insert(const std::string &path, int64_t modifiedTime, std::shared_ptr<const Preview> preview) {
+    if (auto found = index.find(path); found != index.end()) {
+        lru.erase(found->second);
+        index.erase(found);
+    }
+    lru.push_front(CacheEntry{path, modifiedTime, std::move(preview)});
+    index[path] = lru.begin();
+    if (lru.size() > max_cached_previews) {
+        index.erase(lru.back().path);
+        lru.pop_back();
+    }
+}
+#endif // __unix__
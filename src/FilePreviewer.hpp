@@ -0,0 +1,81 @@
+// FilePreviewer.hpp
+#ifdef __unix__
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Reads the start of files for the preview pane on a background thread.
+// At most max_preview_bytes of a file are read, so the size of the file does not matter. Only the
+// most recently requested file is wanted: a read of a file the cursor has left is cancelled between
+// pages. Previews are cached by path and mtime, least recently used first out. The reader thread is
+// detached and shares its state with the previewer, so destroying it does not wait for a read stuck
+// in a hung mount.
+class FilePreviewer {
+public:
+    static constexpr size_t max_preview_bytes = 64 * 1024;
+    static constexpr size_t max_text_lines = 200;
+    static constexpr size_t hex_bytes = 256;
+
+    struct Preview {
+        std::vector<std::string> lines; // Text lines, or a hex dump for binary files
+        bool isBinary{false};
+        bool isTruncated{false}; // Only the start of the file is shown
+        uint64_t fileSize{0};
+        std::string error;
+    };
+
+    FilePreviewer();
+    ~FilePreviewer();
+    FilePreviewer(const FilePreviewer &) = delete;
+    FilePreviewer &operator=(const FilePreviewer &) = delete;
+
+    // Makes file the one to preview, or has it checked for changes if it already is. Returns at once;
+    // the callback announces the result.
+    void request(const fs::path &file);
+    // The newest preview of file, possibly of an older version of it; null if there is none yet.
+    std::shared_ptr<const Preview> find(const fs::path &file) const;
+    // Called on the reader thread when a preview is ready, under the previewer's lock; pass {} to stop.
+    void setOnReady(std::function<void()> callback);
+
+private:
+    static constexpr size_t max_cached_previews = 64;
+
+    struct CacheEntry {
+        std::string path;
+        int64_t modifiedTime; // Nanoseconds
+        std::shared_ptr<const Preview> preview;
+    };
+
+    // Everything the reader thread uses; a reader that outlives the previewer keeps it alive.
+    struct State {
+        mutable std::mutex mutex;
+        std::condition_variable workAvailable;
+        bool isStopping{false};
+        fs::path wanted;
+        uint64_t wantedSequence{0}; // Bumped by every request, so a read can tell it is no longer wanted
+        bool isRecheckWanted{false}; // The wanted file was asked for again; its preview may be stale
+        std::list<CacheEntry> lru;  // Most recently used first
+        std::unordered_map<std::string, std::list<CacheEntry>::iterator> index;
+        std::function<void()> onReady;
+
+        void readLoop();
+        // Null when the request was replaced while reading.
+        std::shared_ptr<const Preview> readPreview(const fs::path &file, uint64_t sequence);
+        void insert(const std::string &path, int64_t modifiedTime, std::shared_ptr<const Preview> preview);
+    };
+    std::shared_ptr<State> state{std::make_shared<State>()};
+
+    static void describeText(Preview &preview, const char *data, size_t size);
+    static void describeBinary(Preview &preview, const unsigned char *data, size_t size);
+};
+#endif // __unix__
@@ -1,10 +1,15 @@
 #include "FileSelector.hpp"
 #include "IFileSelectorUI.hpp"
+#include "IInputSource.hpp"
+#include "IOutputSink.hpp"
 
 #include <filesystem>
+#include <stdexcept>
 namespace fs = std::filesystem;
 
 #ifdef __unix__
+#include "FrecencyDatabase.hpp"
+#include "ListingCache.hpp"
 #include "UnixFileSelectorUI.hpp"
 #elif defined(_WIN32)
 #include "WindowsFileSelectorUI.hpp"
@@ -12,9 +17,10 @@ namespace fs = std::filesystem;
 
 class FileSelector::Impl {
 public:
-    Impl(const fs::path &start, const std::vector<std::string> &exts) {
+    Impl(const fs::path &start, const std::vector<std::string> &exts,
+         std::shared_ptr<IInputSource> input, std::shared_ptr<IOutputSink> output) {
 #ifdef __unix__
-        ui = std::make_unique<UnixFileSelectorUI>(start, exts);
+        ui = std::make_unique<UnixFileSelectorUI>(start, exts, std::move(input), std::move(output));
 #elif defined(_WIN32)
         ui = std::make_unique<WindowsFileSelectorUI>(start, exts);
 #endif
@@ -26,13 +32,35 @@ public:
     fs::path selectSingleFile() {
         return ui->selectSingleFile();
     };
+    std::vector<fs::path> selectUpTo(size_t maxFiles) {
+        return ui->selectUpTo(maxFiles);
+    }
+    std::vector<fs::path> selectExactly(size_t count) {
+        return ui->selectExactly(count);
+    }
+    void selectMultipleFile(const std::function<void(const fs::path &)> &onSelected) {
+        ui->selectMultipleFile(onSelected);
+    }
+    void readCandidatesFrom(int fd, char separator) {
+        ui->readCandidatesFrom(fd, separator);
+    }
+    void resumeSession(const fs::path &stateFile) {
+        ui->resumeSession(stateFile);
+    }
+    void setKeymap(const fs::path &keymapFile) {
+        ui->setKeymap(keymapFile);
+    }
 
 private:
     std::unique_ptr<IFileSelectorUI> ui;
 };
 
 FileSelector::FileSelector(const fs::path &start, const std::vector<std::string> &exts)
-    : pImpl(std::make_unique<Impl>(start, exts)) {}
+    : pImpl(std::make_unique<Impl>(start, exts, nullptr, nullptr)) {}
+
+FileSelector::FileSelector(const fs::path &start, const std::vector<std::string> &exts,
+                           std::shared_ptr<IInputSource> input, std::shared_ptr<IOutputSink> output)
+    : pImpl(std::make_unique<Impl>(start, exts, std::move(input), std::move(output))) {}
 
 FileSelector::~FileSelector() = default;
 
@@ -42,3 +70,45 @@ std::vector<fs::path> FileSelector::selectMultipleFile() {
 fs::path FileSelector::selectSingleFile() {
     return pImpl->selectSingleFile();
 }
+std::vector<fs::path> FileSelector::selectUpTo(size_t maxFiles) {
+    if (maxFiles == 0) {
+        throw std::invalid_argument("selectUpTo needs at least one file");
+    }
+    return pImpl->selectUpTo(maxFiles);
+}
+std::vector<fs::path> FileSelector::selectExactly(size_t count) {
+    if (count == 0) {
+        throw std::invalid_argument("selectExactly needs at least one file");
+    }
+    return pImpl->selectExactly(count);
+}
+void FileSelector::selectMultipleFile(const std::function<void(const fs::path &)> &onSelected) {
+    pImpl->selectMultipleFile(onSelected);
+}
+void FileSelector::readCandidatesFrom(int fd, char separator) {
+    pImpl->readCandidatesFrom(fd, separator);
+}
+
+void FileSelector::resumeSession(const fs::path &stateFile) {
+    pImpl->resumeSession(stateFile);
+}
+
+void FileSelector::setKeymap(const fs::path &keymapFile) {
+    pImpl->setKeymap(keymapFile);
+}
+
+void FileSelector::setListingCacheBudget(size_t bytes) {
+#ifdef __unix__
+    ListingCache::instance().setByteBudget(bytes);
+#else
+    (void)bytes;
+#endif
+}
+
+void FileSelector::setFrecencyFile(const fs::path &file) {
+#ifdef __unix__
+    FrecencyDatabase::instance().setFile(file);
+#else
+    (void)file;
+#endif
+}
@@ -1,10 +1,14 @@
 #pragma once
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 #include <filesystem>
 namespace fs = std::filesystem;
 
+class IInputSource;
+class IOutputSink;
+
 class FileSelector {
 public:
     FileSelector() = delete;
@@ -14,10 +18,42 @@ public:
     FileSelector(FileSelector &&) = delete;
 
     FileSelector(const fs::path &start, const std::vector<std::string> &exts);
+    // Run against an injected key source and frame sink instead of the terminal (Unix only),
+    // e.g. ScriptDriver for headless, reproducible runs.
+    FileSelector(const fs::path &start, const std::vector<std::string> &exts,
+                 std::shared_ptr<IInputSource> input, std::shared_ptr<IOutputSink> output);
     ~FileSelector();
 
     std::vector<fs::path> selectMultipleFile();
     fs::path selectSingleFile();
+    // Select at most maxFiles, or exactly count files (e.g. two files to diff); selecting past the
+    // bound is refused, and with selectExactly so is finishing with fewer (finishing with none
+    // cancels and returns an empty vector). Throw std::invalid_argument for 0. Unix only.
+    std::vector<fs::path> selectUpTo(size_t maxFiles);
+    std::vector<fs::path> selectExactly(size_t count);
+    // Streams the selection to onSelected, one path at a time, without building a vector.
+    void selectMultipleFile(const std::function<void(const fs::path &)> &onSelected);
+
+    // Offer the paths read from fd (one per separator-terminated record, e.g. the output of
+    // find) instead of browsing from start. The list can be used while it is still arriving.
+    void readCandidatesFrom(int fd, char separator = '\n');
+
+    // Opt-in: resume the session recorded in stateFile (directory, cursor, filter, sort, search,
+    // selection and command history) and keep recording into it, so the next selector can resume
+    // this one. The file is read here, so the select calls start from it. Unix only.
+    void resumeSession(const fs::path &stateFile);
+
+    // Bind keys as in keymapFile (format in Keymap.hpp) instead of the user's keymap,
+    // $XDG_CONFIG_HOME/FileSelector/keymap if it exists. An empty path keeps the built-in bindings.
+    // Throws std::invalid_argument if the file cannot be read or has a bad line. Unix only.
+    void setKeymap(const fs::path &keymapFile);
+
+    // Directory listings are cached across all selectors of the process; this bounds the cache
+    // (an estimate of the heap it holds). 0 disables caching.
+    static void setListingCacheBudget(size_t bytes);
+    // The directories entered are remembered for :z in this file (by default
+    // $XDG_DATA_HOME/FileSelector/frecency). An empty path keeps them in memory only.
+    static void setFrecencyFile(const fs::path &file);
 
 private:
     class Impl;
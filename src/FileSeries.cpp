@@ -0,0 +1,137 @@
+// FileSeries.cpp
+#ifdef __unix__
+#include "FileSeries.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+
+#include <fmt/core.h>
+
+namespace {
+// Steps longer than this do not fit a uint64_t; such names are left alone.
+constexpr size_t max_step_digits = 19;
+
+// Where the last run of digits in name starts and ends, or nothing if it has none.
+std::optional<std::pair<size_t, size_t>> lastDigitRun(std::string_view name) {
+    size_t end = name.size();
+    while (end > 0 && (name[end - 1] < '0' || name[end - 1] > '9')) {
+        --end;
+    }
+    if (end == 0) {
+        return std::nullopt;
+    }
+    size_t begin = end;
+    while (begin > 0 && name[begin - 1] >= '0' && name[begin - 1] <= '9') {
+        --begin;
+    }
+    return std::make_pair(begin, end);
+}
+} // namespace
+
+FileSeries::Grouping FileSeries::group(const std::vector<fs::directory_entry> &listing) {
+    struct Member {
+        size_t position;
+        uint64_t step;
+    };
+    struct Candidate {
+        std::string stem;
+        std::string suffix;
+        std::vector<Member> members;
+    };
+    std::vector<Candidate> candidates;
+    std::unordered_map<std::string, size_t> candidate_of; // By stem, NUL, suffix
+    for (size_t position = 0; position < listing.size(); ++position) {
+        std::error_code ec;
+        if (listing[position].is_directory(ec)) {
+            continue;
+        }
+        const std::string name = listing[position].path().filename().string();
+        const auto run = lastDigitRun(name);
+        if (!run || run->second - run->first > max_step_digits) {
+            continue;
+        }
+        const uint64_t step = std::stoull(name.substr(run->first, run->second - run->first));
+        std::string key = name.substr(0, run->first) + '\0' + name.substr(run->second);
+        auto [found, is_new] = candidate_of.try_emplace(std::move(key), candidates.size());
+        if (is_new) {
+            candidates.push_back({name.substr(0, run->first), name.substr(run->second), {}});
+        }
+        candidates[found->second].members.push_back({position, step});
+    }
+
+    Grouping grouping;
+    grouping.seriesOf.assign(listing.size(), npos);
+    for (auto &candidate : candidates) {
+        if (candidate.members.size() < min_files) {
+            continue;
+        }
+        std::stable_sort(candidate.members.begin(), candidate.members.end(),
+                         [](const Member &a, const Member &b) { return a.step < b.step; });
+        auto series = std::make_shared<FileSeries>();
+        series->stem = std::move(candidate.stem);
+        series->suffix = std::move(candidate.suffix);
+        series->steps.reserve(candidate.members.size());
+        series->files.reserve(candidate.members.size());
+        for (const auto &member : candidate.members) {
+            series->steps.push_back(member.step);
+            series->files.push_back(listing[member.position]);
+            grouping.seriesOf[member.position] = grouping.series.size();
+        }
+        grouping.series.push_back(std::move(series));
+    }
+    return grouping;
+}
+
+std::string FileSeries::name() const {
+    const size_t end = stem.find_last_not_of("_-. ");
+    return end == std::string::npos ? std::string() : stem.substr(0, end + 1);
+}
+
+std::string FileSeries::label() const {
+    // The numbers as written in the first and last file names, with their zero padding.
+    auto stepText = [this](const fs::directory_entry &file) {
+        const std::string name = file.path().filename().string();
+        return name.substr(stem.size(), name.size() - stem.size() - suffix.size());
+    };
+    return fmt::format("{}[{}..{}]{}", stem, stepText(files.front()), stepText(files.back()), suffix);
+}
+
+std::vector<size_t> FileSeries::select(std::optional<uint64_t> first, std::optional<uint64_t> last,
+                                       std::optional<uint64_t> stride) const {
+    const size_t begin = std::lower_bound(steps.begin(), steps.end(), first.value_or(0)) - steps.begin();
+    const size_t end = std::upper_bound(steps.begin(), steps.end(), last.value_or(UINT64_MAX)) - steps.begin();
+    std::vector<size_t> positions;
+    if (begin >= end) {
+        return positions;
+    }
+    if (!stride || *stride <= 1) {
+        positions.resize(end - begin);
+        std::iota(positions.begin(), positions.end(), begin);
+        return positions;
+    }
+    const uint64_t base = first.value_or(steps[begin]);
+    const uint64_t probes = (steps[end - 1] - base) / *stride + 1;
+    if (probes < end - begin) {
+        // Sparse: look each wanted step up, from where the last one was found.
+        size_t position = begin;
+        for (uint64_t step = base; position < end; step += *stride) {
+            position = std::lower_bound(steps.begin() + position, steps.begin() + end, step) - steps.begin();
+            for (; position < end && steps[position] == step; ++position) {
+                positions.push_back(position);
+            }
+            if (step > UINT64_MAX - *stride) {
+                break;
+            }
+        }
+    } else {
+        for (size_t position = begin; position < end; ++position) {
+            if ((steps[position] - base) % *stride == 0) {
+                positions.push_back(position);
+            }
+        }
+    }
+    return positions;
+}
+#endif // __unix__
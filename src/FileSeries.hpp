@@ -0,0 +1,42 @@
+// FileSeries.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Files of one directory that differ only in a number, <stem><step><suffix>, such as the outputs
+// of a run (phi_step_000100.vts ... phi_step_500000.vts). The tree view can show each series as one
+// row, and ":select phi_step[a:b:c]" picks files by step through the sorted steps instead of rows.
+struct FileSeries {
+    static constexpr size_t min_files = 3; // Fewer files with a common pattern stay as they are
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    std::string stem;   // "phi_step_"
+    std::string suffix; // ".vts"
+    std::vector<uint64_t> steps;            // Ascending
+    std::vector<fs::directory_entry> files; // In the order of steps
+
+    // The series of a listing, and for every entry the index of its series (npos for entries that
+    // are not part of one). Only the listing is looked at; sizes are left to whoever shows them.
+    struct Grouping {
+        std::vector<std::shared_ptr<const FileSeries>> series;
+        std::vector<size_t> seriesOf;
+    };
+    static Grouping group(const std::vector<fs::directory_entry> &listing);
+
+    // The stem without trailing separators ("phi_step"), the name ":select" takes.
+    std::string name() const;
+    // "phi_step_[000100..500000].vts"
+    std::string label() const;
+    // Positions in files of the steps from first to last (both included, open if not given) that
+    // are a multiple of stride past first (every step if not given).
+    std::vector<size_t> select(std::optional<uint64_t> first, std::optional<uint64_t> last,
+                               std::optional<uint64_t> stride) const;
+};
+#endif // __unix__
@@ -1,41 +1,474 @@
 // FileSystemManager.cpp
 #ifdef __unix__
 #include "FileSystemManager.hpp"
+#include "AllocTracker.hpp"
+#include "CandidateReader.hpp"
+#include "ContentSniffer.hpp"
+#include "DeadlineExecutor.hpp"
+#include "DirectoryPrefetcher.hpp"
+#include "DirectoryStats.hpp"
+#include "FileSeries.hpp"
+#include "FrecencyDatabase.hpp"
+#include "ListingCache.hpp"
+#include "Tracer.hpp"
+#include "TreeView.hpp"
 #include <cstdlib>
 #include <fmt/core.h>
 #include <iostream>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
+
+namespace {
+constexpr std::string_view kind_prefix = "kind:";
+
+bool isKindFilter(const std::string &filter) {
+    return filter.compare(0, kind_prefix.size(), kind_prefix) == 0;
+}
+
+// Collation keys are compared with memcmp (std::string::compare), so everything a sort key needs
+// to know about a name is worked into its bytes once, before sorting.
+
+// Each digit run becomes '0', a length byte and the digits without leading zeros: a longer number
+// sorts after a shorter one, numbers of one length sort by their digits. The name follows after a
+// NUL, so names that differ only in leading zeros still have a fixed order.
+std::string naturalCollationKey(const std::string &name) {
+    constexpr size_t max_counted_digits = 254; // Longer runs all sort as this long
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+
+    std::string key;
+    key.reserve(2 * name.size() + 1);
+    for (size_t i = 0; i < name.size();) {
+        if (!isDigit(name[i])) {
+            key += name[i++];
+            continue;
+        }
+        size_t run_end = i;
+        while (run_end < name.size() && isDigit(name[run_end])) {
+            ++run_end;
+        }
+        size_t first = i;
+        while (first < run_end && name[first] == '0') {
+            ++first;
+        }
+        key += '0';
+        key += static_cast<char>(std::min(run_end - first, max_counted_digits) + 1); // Never NUL
+        key.append(name, first, run_end - first);
+        i = run_end;
+    }
+    key += '\0';
+    key += name;
+    return key;
+}
+
+// ASCII letters folded to lower case, then the name itself to order names that differ only in case.
+std::string foldedCollationKey(const std::string &name) {
+    std::string key;
+    key.reserve(2 * name.size() + 1);
+    for (char c : name) {
+        key += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    key += '\0';
+    key += name;
+    return key;
+}
+} // namespace
 
 FileSystemManager::FileSystemManager(const fs::path &startDirectory,
                                      const std::vector<std::string> &filters)
     : currentDirectory(fs::canonical(expandTilde(startDirectory))),
       previousDirectory(currentDirectory), filters(filters) {}
 
+FileSystemManager::~FileSystemManager() = default;
+
+std::optional<std::vector<FileSystemManager::Entry>> FileSystemManager::scanDirectory(
+    const fs::path &directory, const ScanOptions &options, const std::function<bool()> &isCancelled,
+    std::atomic<uint64_t> *progress) {
+    // How many entries are enumerated between two looks at isCancelled.
+    constexpr size_t cancel_check_interval = 256;
+
+    std::vector<Entry> listing;
+    size_t seen = 0;
+    for (const auto &entry : fs::directory_iterator(directory)) {
+        if (progress) {
+            progress->fetch_add(1, std::memory_order_relaxed);
+        }
+        if (isCancelled && ++seen % cancel_check_interval == 0 && isCancelled()) {
+            return std::nullopt;
+        }
+        if (isListed(entry, options)) {
+            listing.push_back(entry);
+        }
+    }
+    keepKinds(listing, options.filters);
+    if (isCancelled && isCancelled()) {
+        return std::nullopt;
+    }
+    sortEntries(listing, options.sortPolicy, SortKeys::capture(listing, options.sortPolicy, progress), progress);
+    return listing;
+}
+
+bool FileSystemManager::isListed(const Entry &entry, const ScanOptions &options) {
+    std::string filename = entry.path().filename().string();
+    bool is_hidden = (!filename.empty() && filename[0] == '.');
+    std::error_code ec; // An entry that cannot be looked at is left out, not the whole listing
+    if (entry.is_directory(ec)) {
+        return options.showHidden || !is_hidden;
+    } else if (entry.is_regular_file(ec)) {
+        return matchesFilter(entry.path(), options.filters) && (options.showHidden || !is_hidden);
+    }
+    return false;
+}
+
 void FileSystemManager::refreshDirectory(bool is_show_hidden) {
+    TraceSpan trace_span(Tracer::RefreshDirectory);
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    isShowHidden = is_show_hidden;
+    if (candidateReader) {
+        refreshCandidates(is_show_hidden);
+        return;
+    }
     bool is_dir_changed = (previousDirectory != currentDirectory);
     if (is_dir_changed) {
         previousDirectory = currentDirectory;
     }
-    entries.clear();
-    try {
-        for (const auto &entry : fs::directory_iterator(currentDirectory)) {
-            std::string filename = entry.path().filename().string();
-            bool is_hidden = (!filename.empty() && filename[0] == '.');
-            bool include = false;
-            if (entry.is_directory()) {
-                include = is_show_hidden || !is_hidden;
-            } else if (entry.is_regular_file()) {
-                include = matchesFilter(entry.path()) && (is_show_hidden || !is_hidden);
-            }
-            if (include) {
-                entries.push_back(entry);
-            }
+    const ScanOptions options = scanOptions(is_show_hidden);
+    // Listings of unchanged directories come from the cache (filled by earlier scans and the prefetcher).
+    scannedEntries = loadCurrentListing(options);
+    listingProblem = lateScan ? "not responding" : ListingCache::instance().findFailure(currentDirectory).value_or("");
+    if (isSizingEnabled && sizedDirectory != currentDirectory) {
+        sizedDirectory = currentDirectory;
+        DirectoryStats::instance().request(currentDirectory);
+    }
+    seenSizeGeneration = DirectoryStats::instance().generation();
+    sortBySizeTotals();
+    search();
+    if (treeView) {
+        treeView->update(entries, options);
+    }
+}
+
+void FileSystemManager::sortBySizeTotals() {
+    // Directory totals arrive after the listing was sorted, so it is sorted again as they do. The
+    // keys are read once per listing, on a worker under the scan deadline; a re-sort then only looks
+    // up the totals, and only runs when one of them changed.
+    if (std::find(sortPolicy.begin(), sortPolicy.end(), "size") == sortPolicy.end()) {
+        return;
+    }
+    bool is_sort_needed = false;
+    if (scannedEntries != sizeSortSource) {
+        sizeSortSource = scannedEntries;
+        sizeSorted = scannedEntries;
+        sizeSortKeys.reset();
+        auto keys = std::make_shared<SortKeys>();
+        auto progress = std::make_shared<std::atomic<uint64_t>>(0);
+        const bool is_captured = DeadlineExecutor::instance().run(
+            [keys, progress, listing = scannedEntries, policy = sortPolicy] {
+                *keys = SortKeys::capture(*listing, policy, progress.get());
+            },
+            DeadlineExecutor::scan_deadline, *progress);
+        if (is_captured) {
+            sizeSortKeys = std::move(keys); // Otherwise the listing keeps the order it was scanned in
+            is_sort_needed = true;
         }
-        sortEntries();
-        search();
-    } catch (...) {
-        // Optionally, log errors here.
+    } else if (sizeSortKeys && seenSizeGeneration != sizeSortGeneration) {
+        is_sort_needed = sizeSortKeys->updateTotals(*sizeSortSource);
+    }
+    sizeSortGeneration = seenSizeGeneration;
+    if (is_sort_needed) {
+        std::vector<Entry> listing = *sizeSortSource;
+        sortEntries(listing, sortPolicy, *sizeSortKeys);
+        sizeSorted = std::make_shared<const std::vector<Entry>>(std::move(listing));
+    }
+    scannedEntries = sizeSorted;
+}
+
+// One scan of a directory, shared with the DeadlineExecutor worker that runs it (which may finish late).
+struct FileSystemManager::Scan {
+    Scan(fs::path directory, ScanOptions options) : directory(std::move(directory)), options(std::move(options)) {}
+
+    const fs::path directory;
+    const ScanOptions options;
+    std::atomic<uint64_t> progress{0};
+    // The fields below are written by the worker before isFinished is set, and read only after.
+    std::atomic<bool> isFinished{false};
+    fs::file_time_type modifiedTime{};
+    std::shared_ptr<const std::vector<Entry>> listing; // Null if the directory could not be listed
+    bool isCached{false};
+};
+
+std::shared_ptr<const std::vector<FileSystemManager::Entry>> FileSystemManager::loadListing(
+    const fs::path &directory, const ScanOptions &options) {
+    if (ListingCache::instance().findFailure(directory)) {
+        return std::make_shared<const std::vector<Entry>>();
+    }
+    auto scan = std::make_shared<Scan>(directory, options);
+    if (!scanWithinDeadline(scan, nullptr) || !scan->listing) {
+        return std::make_shared<const std::vector<Entry>>();
+    }
+    return scan->listing;
+}
+
+bool FileSystemManager::scanWithinDeadline(const std::shared_ptr<Scan> &scan, std::shared_ptr<const Scan> previous) {
+    // The stat and the scan run on a worker, so a hung mount holds the caller up for scan_deadline
+    // at most, while a scan that keeps enumerating entries is waited for. A scan that finishes late
+    // still fills the cache for the next refresh.
+    const bool is_finished = DeadlineExecutor::instance().run(
+        [scan, previous] { runScan(*scan, previous.get()); }, DeadlineExecutor::scan_deadline, scan->progress);
+    if (!is_finished) {
+        ListingCache::instance().insertFailure(scan->directory, "not responding");
     }
+    return is_finished;
+}
+
+void FileSystemManager::runScan(Scan &scan, const Scan *previous) {
+    auto &cache = ListingCache::instance();
+    if (auto cached = cache.find(scan.directory, scan.options)) {
+        scan.listing = std::move(cached);
+        scan.isCached = true;
+        scan.isFinished.store(true, std::memory_order_release);
+        return;
+    }
+    std::error_code ec;
+    scan.modifiedTime = fs::last_write_time(scan.directory, ec);
+    if (!ec && previous && previous->modifiedTime == scan.modifiedTime) {
+        scan.listing = previous->listing; // Too big for the cache, and still current
+    } else {
+        try {
+            scan.listing = std::make_shared<const std::vector<Entry>>(
+                std::move(*scanDirectory(scan.directory, scan.options, {}, &scan.progress)));
+            scan.isCached = !ec && cache.insert(scan.directory, scan.options, scan.modifiedTime, scan.listing);
+        } catch (const fs::filesystem_error &e) {
+            cache.insertFailure(scan.directory, e.code().message());
+        }
+    }
+    // A listing too big for the cache is only there for the manager that started the scan; it
+    // clears the failure itself when it takes the listing.
+    if (scan.isCached) {
+        cache.eraseFailure(scan.directory);
+    }
+    scan.isFinished.store(true, std::memory_order_release);
+}
+
+std::shared_ptr<const std::vector<FileSystemManager::Entry>> FileSystemManager::loadCurrentListing(
+    const ScanOptions &options) {
+    auto empty = std::make_shared<const std::vector<Entry>>();
+    auto isCurrent = [&](const Scan &scan) { return scan.directory == currentDirectory && scan.options == options; };
+    if (lateScan && !isCurrent(*lateScan)) {
+        lateScan.reset(); // Left behind; it still fills the cache if it can
+    }
+    if (lateScan) {
+        if (!lateScan->isFinished.load(std::memory_order_acquire)) {
+            return empty; // Not scanned again while the first attempt is still going
+        }
+        const auto scan = std::move(lateScan);
+        if (!scan->listing) {
+            return empty;
+        }
+        ListingCache::instance().eraseFailure(currentDirectory);
+        uncachedScan = scan->isCached ? nullptr : scan;
+        return scan->listing;
+    }
+    if (uncachedScan && !isCurrent(*uncachedScan)) {
+        uncachedScan.reset();
+    }
+    if (ListingCache::instance().findFailure(currentDirectory)) {
+        return empty;
+    }
+
+    auto scan = std::make_shared<Scan>(currentDirectory, options);
+    if (!scanWithinDeadline(scan, uncachedScan)) {
+        lateScan = std::move(scan);
+        return empty;
+    }
+    uncachedScan = scan->isCached || !scan->listing ? nullptr : scan;
+    return scan->listing ? scan->listing : empty;
+}
+
+void FileSystemManager::refreshCandidates(bool is_show_hidden) {
+    const size_t added = candidateReader->takeNew(candidates);
+    const ScanOptions options = scanOptions(is_show_hidden);
+    // Refiltering is linear in the candidates, so it only runs when something changed.
+    if (added > 0 || candidateOptions != options) {
+        std::vector<Entry> listing;
+        listing.reserve(candidates.size());
+        std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(listing),
+                     [&options](const Entry &entry) { return isListed(entry, options); });
+        keepKinds(listing, options.filters);
+        scannedEntries = std::make_shared<const std::vector<Entry>>(std::move(listing));
+        candidateOptions = options;
+    }
+    search();
+}
+
+void FileSystemManager::readCandidates(int fd, char separator) {
+    candidateReader = std::make_unique<CandidateReader>(fd, separator);
+}
+
+bool FileSystemManager::hasNewCandidates() const {
+    return candidateReader && candidateReader->hasNew();
+}
+
+bool FileSystemManager::hasBackgroundChanges() const {
+    return hasNewCandidates() || (treeView && treeView->hasArrivals()) ||
+           (isSizingEnabled && DirectoryStats::instance().generation() != seenSizeGeneration) ||
+           (lateScan ? lateScan->isFinished.load(std::memory_order_acquire)
+                     : !listingProblem.empty() && !ListingCache::instance().findFailure(currentDirectory));
+}
+
+void FileSystemManager::setOnBackgroundChange(std::function<void()> callback) {
+    if (candidateReader) {
+        candidateReader->setOnAppended(callback);
+    }
+    if (prefetcher) {
+        prefetcher->setOnLoaded(callback);
+    }
+    DirectoryStats::instance().setOnUpdated(callback); // Sizes may be turned on later
+    DeadlineExecutor::instance().setOnRecovered(callback);
+}
+
+size_t FileSystemManager::entryCount() const {
+    return treeView ? treeView->rows().size() : entries->size();
+}
+
+const FileSystemManager::Entry &FileSystemManager::entryAt(size_t row) const {
+    return treeView ? treeView->rows()[row].entry : entries->at(row);
+}
+
+size_t FileSystemManager::setTreeView(bool enabled, size_t cursor) {
+    if (enabled == isTreeView()) {
+        return cursor;
+    }
+    if (candidateReader) {
+        throw std::invalid_argument("The tree view needs a directory listing");
+    }
+    if (enabled) {
+        // Everything starts collapsed, so the rows are the listing and the cursor stays put.
+        treeView = std::make_unique<TreeView>(
+            [this](const fs::path &directory, const ScanOptions &options) -> TreeView::Listing {
+                if (!prefetcher) {
+                    auto listing = loadListing(directory, options);
+                    return ListingCache::instance().findFailure(directory) ? nullptr : listing;
+                }
+                if (auto listing = prefetcher->takeUncached(directory, options)) {
+                    return listing;
+                }
+                prefetcher->load(directory, options);
+                return nullptr;
+            },
+            [this](const fs::path &directory, const ScanOptions &options) {
+                return prefetcher && prefetcher->hasUncached(directory, options);
+            });
+        treeView->setSeriesGrouping(isGroupingSeries);
+        treeView->update(entries, scanOptions(isShowHidden));
+        return cursor;
+    }
+    const auto &rows = treeView->rows();
+    fs::path top_level;
+    if (cursor < rows.size()) {
+        for (size_t parent = rows.parent(cursor); parent != TreeRows::npos; parent = rows.parent(cursor)) {
+            cursor = parent;
+        }
+        top_level = rows[cursor].entry.path();
+    }
+    treeView.reset();
+    auto found = std::find_if(entries->begin(), entries->end(), [&](const Entry &entry) { return entry.path() == top_level; });
+    return found == entries->end() ? 0 : static_cast<size_t>(found - entries->begin());
+}
+
+bool FileSystemManager::toggleExpanded(size_t row) {
+    return treeView && row < treeView->rows().size() && treeView->toggle(row);
+}
+
+bool FileSystemManager::isExpanded(size_t row) const {
+    return treeView && row < treeView->rows().size() && treeView->isExpanded(row);
+}
+
+size_t FileSystemManager::parentRow(size_t row) const {
+    if (!treeView || row >= treeView->rows().size()) {
+        return TreeRows::npos;
+    }
+    return treeView->rows().parent(row);
+}
+
+TreeRows FileSystemManager::shareTreeRows() const {
+    return treeView ? treeView->rows() : TreeRows();
+}
+
+void FileSystemManager::setSeriesGrouping(bool enabled) {
+    isGroupingSeries = enabled;
+    if (treeView) {
+        treeView->setSeriesGrouping(enabled);
+        treeView->update(entries, scanOptions(isShowHidden));
+    }
+}
+
+const FileSeries *FileSystemManager::seriesAt(size_t row) const {
+    return treeView && row < treeView->rows().size() ? treeView->rows()[row].series.get() : nullptr;
+}
+
+std::string FileSystemManager::getExpandProblem() const {
+    return treeView ? treeView->problem() : std::string();
+}
+
+std::vector<std::shared_ptr<const FileSeries>> FileSystemManager::listSeries() const {
+    // Grouping goes by names only, so it is cheap enough to redo per command.
+    return FileSeries::group(*scannedEntries).series;
+}
+
+std::string FileSystemManager::getLocationLabel() const {
+    if (!candidateReader) {
+        return currentDirectory.string();
+    }
+    return fmt::format("{} paths from input{}", candidateReader->count(),
+                       candidateReader->isFinished() ? "" : " (reading...)");
+}
+
+FileSystemManager::ScanOptions FileSystemManager::scanOptions(bool showHidden) const {
+    return ScanOptions{showHidden, filters, sortPolicy};
+}
+
+void FileSystemManager::enablePrefetch(size_t maxConcurrentScans) {
+    if (!prefetcher) {
+        prefetcher = std::make_unique<DirectoryPrefetcher>(maxConcurrentScans);
+    }
+}
+
+void FileSystemManager::setDirectorySizes(bool isEnabled) {
+    isSizingEnabled = isEnabled;
+    if (!isEnabled && !sizedDirectory.empty()) {
+        sizedDirectory.clear(); // So turning sizes on again walks the directory again
+        DirectoryStats::instance().cancel();
+    }
+}
+
+void FileSystemManager::preloadListings(const std::vector<fs::path> &directories) {
+    for (const auto &directory : directories) {
+        preloadListing(directory, scanOptions(isShowHidden));
+    }
+}
+
+void FileSystemManager::preloadListing(const fs::path &directory, const ScanOptions &options) {
+    if (prefetcher && !candidateReader) {
+        prefetcher->load(directory, options);
+    }
+}
+
+void FileSystemManager::prefetchNeighbours(size_t cursor) {
+    if (!prefetcher || candidateReader) {
+        return;
+    }
+    std::vector<fs::path> directories;
+    if (cursor < entryCount()) {
+        std::error_code ec;
+        if (entryAt(cursor).is_directory(ec)) {
+            directories.push_back(entryAt(cursor).path());
+        }
+    }
+    if (currentDirectory.has_relative_path()) {
+        directories.push_back(currentDirectory.parent_path());
+    }
+    prefetcher->prefetch(directories, scanOptions(isShowHidden));
 }
 
 void FileSystemManager::setSortPolicy(const std::string &policy) {
@@ -44,44 +477,130 @@ void FileSystemManager::setSortPolicy(const std::string &policy) {
 }
 
 void FileSystemManager::setFilters(const std::string &exts) {
-    filters.clear();
-    commandStringParser(filters, exts);
+    std::vector<std::string> parsed;
+    commandStringParser(parsed, exts);
+    for (const auto &filter : parsed) {
+        if (isKindFilter(filter) && !ContentSniffer::kindNamed(std::string_view(filter).substr(kind_prefix.size()))) {
+            throw std::invalid_argument(fmt::format("Unknown kind: {} (known: mindes)", filter.substr(kind_prefix.size())));
+        }
+    }
+    filters = std::move(parsed);
 }
 
 void FileSystemManager::search() {
+    TraceSpan trace_span(Tracer::Search);
+    AllocScope alloc_scope(AllocTracker::FileSystem);
     if (searchName.empty()) {
+        entries = scannedEntries;
+        searchedEntries.reset();
         return;
     }
+    // Every refresh searches again; an unchanged result keeps its identity, so the tree view (which
+    // rebuilds its rows for a new listing) does not start over on every key.
+    if (scannedEntries == searchedEntries && searchName == searchedName) {
+        return;
+    }
+    searchedEntries = scannedEntries;
+    searchedName = searchName;
     std::vector<Entry> search_results;
-    for (const auto &entry : entries) {
-        std::string entry_filename = entry.path().filename().string();
+    for (const auto &entry : *scannedEntries) {
+        // Candidates come from all over the place, so their whole path is searched.
+        std::string entry_filename = candidateReader ? entry.path().string() : entry.path().filename().string();
         std::string lowered = entry_filename;
         std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
         if (lowered.find(searchName) != std::string::npos) {
             search_results.push_back(entry);
         }
     }
-    entries = search_results;
+    entries = std::make_shared<const std::vector<Entry>>(std::move(search_results));
 }
 
-void FileSystemManager::navigateParent() {
+bool FileSystemManager::navigateParent() {
+    if (candidateReader || !currentDirectory.has_relative_path()) {
+        return false;
+    }
     currentDirectory = currentDirectory.parent_path();
+    return true;
 }
 
-void FileSystemManager::navigateTo(const fs::path &newPath) {
-    if (fs::is_directory(newPath)) {
-        currentDirectory = fs::canonical(newPath);
+bool FileSystemManager::navigateTo(const fs::path &newPath) {
+    if (candidateReader) {
+        return false;
     }
+    // Resolved on a worker, so a path into a hung mount gives an error instead of a hang.
+    auto resolved = std::make_shared<fs::path>();
+    const bool is_finished = DeadlineExecutor::instance().run(
+        [newPath, resolved] {
+            std::error_code ec;
+            if (fs::is_directory(newPath, ec)) {
+                *resolved = fs::canonical(newPath, ec);
+            }
+        },
+        DeadlineExecutor::scan_deadline);
+    if (!is_finished) {
+        throw std::runtime_error(fmt::format("Not responding: {}", newPath.string()));
+    }
+    if (resolved->empty()) {
+        return false;
+    }
+    currentDirectory = *resolved;
+    FrecencyDatabase::instance().recordVisit(currentDirectory);
+    return true;
 }
 
 bool FileSystemManager::matchesFilter(const fs::path &p) const {
+    return matchesFilter(p, filters);
+}
+
+bool FileSystemManager::matchesFilter(const fs::path &p, const std::vector<std::string> &filters) {
     if (filters.empty())
         return true;
     std::string ext = p.extension().string();
     if (!ext.empty()) {
         ext = ext.substr(1);
     }
-    return std::find(filters.begin(), filters.end(), ext) != filters.end();
+    if (std::find(filters.begin(), filters.end(), ext) != filters.end()) {
+        return true;
+    }
+    return std::all_of(filters.begin(), filters.end(), isKindFilter); // No extension to match
+}
+
+void FileSystemManager::keepKinds(std::vector<Entry> &listing, const std::vector<std::string> &filters) {
+    std::vector<ContentSniffer::Kind> kinds;
+    for (const auto &filter : filters) {
+        if (isKindFilter(filter)) {
+            if (auto kind = ContentSniffer::kindNamed(std::string_view(filter).substr(kind_prefix.size()))) {
+                kinds.push_back(*kind);
+            }
+        }
+    }
+    if (kinds.empty()) {
+        return;
+    }
+    std::vector<size_t> file_positions;
+    std::vector<fs::path> files;
+    for (size_t i = 0; i < listing.size(); ++i) {
+        std::error_code ec;
+        if (!listing[i].is_directory(ec)) {
+            file_positions.push_back(i);
+            files.push_back(listing[i].path());
+        }
+    }
+    const auto signatures = ContentSniffer::instance().classify(files);
+    std::vector<bool> is_dropped(listing.size(), false);
+    for (size_t i = 0; i < files.size(); ++i) {
+        is_dropped[file_positions[i]] =
+            !signatures[i] || std::any_of(kinds.begin(), kinds.end(),
+                                          [&](ContentSniffer::Kind kind) { return signatures[i]->kind != kind; });
+    }
+    std::vector<Entry> kept;
+    kept.reserve(listing.size());
+    for (size_t i = 0; i < listing.size(); ++i) {
+        if (!is_dropped[i]) {
+            kept.push_back(std::move(listing[i]));
+        }
+    }
+    listing = std::move(kept);
 }
 
 void FileSystemManager::commandStringParser(std::vector<std::string> &vector, const std::string &str) {
@@ -97,55 +616,124 @@ void FileSystemManager::commandStringParser(std::vector<std::string> &vector, co
     }
 }
 
-void FileSystemManager::sortEntries() {
-    // Map of comparators.
-    Comparator cmpDirFirst = [](const Entry &a, const Entry &b) {
-        return a.is_directory() && !b.is_directory();
-    };
-    Comparator cmpName = [](const Entry &a, const Entry &b) {
-        return a.path().filename() < b.path().filename();
-    };
-    Comparator cmpTime = [](const Entry &a, const Entry &b) {
-        return fs::last_write_time(a.path()) > fs::last_write_time(b.path());
-    };
-    Comparator cmpExtension = [](const Entry &a, const Entry &b) {
-        return a.path().extension() < b.path().extension();
-    };
-    Comparator cmpSize = [](const Entry &a, const Entry &b) {
-        auto sizeA = fs::is_regular_file(a) ? fs::file_size(a) : 0;
-        auto sizeB = fs::is_regular_file(b) ? fs::file_size(b) : 0;
-        return sizeA < sizeB;
-    };
+void FileSystemManager::sortEntries(std::vector<Entry> &listing) {
+    sortEntries(listing, sortPolicy);
+}
+
+void FileSystemManager::sortEntries(std::vector<Entry> &listing, const std::vector<std::string> &sortPolicy) {
+    sortEntries(listing, sortPolicy, SortKeys::capture(listing, sortPolicy));
+}
+
+void FileSystemManager::sortEntries(std::vector<Entry> &listing, const std::vector<std::string> &sortPolicy,
+                                    const SortKeys &keys, std::atomic<uint64_t> *progress) {
+    // Comparisons counted locally between two updates of progress.
+    constexpr uint64_t progress_interval = 65536;
 
-    std::unordered_map<std::string, Comparator> comparatorMap = {
-        {"dir", cmpDirFirst},
-        {"name", cmpName},
-        {"time", cmpTime},
-        {"type", cmpExtension},
-        {"size", cmpSize}};
+    TraceSpan trace_span(Tracer::SortEntries);
+    AllocScope alloc_scope(AllocTracker::FileSystem);
+    auto compare = [](const auto &a, const auto &b) { return a < b ? -1 : b < a ? 1 : 0; };
 
-    std::vector<Comparator> sorters;
+    // Sort keys backed by a string per entry, built once here rather than in every comparison.
+    std::unordered_map<std::string, std::string (*)(const Entry &)> stringKeyMap = {
+        {"name", [](const Entry &entry) { return entry.path().filename().string(); }},
+        {"type", [](const Entry &entry) { return entry.path().extension().string(); }},
+        {"natural", [](const Entry &entry) { return naturalCollationKey(entry.path().filename().string()); }},
+        {"iname", [](const Entry &entry) { return foldedCollationKey(entry.path().filename().string()); }}};
+
+    // Positions are sorted instead of entries, so they index the key columns.
+    using PositionComparator = std::function<int(size_t, size_t)>;
+    std::vector<std::vector<std::string>> key_columns;
+    key_columns.reserve(sortPolicy.size()); // The comparators hold references into it
+    std::vector<PositionComparator> sorters;
     for (auto const &token : sortPolicy) {
-        if (auto it = comparatorMap.find(token); it != comparatorMap.end()) {
-            sorters.push_back(it->second);
+        if (token == "dir") {
+            sorters.push_back([&](size_t a, size_t b) { return compare(keys.isDirectory[b], keys.isDirectory[a]); });
+        } else if (token == "time") {
+            sorters.push_back([&](size_t a, size_t b) { return compare(keys.times[b], keys.times[a]); }); // Newest first
+        } else if (token == "size") {
+            sorters.push_back([&](size_t a, size_t b) { return compare(keys.sizes[a], keys.sizes[b]); });
+        } else if (auto key_it = stringKeyMap.find(token); key_it != stringKeyMap.end()) {
+            auto &column = key_columns.emplace_back();
+            column.reserve(listing.size());
+            for (const auto &entry : listing) {
+                column.push_back(key_it->second(entry));
+                if (progress) {
+                    progress->fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            sorters.push_back([&column](size_t a, size_t b) { return column[a].compare(column[b]); });
         } else {
             std::cerr << "Unknown sort key: " << token << std::endl;
         }
     }
-    auto finalComparator = combineComparators(sorters);
-    std::sort(entries.begin(), entries.end(), finalComparator);
+    std::vector<size_t> order(listing.size());
+    std::iota(order.begin(), order.end(), 0);
+    uint64_t comparisons = 0;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (progress && ++comparisons % progress_interval == 0) {
+            progress->fetch_add(1, std::memory_order_relaxed);
+        }
+        for (const auto &sorter : sorters) {
+            if (const int result = sorter(a, b)) {
+                return result < 0;
+            }
+        }
+        return false;
+    });
+    std::vector<Entry> sorted;
+    sorted.reserve(listing.size());
+    for (size_t position : order) {
+        sorted.push_back(std::move(listing[position]));
+    }
+    listing = std::move(sorted);
 }
 
-FileSystemManager::Comparator FileSystemManager::combineComparators(const std::vector<Comparator> &comps) {
-    return [=](const Entry &a, const Entry &b) {
-        for (const auto &comp : comps) {
-            if (comp(a, b))
-                return true;
-            if (comp(b, a))
-                return false;
+FileSystemManager::SortKeys FileSystemManager::SortKeys::capture(const std::vector<Entry> &listing,
+                                                                 const std::vector<std::string> &sortPolicy,
+                                                                 std::atomic<uint64_t> *progress) {
+    auto hasKey = [&](std::string_view key) { return std::find(sortPolicy.begin(), sortPolicy.end(), key) != sortPolicy.end(); };
+    const bool needs_sizes = hasKey("size");
+    const bool needs_times = hasKey("time");
+    SortKeys keys;
+    keys.isDirectory.reserve(listing.size());
+    keys.sizes.reserve(needs_sizes ? listing.size() : 0);
+    keys.times.reserve(needs_times ? listing.size() : 0);
+    for (const auto &entry : listing) {
+        // A file that went away since the scan sorts as empty and oldest rather than failing the sort.
+        std::error_code ec;
+        const bool is_directory = entry.is_directory(ec);
+        keys.isDirectory.push_back(is_directory);
+        if (needs_times) {
+            const auto time = entry.last_write_time(ec);
+            keys.times.push_back(ec ? fs::file_time_type::min() : time);
+        }
+        if (needs_sizes) {
+            const uintmax_t size = !is_directory && entry.is_regular_file(ec) ? entry.file_size(ec) : 0;
+            keys.sizes.push_back(ec ? 0 : size);
         }
+        if (progress) {
+            progress->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    keys.updateTotals(listing);
+    return keys;
+}
+
+bool FileSystemManager::SortKeys::updateTotals(const std::vector<Entry> &listing) {
+    if (sizes.empty()) {
         return false;
-    };
+    }
+    bool is_changed = false;
+    for (size_t i = 0; i < listing.size(); ++i) {
+        if (!isDirectory[i]) {
+            continue;
+        }
+        const auto total = DirectoryStats::instance().total(listing[i].path());
+        const uintmax_t size = total ? total->bytes : 0;
+        is_changed |= sizes[i] != size;
+        sizes[i] = size;
+    }
+    return is_changed;
 }
 
 fs::path FileSystemManager::expandTilde(const fs::path &path) {
@@ -2,34 +2,156 @@
 #ifdef __unix__
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <filesystem>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+class CandidateReader;
+class DirectoryPrefetcher;
+struct FileSeries;
+class TreeRows;
+class TreeView;
+
 class FileSystemManager {
 public:
     using Entry = fs::directory_entry;
-    using Comparator = std::function<bool(const Entry &, const Entry &)>;
+
+    // Everything that decides what a scan of one directory yields.
+    struct ScanOptions {
+        bool showHidden{false};
+        std::vector<std::string> filters;
+        std::vector<std::string> sortPolicy;
+        bool operator==(const ScanOptions &) const = default;
+    };
+
+    // The keys setSortPolicy understands.
+    static constexpr std::array<std::string_view, 7> sort_keys{"dir", "iname", "name", "natural",
+                                                               "size", "time", "type"};
 
     FileSystemManager(const fs::path &startDirectory,
                       const std::vector<std::string> &filters = {});
+    ~FileSystemManager();
+
+    // Enumerates, filters and sorts one directory; throws fs::filesystem_error if it cannot be read.
+    // isCancelled is polled during the scan; a cancelled scan returns nothing. progress, if given,
+    // counts the entries enumerated.
+    static std::optional<std::vector<Entry>> scanDirectory(const fs::path &directory, const ScanOptions &options,
+                                                           const std::function<bool()> &isCancelled = {},
+                                                           std::atomic<uint64_t> *progress = nullptr);
+    static bool isListed(const Entry &entry, const ScanOptions &options);
+    // What the sort keys backed by syscalls compare, read once per entry rather than in every
+    // comparison. Directories have their DirectoryStats totals as size.
+    struct SortKeys {
+        std::vector<uint8_t> isDirectory;
+        std::vector<uintmax_t> sizes;          // Only if the policy has "size"
+        std::vector<fs::file_time_type> times; // Only if the policy has "time"
+
+        // progress, if given, counts the entries done.
+        static SortKeys capture(const std::vector<Entry> &listing, const std::vector<std::string> &sortPolicy,
+                                std::atomic<uint64_t> *progress = nullptr);
+        // Takes the directory totals known now; true if a size changed.
+        bool updateTotals(const std::vector<Entry> &listing);
+    };
+    static void sortEntries(std::vector<Entry> &listing, const std::vector<std::string> &sortPolicy);
+    // With keys captured from listing in its current order; progress, if given, moves as it goes.
+    static void sortEntries(std::vector<Entry> &listing, const std::vector<std::string> &sortPolicy,
+                            const SortKeys &keys, std::atomic<uint64_t> *progress = nullptr);
+    // Extensions only; "kind:" filters are applied to whole listings by keepKinds.
+    static bool matchesFilter(const fs::path &p, const std::vector<std::string> &filters);
+    // Drops the files that are not of every kind in filters ("kind:mindes", see ContentSniffer);
+    // their heads are read in parallel. Directories stay.
+    static void keepKinds(std::vector<Entry> &listing, const std::vector<std::string> &filters);
+    // The cached listing of directory, scanned (and cached) first if needed. A scan may take as long
+    // as it keeps advancing; directories that cannot be read, or make no progress for
+    // DeadlineExecutor::scan_deadline, give an empty listing and go into the ListingCache's negative cache.
+    static std::shared_ptr<const std::vector<Entry>> loadListing(const fs::path &directory, const ScanOptions &options);
 
     void refreshDirectory(bool showHidden);
     void setSortPolicy(const std::string &policy);
+    // Extensions and "kind:<kind>" filters; throws std::invalid_argument for an unknown kind.
     void setFilters(const std::string &exts);
+    // Narrows the scanned listing down to names containing searchName (no rescan needed).
     void search();
+    // Sorts by the current sort policy.
+    void sortEntries(std::vector<Entry> &listing);
+    bool matchesFilter(const fs::path &p) const;
+    ScanOptions scanOptions(bool showHidden) const;
+
+    // Starts background scans of the directory under the cursor and of the parent, so that
+    // entering either one needs no scan. Scans of directories the cursor has left are cancelled.
+    void enablePrefetch(size_t maxConcurrentScans = 2);
+    void prefetchNeighbours(size_t cursor);
+    // Loads the listings of directories in the background (when prefetching is enabled); unlike the
+    // neighbours, they are not cancelled when the cursor moves.
+    void preloadListings(const std::vector<fs::path> &directories);
+    void preloadListing(const fs::path &directory, const ScanOptions &options);
+    // Walks the current directory in the background for recursive sizes (see DirectoryStats),
+    // again whenever the directory changes. Off by default: a walk reads the whole subtree.
+    void setDirectorySizes(bool isEnabled);
+    bool isDirectorySizing() const { return isSizingEnabled; }
 
-    const std::vector<Entry> &getEntries() const { return entries; }
+    const std::vector<Entry> &getEntries() const { return *entries; }
+    // The rows on screen: the listing, or the visible rows of the tree view.
+    size_t entryCount() const;
+    const Entry &entryAt(size_t row) const;
+    // Listings are immutable once published, so they can be handed to other threads as-is.
+    std::shared_ptr<const std::vector<Entry>> shareEntries() const { return entries; }
     fs::path getCurrentDirectory() const { return currentDirectory; }
+    // The directory, or the state of the candidate list, for the header.
+    std::string getLocationLabel() const;
+    // Why the current directory could not be listed (empty if it could).
+    const std::string &getListingProblem() const { return listingProblem; }
+    // The directory the tree view last failed to expand, and why (empty if none).
+    std::string getExpandProblem() const;
     const std::vector<std::string> &getFilters() const { return filters; }
-    void navigateParent();
-    void navigateTo(const fs::path &newPath);
+    const std::vector<std::string> &getSortPolicy() const { return sortPolicy; }
+    // Both return false when nothing changed (not a directory, or a candidate list).
+    // Directories entered with navigateTo are recorded for :z (see FrecencyDatabase); it throws
+    // std::runtime_error if the path does not answer within DeadlineExecutor::scan_deadline.
+    bool navigateParent();
+    bool navigateTo(const fs::path &newPath);
+
+    // Lists the paths read from fd (separator-terminated) instead of a directory, in input order.
+    // Candidates keep arriving in the background; refreshDirectory() picks up what is there.
+    void readCandidates(int fd, char separator);
+    bool isCandidateList() const { return candidateReader != nullptr; }
+    bool hasNewCandidates() const;
+
+    // Shows the listing as a tree whose directories expand in place. Not available for candidate lists.
+    // Returns the row that shows what the cursor was on (or its top-level directory when leaving).
+    size_t setTreeView(bool enabled, size_t cursor);
+    bool isTreeView() const { return treeView != nullptr; }
+    // Expands or collapses the directory on a tree row; false if the row is not a directory.
+    // Listings that are not cached load in the background when prefetching is enabled.
+    bool toggleExpanded(size_t row);
+    bool isExpanded(size_t row) const;
+    // The row of the directory that contains the tree row, npos for top-level rows.
+    size_t parentRow(size_t row) const;
+    TreeRows shareTreeRows() const;
+    // Shows the numbered files of each listing as one row per series in the tree view (see FileSeries).
+    void setSeriesGrouping(bool enabled);
+    bool isSeriesGrouping() const { return isGroupingSeries; }
+    // The series a tree row stands for, null if it is a file or directory.
+    const FileSeries *seriesAt(size_t row) const;
+    // The series of the current listing, whatever the view.
+    std::vector<std::shared_ptr<const FileSeries>> listSeries() const;
+
+    // True when something that arrived in the background (candidates, tree listings) awaits a refresh.
+    bool hasBackgroundChanges() const;
+    // Called from a background thread when such a change arrives; pass {} to stop the calls.
+    void setOnBackgroundChange(std::function<void()> callback);
 
     // Utility: expands tilde in paths.
     static fs::path expandTilde(const fs::path &path);
@@ -38,13 +160,45 @@ public:
 private:
     fs::path currentDirectory;
     fs::path previousDirectory;
-    std::vector<Entry> entries;
+    std::shared_ptr<const std::vector<Entry>> scannedEntries{std::make_shared<const std::vector<Entry>>()};
+    std::shared_ptr<const std::vector<Entry>> entries{scannedEntries};
+    // What entries were last searched from, while searchName is set.
+    std::shared_ptr<const std::vector<Entry>> searchedEntries;
+    std::string searchedName;
     std::vector<std::string> filters;
     std::vector<std::string> sortPolicy{"dir", "type", "name"};
+    bool isShowHidden{false};
+    std::unique_ptr<DirectoryPrefetcher> prefetcher;
+    std::unique_ptr<TreeView> treeView;
+    bool isGroupingSeries{false};
+    bool isSizingEnabled{false};
+    fs::path sizedDirectory;
+    uint64_t seenSizeGeneration{0};
+    // The listing sorted again with the directory totals known at sizeSortGeneration, and the keys
+    // of sizeSortSource it was sorted by (null if they could not be read in time).
+    std::shared_ptr<const std::vector<Entry>> sizeSortSource;
+    std::shared_ptr<const std::vector<Entry>> sizeSorted;
+    std::shared_ptr<SortKeys> sizeSortKeys;
+    uint64_t sizeSortGeneration{0};
+
+    std::unique_ptr<CandidateReader> candidateReader;
+    std::vector<Entry> candidates;
+    std::optional<ScanOptions> candidateOptions; // Of the current listing
+    std::string listingProblem;
+    struct Scan;
+    // A scan of the current directory that missed its deadline; its listing is taken when it arrives.
+    std::shared_ptr<Scan> lateScan;
+    // The current listing when it was too big for the ListingCache, kept so refreshes need not scan again.
+    std::shared_ptr<const Scan> uncachedScan;
+
+    // Runs scan on a DeadlineExecutor worker; false (and the directory in the negative cache) if it
+    // stopped making progress. previous is an uncached listing of the directory to reuse if still current.
+    static bool scanWithinDeadline(const std::shared_ptr<Scan> &scan, std::shared_ptr<const Scan> previous);
+    static void runScan(Scan &scan, const Scan *previous);
+    std::shared_ptr<const std::vector<Entry>> loadCurrentListing(const ScanOptions &options);
+    void refreshCandidates(bool showHidden);
+    void sortBySizeTotals();
 
-    void sortEntries();
-    Comparator combineComparators(const std::vector<Comparator> &comps);
-    bool matchesFilter(const fs::path &p) const;
     void commandStringParser(std::vector<std::string> &vector, const std::string &str);
 };
 #endif // __unix__
\ No newline at end of file
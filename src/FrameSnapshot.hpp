@@ -0,0 +1,64 @@
+// FrameSnapshot.hpp
+#ifdef __unix__
+#pragma once
+#include "DirectoryStats.hpp"
+#include "FilePreviewer.hpp"
+#include "LineEditor.hpp"
+#include "TreeRows.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Everything the renderer needs to draw one frame, captured by the model thread.
+// Snapshots are never modified after publishing; large members are shared, not copied.
+struct FrameSnapshot {
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t inputSequence{0};    // Number of keys the model had consumed for this frame
+    Clock::time_point oldestKeyTime{}; // Arrival of the oldest key first shown by this frame
+
+    std::string location; // Directory, or the candidate list state
+    bool isCandidateList{false};
+    std::string listingProblem; // Why the directory could not be listed
+    std::string expandProblem;  // Which directory the tree view could not expand, and why
+    bool isSlowFilesystem{false};
+    std::vector<std::string> filters;
+    std::string searchName;
+    bool isShowHidden{false};
+    bool isShowHint{false};
+    bool isShowSelected{true};
+    bool isShowPerfHud{false};
+    bool isShowStats{false};
+    std::shared_ptr<const DirectoryStats::Breakdown> stats; // Of the current directory, if counted
+    bool isCountingStats{false};
+    bool isShowPreview{false};
+    fs::path previewPath; // Empty when the cursor is not on a regular file
+    std::shared_ptr<const FilePreviewer::Preview> preview; // Null while it is being read
+
+    std::shared_ptr<const std::vector<fs::directory_entry>> entries;
+    bool isTreeView{false};
+    TreeRows treeRows; // Persistent, so holding it costs nothing and later edits do not show
+    size_t cursor{0};
+
+    std::shared_ptr<const std::set<fs::path>> selectedPaths;
+    std::string selectionTitle; // As described by the selection policy
+
+    std::string errorMessage;
+
+    bool isEditingLine{false};
+    std::string linePrompt;
+    std::string lineBuffer;
+    size_t lineCursor{0};
+    std::shared_ptr<const LineEditor::Completion> completion; // While Tab cycles through candidates
+    size_t completionIndex{LineEditor::no_candidate};
+
+    std::string pagerTitle;
+    std::shared_ptr<const std::vector<std::string>> pagerLines; // Null unless the pager is open
+    size_t pagerTop{0};
+};
+#endif // __unix__
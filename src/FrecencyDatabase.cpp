@@ -0,0 +1,256 @@
+// FrecencyDatabase.cpp
+#ifdef __unix__
+#include "FrecencyDatabase.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+constexpr char frecency_magic[8] = {'F', 'S', 'E', 'L', 'F', 'R', 'E', 'C'};
+
+fs::path defaultFile() {
+    if (const char *data_home = std::getenv("XDG_DATA_HOME"); data_home && *data_home) {
+        return fs::path(data_home) / "FileSelector" / "frecency";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".local" / "share" / "FileSelector" / "frecency";
+    }
+    return {};
+}
+
+int64_t nowSeconds() {
+    using namespace std::chrono;
+    return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+}
+
+std::string lowered(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+template <typename T>
+void put(std::string &out, T value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+bool take(const std::string &in, size_t &offset, T &value) {
+    if (in.size() - offset < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+} // namespace
+
+FrecencyDatabase &FrecencyDatabase::instance() {
+    static FrecencyDatabase database;
+    return database;
+}
+
+FrecencyDatabase::~FrecencyDatabase() {
+    save();
+}
+
+void FrecencyDatabase::setFile(const fs::path &newFile) {
+    std::lock_guard lock(mutex);
+    isLoaded = true; // The default file is not read any more
+    file = newFile;
+    if (!file.empty()) {
+        merge(file);
+    }
+}
+
+void FrecencyDatabase::recordVisit(const fs::path &directory) {
+    std::lock_guard lock(mutex);
+    loadIfNeeded();
+    if (auto found = index.find(directory.native()); found != index.end()) {
+        auto &entry = entries[found->second];
+        ++entry.visits;
+        entry.lastVisit = nowSeconds();
+        ++totalVisits;
+    } else {
+        add(makeEntry(directory.native(), 1, nowSeconds()));
+    }
+    isDirty = true;
+    if (totalVisits > max_total_visits) {
+        age();
+    }
+}
+
+std::vector<fs::path> FrecencyDatabase::query(const std::string &query, size_t limit) {
+    std::lock_guard lock(mutex);
+    loadIfNeeded();
+    std::vector<std::string> words;
+    std::istringstream iss(lowered(query));
+    for (std::string word; iss >> word;) {
+        words.push_back(std::move(word));
+    }
+    if (words.empty()) {
+        return {};
+    }
+
+    const int64_t now = nowSeconds();
+    std::vector<std::pair<double, size_t>> ranked;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (const double entry_score = score(entries[i], words, now); entry_score > 0) {
+            ranked.emplace_back(entry_score, i);
+        }
+    }
+    const size_t count = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<fs::path> matches;
+    matches.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        matches.emplace_back(entries[ranked[i].second].path);
+    }
+    return matches;
+}
+
+double FrecencyDatabase::score(const Entry &entry, const std::vector<std::string> &words, int64_t now) {
+    // The words must appear in order; where the last one lands decides how good a match it is.
+    size_t position = 0;
+    size_t last_match = 0;
+    for (const auto &word : words) {
+        last_match = entry.lowered.find(word, position);
+        if (last_match == std::string::npos) {
+            return 0;
+        }
+        position = last_match + word.size();
+    }
+    double match_weight = 1;
+    if (last_match == entry.nameOffset) {
+        match_weight = 4; // The directory's name starts with it
+    } else if (last_match > entry.nameOffset) {
+        match_weight = 2; // Somewhere in the directory's name
+    }
+    const int64_t age = now - entry.lastVisit;
+    double recency_weight = 0.25;
+    if (age < 60 * 60) {
+        recency_weight = 4;
+    } else if (age < 24 * 60 * 60) {
+        recency_weight = 2;
+    } else if (age < 7 * 24 * 60 * 60) {
+        recency_weight = 0.5;
+    }
+    return entry.visits * recency_weight * match_weight;
+}
+
+void FrecencyDatabase::save() {
+    std::lock_guard lock(mutex);
+    if (!isDirty || file.empty()) {
+        return;
+    }
+    merge(file);
+    if (totalVisits > max_total_visits) {
+        age();
+    }
+
+    // Header, then per directory: visits, last visit, path length, path.
+    std::string data(frecency_magic, sizeof(frecency_magic));
+    put(data, format_version);
+    put(data, static_cast<uint32_t>(entries.size()));
+    for (const auto &entry : entries) {
+        put(data, entry.visits);
+        put(data, entry.lastVisit);
+        put(data, static_cast<uint32_t>(entry.path.size()));
+        data += entry.path;
+    }
+
+    // Written next to the file and renamed over it, so a reader never sees half of it.
+    std::error_code ec;
+    fs::create_directories(file.parent_path(), ec);
+    const fs::path temporary = file.string() + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            return;
+        }
+    }
+    fs::rename(temporary, file, ec);
+    isDirty = ec.operator bool();
+}
+
+void FrecencyDatabase::loadIfNeeded() {
+    if (isLoaded) {
+        return;
+    }
+    isLoaded = true;
+    file = defaultFile();
+    if (!file.empty()) {
+        merge(file);
+    }
+}
+
+FrecencyDatabase::Entry FrecencyDatabase::makeEntry(std::string path, uint32_t visits, int64_t lastVisit) {
+    const size_t slash = path.rfind('/');
+    Entry entry{std::move(path), {}, slash == std::string::npos ? 0 : slash + 1, visits, lastVisit};
+    entry.lowered = lowered(entry.path);
+    return entry;
+}
+
+std::vector<FrecencyDatabase::Entry> FrecencyDatabase::readFile(const fs::path &file) {
+    std::ifstream in(file, std::ios::binary);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<Entry> read;
+    size_t offset = sizeof(frecency_magic);
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (data.size() < offset || std::memcmp(data.data(), frecency_magic, sizeof(frecency_magic)) != 0 ||
+        !take(data, offset, version) || version != format_version || !take(data, offset, count)) {
+        return read; // Missing, damaged or of another version: start over
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t visits = 0;
+        int64_t last_visit = 0;
+        uint32_t length = 0;
+        if (!take(data, offset, visits) || !take(data, offset, last_visit) || !take(data, offset, length) ||
+            data.size() - offset < length) {
+            break;
+        }
+        read.push_back(makeEntry(data.substr(offset, length), visits, last_visit));
+        offset += length;
+    }
+    return read;
+}
+
+void FrecencyDatabase::merge(const fs::path &file) {
+    for (auto &entry : readFile(file)) {
+        if (index.find(entry.path) == index.end()) {
+            add(std::move(entry));
+        }
+    }
+}
+
+void FrecencyDatabase::add(Entry entry) {
+    totalVisits += entry.visits;
+    index.emplace(entry.path, entries.size());
+    entries.push_back(std::move(entry));
+}
+
+void FrecencyDatabase::age() {
+    std::vector<Entry> kept;
+    kept.reserve(entries.size());
+    for (auto &entry : entries) {
+        entry.visits = entry.visits * 9 / 10;
+        if (entry.visits > 0) {
+            kept.push_back(std::move(entry));
+        }
+    }
+    entries.clear();
+    index.clear();
+    totalVisits = 0;
+    for (auto &entry : kept) {
+        add(std::move(entry));
+    }
+}
+#endif // __unix__
@@ -0,0 +1,65 @@
+// FrecencyDatabase.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Process-wide record of the directories entered, ranked by frecency for :z.
+// Each directory has a visit count and the time of its last visit; a query matches its words, in
+// order and case-insensitively, against the paths and scores each match by visits, recency and how
+// well the last word fits the last path component. Everything is ranked in memory (a linear pass over
+// lowered paths), and the file is only read on first use and written when the process ends.
+// Like z, visit counts are aged once their sum exceeds max_total_visits, so old directories drop out.
+class FrecencyDatabase {
+public:
+    static constexpr uint32_t format_version = 1;
+    static constexpr uint64_t max_total_visits = 10'000;
+
+    static FrecencyDatabase &instance();
+    ~FrecencyDatabase();
+    FrecencyDatabase(const FrecencyDatabase &) = delete;
+    FrecencyDatabase &operator=(const FrecencyDatabase &) = delete;
+
+    // Where the database is kept (default: $XDG_DATA_HOME/FileSelector/frecency). Directories recorded
+    // so far are carried over; an empty path keeps them in memory only.
+    void setFile(const fs::path &file);
+    void recordVisit(const fs::path &directory);
+    // The best matches for query, best first; at most limit of them.
+    std::vector<fs::path> query(const std::string &query, size_t limit);
+    // Writes the database, merged with directories other processes recorded in the meantime.
+    void save();
+
+private:
+    struct Entry {
+        std::string path;
+        std::string lowered;
+        size_t nameOffset; // Where the last component starts
+        uint32_t visits;
+        int64_t lastVisit; // Seconds since the epoch
+    };
+
+    FrecencyDatabase() = default;
+    void loadIfNeeded();
+    static Entry makeEntry(std::string path, uint32_t visits, int64_t lastVisit);
+    static std::vector<Entry> readFile(const fs::path &file);
+    // Adds the entries of file that are not known yet.
+    void merge(const fs::path &file);
+    void add(Entry entry);
+    void age();
+    static double score(const Entry &entry, const std::vector<std::string> &words, int64_t now);
+
+    std::mutex mutex;
+    bool isLoaded{false};
+    bool isDirty{false};
+    fs::path file;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> index; // Path to position in entries
+    uint64_t totalVisits{0};
+};
+#endif // __unix__
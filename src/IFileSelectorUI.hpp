@@ -1,6 +1,8 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -11,4 +13,25 @@ public:
     virtual ~IFileSelectorUI() = default;
     virtual std::vector<fs::path> selectMultipleFile() = 0;
     virtual fs::path selectSingleFile() = 0;
+    // Hands each selected path to onSelected; implementations may avoid building the vector.
+    virtual void selectMultipleFile(const std::function<void(const fs::path &)> &onSelected) {
+        for (const auto &path : selectMultipleFile()) {
+            onSelected(path);
+        }
+    }
+    virtual std::vector<fs::path> selectUpTo(size_t) {
+        throw std::runtime_error("Bounded selection is not supported on this platform");
+    }
+    virtual std::vector<fs::path> selectExactly(size_t) {
+        throw std::runtime_error("Bounded selection is not supported on this platform");
+    }
+    virtual void readCandidatesFrom(int, char) {
+        throw std::runtime_error("Reading candidates is not supported on this platform");
+    }
+    virtual void resumeSession(const fs::path &) {
+        throw std::runtime_error("Session state is not supported on this platform");
+    }
+    virtual void setKeymap(const fs::path &) {
+        throw std::runtime_error("Keymaps are not supported on this platform");
+    }
 };
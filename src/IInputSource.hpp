@@ -0,0 +1,12 @@
+#pragma once
+
+// Where an interactive selection gets its keys from (see KeyEnum.hpp for the key codes).
+// The terminal is the default; tests, scripts and benchmarks can inject their own source.
+class IInputSource {
+public:
+    virtual ~IInputSource() = default;
+    // Waits at most timeoutMs (-1: forever) for the next key, false on timeout or end of input.
+    virtual bool readKey(int &key, int timeoutMs) = 0;
+    // True once no more keys will ever arrive.
+    virtual bool isInputClosed() const = 0;
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Where rendered frames go. The terminal is the default; scripts and benchmarks can
+// discard or capture the bytes instead.
+class IOutputSink {
+public:
+    virtual ~IOutputSink() = default;
+    // Height of the screen frames are laid out for.
+    virtual size_t screenRows() const = 0;
+    // Emit the bytes of one frame. inputSequence is the number of keys the frame reflects.
+    virtual void present(const std::string &bytes, uint64_t inputSequence) = 0;
+};
@@ -0,0 +1,157 @@
+// InputDecoder.cpp
+#ifdef __unix__
+#include "InputDecoder.hpp"
+#include "KeyEnum.hpp"
+#include <algorithm>
+#include <string_view>
+
+size_t InputDecoder::feed(const char *data, size_t length) {
+    size_t accepted = std::min(length, freeSpace());
+    for (size_t i = 0; i < accepted; ++i) {
+        ring[(tail + i) % capacity] = static_cast<unsigned char>(data[i]);
+    }
+    tail += accepted;
+    return accepted;
+}
+
+bool InputDecoder::next(int &key, bool flushIncomplete) {
+    if (size() == 0) {
+        return false;
+    }
+    size_t consumed = 0;
+    if (decode(key, consumed) == Result::Incomplete) {
+        if (!flushIncomplete) {
+            return false;
+        }
+        // Nothing more is coming: a lone ESC is a key press, any longer prefix is garbage.
+        key = (size() == 1) ? KEY_ESC : KEY_NULL;
+        consumed = size();
+    }
+    head += consumed;
+    return true;
+}
+
+InputDecoder::Result InputDecoder::decode(int &key, size_t &consumed) const {
+    constexpr size_t max_param_length = 16;
+    char params[max_param_length]{};
+    size_t param_length = 0;
+
+    State state = State::Ground;
+    for (size_t offset = 0; offset < size(); ++offset) {
+        const unsigned char byte = at(offset);
+        consumed = offset + 1;
+        switch (state) {
+        case State::Ground:
+            if (byte != KEY_ESC) {
+                key = mapPlain(byte);
+                return Result::Complete;
+            }
+            state = State::Escape;
+            break;
+        case State::Escape:
+            switch (byte) {
+            case '[':
+                state = State::Csi;
+                break;
+            case 'O':
+                state = State::Ss3;
+                break;
+            case '\177': // Alt+Backspace
+                key = KEY_DELETE_WORD;
+                return Result::Complete;
+            case 'd': // Alt+d
+                key = KEY_DELETE_WORD_BACK;
+                return Result::Complete;
+            default:
+                // ESC followed by an unrelated byte: report the ESC, keep the byte for next time.
+                key = KEY_ESC;
+                consumed = offset;
+                return Result::Complete;
+            }
+            break;
+        case State::Csi:
+            if (byte >= 0x40 && byte <= 0x7E) {
+                key = mapCsi(params, param_length, byte);
+                return Result::Complete;
+            }
+            if (param_length == max_param_length) {
+                key = KEY_NULL; // Overlong or malformed sequence, drop what we have.
+                return Result::Complete;
+            }
+            params[param_length++] = static_cast<char>(byte);
+            break;
+        case State::Ss3:
+            key = mapSs3(byte);
+            return Result::Complete;
+        }
+    }
+    return Result::Incomplete;
+}
+
+int InputDecoder::mapCsi(const char *params, size_t paramLength, unsigned char final) {
+    const std::string_view param_view(params, paramLength);
+    const bool ctrl_modifier = (param_view == "1;5");
+    switch (final) {
+    case 'A':
+        return KEY_ARROW_UP;
+    case 'B':
+        return KEY_ARROW_DOWN;
+    case 'C':
+        return ctrl_modifier ? KEY_CTRL_RIGHT : KEY_ARROW_RIGHT;
+    case 'D':
+        return ctrl_modifier ? KEY_CTRL_LEFT : KEY_ARROW_LEFT;
+    case 'H':
+        return KEY_HOME;
+    case 'F':
+        return KEY_END;
+    case 'Z':
+        return KEY_BACK_TAB;
+    case '~':
+        if (param_view == "3") {
+            return KEY_DELETE;
+        } else if (param_view == "1" || param_view == "7") {
+            return KEY_HOME;
+        } else if (param_view == "4" || param_view == "8") {
+            return KEY_END;
+        } else if (param_view == "5") {
+            return KEY_PAGE_UP;
+        } else if (param_view == "6") {
+            return KEY_PAGE_DOWN;
+        }
+        break;
+    }
+    return KEY_NULL;
+}
+
+int InputDecoder::mapSs3(unsigned char final) {
+    switch (final) {
+    case 'A':
+        return KEY_ARROW_UP;
+    case 'B':
+        return KEY_ARROW_DOWN;
+    case 'C':
+        return KEY_ARROW_RIGHT;
+    case 'D':
+        return KEY_ARROW_LEFT;
+    case 'H':
+        return KEY_HOME;
+    case 'F':
+        return KEY_END;
+    }
+    return KEY_NULL;
+}
+
+int InputDecoder::mapPlain(unsigned char byte) {
+    switch (byte) {
+    case '\n':
+    case '\r':
+        return KEY_ENTER;
+    case 23: // Ctrl+W
+        return KEY_DELETE_WORD;
+    case 21: // Ctrl+U
+        return KEY_DELETE_LINE;
+    default:
+        return byte; // Normal character
+    }
+}
+#endif // __unix__
@@ -0,0 +1,51 @@
+// InputDecoder.hpp
+#ifdef __unix__
+#pragma once
+#include <array>
+#include <cstddef>
+
+// Streaming decoder that turns raw terminal bytes into Key codes (see KeyEnum.hpp).
+// Bytes are appended to a fixed ring buffer and consumed one complete key at a time, so
+// any amount of typeahead or pasted input can be decoded without losing or splitting keys.
+// An escape sequence that has only partially arrived stays in the buffer until the rest of
+// it is fed, or until the caller decides it is a lone ESC press and flushes it.
+class InputDecoder {
+public:
+    static constexpr size_t capacity = 4096;
+
+    // Append raw bytes, returns how many were accepted (limited by free space).
+    size_t feed(const char *data, size_t length);
+    size_t freeSpace() const { return capacity - size(); }
+
+    // Decode the next complete key. Returns false when the buffer is empty or only holds the
+    // beginning of an escape sequence; with flushIncomplete the prefix is decoded as-is instead.
+    bool next(int &key, bool flushIncomplete = false);
+
+    // True when the remaining bytes are an unfinished escape sequence.
+    bool hasIncomplete() const { return size() > 0; }
+
+private:
+    enum class State {
+        Ground,
+        Escape,
+        Csi,
+        Ss3
+    };
+    enum class Result {
+        Complete,
+        Incomplete
+    };
+
+    std::array<unsigned char, capacity> ring{};
+    size_t head{0}; // read position, grows monotonically
+    size_t tail{0}; // write position, grows monotonically
+
+    size_t size() const { return tail - head; }
+    unsigned char at(size_t offset) const { return ring[(head + offset) % capacity]; }
+
+    Result decode(int &key, size_t &consumed) const;
+    static int mapCsi(const char *params, size_t paramLength, unsigned char final);
+    static int mapSs3(unsigned char final);
+    static int mapPlain(unsigned char byte);
+};
+#endif // __unix__
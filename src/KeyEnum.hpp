@@ -2,6 +2,7 @@
 #ifdef __unix__
 enum Key {
     KEY_NULL = 0,
+    KEY_TAB = '\t',
     KEY_ESC = 27,
     KEY_ENTER = '\r',
     KEY_BACKSPACE = 127,
@@ -14,6 +15,9 @@ enum Key {
     KEY_END,
     KEY_CTRL_LEFT,
     KEY_CTRL_RIGHT,
+    KEY_BACK_TAB, // Shift+Tab
+    KEY_PAGE_UP,
+    KEY_PAGE_DOWN,
 
     KEY_DELETE,
     KEY_DELETE_WORD,
@@ -0,0 +1,149 @@
+// Keymap.cpp
+#ifdef __unix__
+#include "Keymap.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <fmt/core.h>
+
+Result<Keymap> Keymap::load(const fs::path &file) {
+    std::ifstream bindings(file);
+    if (!bindings) {
+        return Error{fmt::format("Failed to open keymap: {}", file.string())};
+    }
+    auto keymap = parse(bindings);
+    if (!keymap) {
+        return Error{fmt::format("{}: {}", file.string(), keymap.error().message)};
+    }
+    return keymap;
+}
+
+Result<Keymap> Keymap::parse(std::istream &bindings, Keymap keymap) {
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(bindings, line)) {
+        ++line_number;
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string key_name;
+        std::string action_name;
+        if (!(words >> key_name)) {
+            continue;
+        }
+        std::string extra;
+        if (!(words >> action_name) || (words >> extra)) {
+            return Error{fmt::format("line {}: expected \"<key> <action>\"", line_number)};
+        }
+
+        std::optional<int> key;
+        if (key_name.size() == 1) {
+            key = static_cast<unsigned char>(key_name[0]);
+        } else if (key_name.size() > 2 && key_name.front() == '<' && key_name.back() == '>') {
+            key = namedKey(std::string_view(key_name).substr(1, key_name.size() - 2));
+        }
+        if (!key) {
+            return Error{fmt::format("line {}: unknown key {}", line_number, key_name)};
+        }
+        auto action = std::find(action_names.begin(), action_names.end(), action_name);
+        if (action == action_names.end()) {
+            return Error{fmt::format("line {}: unknown action {}", line_number, action_name)};
+        }
+        keymap.bind(*key, static_cast<Action>(action - action_names.begin()));
+    }
+    return keymap;
+}
+
+fs::path Keymap::defaultFile() {
+    if (const char *config_home = std::getenv("XDG_CONFIG_HOME"); config_home && *config_home) {
+        return fs::path(config_home) / "FileSelector" / "keymap";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".config" / "FileSelector" / "keymap";
+    }
+    return {};
+}
+
+std::optional<int> Keymap::namedKey(std::string_view name) {
+    static constexpr std::pair<std::string_view, int> named_keys[] = {
+        {"up", KEY_ARROW_UP},
+        {"down", KEY_ARROW_DOWN},
+        {"left", KEY_ARROW_LEFT},
+        {"right", KEY_ARROW_RIGHT},
+        {"home", KEY_HOME},
+        {"end", KEY_END},
+        {"pgup", KEY_PAGE_UP},
+        {"pgdn", KEY_PAGE_DOWN},
+        {"enter", KEY_ENTER},
+        {"esc", KEY_ESC},
+        {"space", ' '},
+        {"bs", KEY_BACKSPACE},
+        {"del", KEY_DELETE},
+        {"tab", KEY_TAB},
+        {"btab", KEY_BACK_TAB},
+        {"lt", '<'},
+        {"hash", '#'}};
+    for (const auto &[key_name, key] : named_keys) {
+        if (key_name == name) {
+            return key;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<int> Keymap::keysFor(Action action) const {
+    std::vector<int> keys;
+    for (size_t slot = byte_slots; slot < table.size(); ++slot) {
+        if (table[slot] == action) {
+            keys.push_back(KEY_ARROW_LEFT + static_cast<int>(slot - byte_slots));
+        }
+    }
+    for (size_t slot = 0; slot < byte_slots; ++slot) {
+        if (table[slot] == action) {
+            keys.push_back(static_cast<int>(slot));
+        }
+    }
+    return keys;
+}
+
+std::string Keymap::keyLabel(int key) {
+    static constexpr std::pair<int, std::string_view> labels[] = {
+        {KEY_ARROW_UP, "↑"},      {KEY_ARROW_DOWN, "↓"},   {KEY_ARROW_LEFT, "←"},    {KEY_ARROW_RIGHT, "→"},
+        {KEY_HOME, "Home"},       {KEY_END, "End"},        {KEY_PAGE_UP, "PgUp"},    {KEY_PAGE_DOWN, "PgDn"},
+        {KEY_ENTER, "Enter"},     {'\n', "Enter"},         {KEY_ESC, "Esc"},         {' ', "Space"},
+        {KEY_BACKSPACE, "Backspace"}, {KEY_DELETE, "Del"}, {KEY_TAB, "Tab"},         {KEY_BACK_TAB, "Shift+Tab"}};
+    for (const auto &[labelled, label] : labels) {
+        if (labelled == key) {
+            return std::string(label);
+        }
+    }
+    if (key > ' ' && key < KEY_BACKSPACE) {
+        return std::string(1, static_cast<char>(key));
+    }
+    if (key > 0 && key < ' ') {
+        return fmt::format("Ctrl+{}", static_cast<char>('A' + key - 1));
+    }
+    return fmt::format("<{}>", key);
+}
+
+std::string Keymap::keysLabel(Action action) const {
+    std::vector<std::string> labels;
+    for (int key : keysFor(action)) {
+        std::string label = keyLabel(key);
+        if (std::find(labels.begin(), labels.end(), label) == labels.end()) {
+            labels.push_back(std::move(label));
+        }
+    }
+    if (labels.empty()) {
+        return "(unbound)";
+    }
+    std::string joined = labels.front();
+    for (size_t i = 1; i < labels.size(); ++i) {
+        joined += '/';
+        joined += labels[i];
+    }
+    return joined;
+}
+#endif // __unix__
@@ -0,0 +1,118 @@
+// Keymap.hpp
+#ifdef __unix__
+#pragma once
+#include "KeyEnum.hpp"
+#include "Result.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Which action each key triggers outside of command and number mode, as a flat table indexed by
+// key code: dispatching a key is an array lookup, and a key without a binding is Action::None.
+// ':' and the digits start command and number mode before the keymap is asked.
+//
+// A keymap file rebinds keys on top of the defaults, one "<key> <action>" per line ('#' starts a
+// comment). Keys are single characters or names like <up> <space> <hash> (as in scripts), actions
+// are the names in action_names, and "none" unbinds a key. For example:
+//   <down> move-down
+//   x      toggle-hidden
+//   H      none
+class Keymap {
+public:
+    enum class Action : uint8_t {
+        None,
+        MoveUp,
+        MoveDown,
+        Leave, // Collapse, go up a tree level, or go to the parent directory
+        Open,  // Enter or expand a directory, toggle a file
+        Quit,
+        ToggleHint,
+        ShowHelp,
+        ToggleHidden,
+        ToggleSelected,
+        TogglePerfHud,
+        ToggleTreeView,
+        TogglePreview
+    };
+    // Indexed by Action.
+    static constexpr std::array<std::string_view, 13> action_names{
+        "none", "move-up", "move-down", "leave", "open", "quit", "toggle-hint", "help",
+        "toggle-hidden", "toggle-selected", "toggle-perf-hud", "toggle-tree", "toggle-preview"};
+
+    // The bindings the selector has always had.
+    static constexpr Keymap defaults() {
+        Keymap keymap;
+        keymap.bind(KEY_ARROW_UP, Action::MoveUp);
+        keymap.bind('k', Action::MoveUp);
+        keymap.bind(KEY_ARROW_DOWN, Action::MoveDown);
+        keymap.bind('j', Action::MoveDown);
+        keymap.bind(KEY_ARROW_LEFT, Action::Leave);
+        keymap.bind('h', Action::Leave);
+        keymap.bind(KEY_BACKSPACE, Action::Leave);
+        keymap.bind(KEY_ARROW_RIGHT, Action::Open);
+        keymap.bind('l', Action::Open);
+        keymap.bind(' ', Action::Open);
+        keymap.bind('q', Action::Quit);
+        keymap.bind('\n', Action::Quit);
+        keymap.bind(KEY_ENTER, Action::Quit);
+        keymap.bind('!', Action::ToggleHint);
+        keymap.bind('?', Action::ShowHelp);
+        keymap.bind('H', Action::ToggleHidden);
+        keymap.bind('S', Action::ToggleSelected);
+        keymap.bind('P', Action::TogglePerfHud);
+        keymap.bind('T', Action::ToggleTreeView);
+        keymap.bind('v', Action::TogglePreview);
+        return keymap;
+    }
+    // The defaults with the bindings of file on top.
+    static Result<Keymap> load(const fs::path &file);
+    static Result<Keymap> parse(std::istream &bindings, Keymap keymap = defaults());
+    // $XDG_CONFIG_HOME/FileSelector/keymap (or ~/.config/...); empty if neither is set.
+    static fs::path defaultFile();
+
+    constexpr void bind(int key, Action action) {
+        if (const size_t slot = slotOf(key); slot < table.size()) {
+            table[slot] = action;
+        }
+    }
+    constexpr Action find(int key) const {
+        const size_t slot = slotOf(key);
+        return slot < table.size() ? table[slot] : Action::None;
+    }
+
+    // The key called name in keymap files and scripts ("up", "space", "pgdn", ...).
+    static std::optional<int> namedKey(std::string_view name);
+    // The keys bound to action, special keys (arrows, ...) first; empty if it is unbound.
+    std::vector<int> keysFor(Action action) const;
+    // How key is written in the help: the character itself, or "↑", "Space", "Enter", "Ctrl+X" ...
+    static std::string keyLabel(int key);
+    // The labels of the keys bound to action, joined by '/' (the same label only once).
+    std::string keysLabel(Action action) const;
+
+    bool operator==(const Keymap &) const = default;
+
+private:
+    // Plain bytes take the first 256 slots, the special keys (from KEY_ARROW_LEFT on) the rest.
+    static constexpr size_t byte_slots = 256;
+    static constexpr size_t special_slots = KEY_DELETE_LINE - KEY_ARROW_LEFT + 1;
+
+    std::array<Action, byte_slots + special_slots> table{};
+
+    static constexpr size_t slotOf(int key) {
+        if (key >= 0 && static_cast<size_t>(key) < byte_slots) {
+            return static_cast<size_t>(key);
+        }
+        if (key >= KEY_ARROW_LEFT && key <= KEY_DELETE_LINE) {
+            return byte_slots + static_cast<size_t>(key - KEY_ARROW_LEFT);
+        }
+        return byte_slots + special_slots; // No slot
+    }
+};
+#endif // __unix__
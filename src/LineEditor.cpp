@@ -0,0 +1,194 @@
+// LineEditor.cpp
+#ifdef __unix__
+#include "LineEditor.hpp"
+#include "KeyEnum.hpp"
+#include <algorithm>
+#include <cctype>
+
+void LineEditor::begin(const std::string &prompt, const std::string &initial, Completer completer) {
+    active = true;
+    promptText = prompt;
+    lineBuffer = initial;
+    cursorPos = lineBuffer.size();
+    historyPosition = commandHistory.size();
+    this->completer = std::move(completer);
+    activeCompletion.reset();
+}
+
+void LineEditor::setHistory(std::vector<std::string> history) {
+    commandHistory = std::move(history);
+    historyPosition = commandHistory.size();
+}
+
+LineEditor::Status LineEditor::handleKey(int key) {
+    const size_t buffer_size = lineBuffer.size();
+    auto is_space = [this](size_t pos) { return std::isspace(static_cast<unsigned char>(lineBuffer[pos])); };
+    if (key != KEY_TAB && key != KEY_BACK_TAB) {
+        activeCompletion.reset(); // Any other key ends the cycle
+    }
+
+    switch (key) {
+    case KEY_TAB:
+    case KEY_BACK_TAB:
+        complete(key == KEY_TAB);
+        break;
+    case KEY_ESC:
+        active = false;
+        return Status::Cancelled;
+    case KEY_ENTER:
+        commandHistory.push_back(lineBuffer);
+        historyPosition = commandHistory.size();
+        active = false;
+        return Status::Accepted;
+    case KEY_ARROW_LEFT:
+        if (cursorPos > 0) {
+            --cursorPos;
+        }
+        break;
+    case KEY_ARROW_RIGHT:
+        if (cursorPos < buffer_size) {
+            ++cursorPos;
+        }
+        break;
+    case KEY_ARROW_UP:
+        if (historyPosition > 0) {
+            loadHistory(historyPosition - 1);
+        }
+        break;
+    case KEY_ARROW_DOWN:
+        if (historyPosition < commandHistory.size()) {
+            loadHistory(historyPosition + 1);
+        }
+        break;
+    case KEY_CTRL_LEFT:
+        if (cursorPos > 0) {
+            --cursorPos;
+        }
+        while (cursorPos > 0 && is_space(cursorPos)) {
+            --cursorPos;
+        }
+        while (cursorPos > 0 && !is_space(cursorPos - 1)) {
+            --cursorPos;
+        }
+        break;
+    case KEY_CTRL_RIGHT:
+        while (cursorPos < buffer_size && is_space(cursorPos)) {
+            ++cursorPos;
+        }
+        while (cursorPos < buffer_size && !is_space(cursorPos)) {
+            ++cursorPos;
+        }
+        break;
+    case KEY_HOME:
+        cursorPos = 0;
+        break;
+    case KEY_END:
+        cursorPos = buffer_size;
+        break;
+    case KEY_DELETE:
+        if (cursorPos < buffer_size) {
+            lineBuffer.erase(cursorPos, 1);
+        }
+        break;
+    case KEY_BACKSPACE:
+        if (cursorPos > 0) {
+            deleteBeforeCursor();
+        }
+        break;
+    case KEY_DELETE_WORD:
+        if (cursorPos > 0) {
+            deleteBeforeCursor();
+        }
+        while (cursorPos > 0 && is_space(cursorPos - 1)) {
+            deleteBeforeCursor();
+        }
+        while (cursorPos > 0 && !is_space(cursorPos - 1)) {
+            deleteBeforeCursor();
+        }
+        break;
+    case KEY_DELETE_WORD_BACK: {
+        size_t end = cursorPos;
+        while (end < buffer_size && is_space(end)) {
+            ++end;
+        }
+        while (end < buffer_size && !is_space(end)) {
+            ++end;
+        }
+        lineBuffer.erase(cursorPos, end - cursorPos);
+    } break;
+    case KEY_DELETE_LINE:
+        lineBuffer.erase(0, cursorPos);
+        cursorPos = 0;
+        break;
+    default:
+        if (key >= 0 && key < 256 && std::isprint(key)) {
+            lineBuffer.insert(cursorPos, 1, static_cast<char>(key));
+            ++cursorPos;
+        }
+    }
+    return Status::Editing;
+}
+
+void LineEditor::complete(bool isForward) {
+    if (!activeCompletion) {
+        if (!completer) {
+            return;
+        }
+        Completion found = completer(lineBuffer, cursorPos);
+        if (found.candidates.empty()) {
+            return;
+        }
+        activeCompletion = std::make_shared<const Completion>(std::move(found));
+        candidateIndex = no_candidate;
+        completedEnd = cursorPos;
+        const auto &candidates = activeCompletion->candidates;
+        if (candidates.size() == 1) {
+            replaceCompletedWord(candidates.front());
+            activeCompletion.reset();
+            return;
+        }
+        // The common prefix of a capped list may be longer than that of all matches.
+        if (activeCompletion->total == candidates.size()) {
+            size_t common = candidates.front().size();
+            for (const auto &candidate : candidates) {
+                common = std::mismatch(candidate.begin(), candidate.begin() + std::min(common, candidate.size()),
+                                       candidates.front().begin()).first - candidate.begin();
+            }
+            // Do not stop inside a UTF-8 sequence.
+            while (common > 0 && common < candidates.front().size() &&
+                   (static_cast<unsigned char>(candidates.front()[common]) & 0xC0) == 0x80) {
+                --common;
+            }
+            if (common > cursorPos - activeCompletion->start) {
+                replaceCompletedWord(candidates.front().substr(0, common));
+                return; // The list is shown; the next Tab starts cycling
+            }
+        }
+    }
+    const size_t count = activeCompletion->candidates.size();
+    if (candidateIndex == no_candidate) {
+        candidateIndex = isForward ? 0 : count - 1;
+    } else {
+        candidateIndex = isForward ? (candidateIndex + 1) % count : (candidateIndex + count - 1) % count;
+    }
+    replaceCompletedWord(activeCompletion->candidates[candidateIndex]);
+}
+
+void LineEditor::replaceCompletedWord(const std::string &text) {
+    const size_t start = activeCompletion->start;
+    lineBuffer.replace(start, completedEnd - start, text);
+    cursorPos = start + text.size();
+    completedEnd = cursorPos;
+}
+
+void LineEditor::loadHistory(size_t position) {
+    historyPosition = position;
+    lineBuffer = (position < commandHistory.size()) ? commandHistory[position] : std::string{};
+    cursorPos = lineBuffer.size();
+}
+
+void LineEditor::deleteBeforeCursor() {
+    lineBuffer.erase(cursorPos - 1, 1);
+    --cursorPos;
+}
+#endif // __unix__
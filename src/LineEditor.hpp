@@ -0,0 +1,63 @@
+// LineEditor.hpp
+#ifdef __unix__
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Key-driven single line editor used by command (:) and number mode.
+// It never touches the terminal itself: the renderer draws prompt(), buffer() and cursor()
+// from a snapshot, so editing works the same regardless of which thread reads the keys.
+class LineEditor {
+public:
+    enum class Status {
+        Editing,
+        Accepted,
+        Cancelled
+    };
+
+    // What Tab offers for the word before the cursor.
+    struct Completion {
+        size_t start{0};                     // The word is buffer()[start, cursor())
+        std::vector<std::string> candidates; // Replacements for the word
+        size_t total{0};                     // Matches before the candidates were capped
+    };
+    using Completer = std::function<Completion(const std::string &line, size_t cursor)>;
+
+    static constexpr size_t no_candidate = static_cast<size_t>(-1);
+
+    // Tab asks completer, if given, for completions. A single one is inserted, several are first
+    // extended to their common prefix, and further Tabs (Shift+Tab backwards) cycle through them.
+    void begin(const std::string &prompt, const std::string &initial = "", Completer completer = {});
+    Status handleKey(int key);
+
+    bool isActive() const { return active; }
+    const std::string &prompt() const { return promptText; }
+    const std::string &buffer() const { return lineBuffer; }
+    size_t cursor() const { return cursorPos; }
+    // Accepted lines, oldest first; the arrow keys walk through them.
+    const std::vector<std::string> &history() const { return commandHistory; }
+    void setHistory(std::vector<std::string> history);
+    // The completions Tab is cycling through (null otherwise), and which one is in the line.
+    std::shared_ptr<const Completion> completion() const { return activeCompletion; }
+    size_t completionIndex() const { return candidateIndex; }
+
+private:
+    bool active{false};
+    std::string promptText{};
+    std::string lineBuffer{};
+    size_t cursorPos{0};
+    std::vector<std::string> commandHistory{};
+    size_t historyPosition{0};
+    Completer completer{};
+    std::shared_ptr<const Completion> activeCompletion{};
+    size_t candidateIndex{no_candidate};
+    size_t completedEnd{0}; // Where the inserted candidate ends
+
+    void complete(bool isForward);
+    void replaceCompletedWord(const std::string &text);
+    void loadHistory(size_t position);
+    void deleteBeforeCursor();
+};
+#endif // __unix__
@@ -0,0 +1,149 @@
+// ListingCache.cpp
+#ifdef __unix__
+#include "ListingCache.hpp"
+
+ListingCache &ListingCache::instance() {
+    static ListingCache cache;
+    return cache;
+}
+
+void ListingCache::setByteBudget(size_t bytes) {
+    std::lock_guard lock(mutex);
+    byteBudget = bytes;
+    evictOverBudget();
+}
+
+ListingCache::Listing ListingCache::find(const fs::path &directory, const FileSystemManager::ScanOptions &options) {
+    const std::string key = makeKey(directory, options);
+    fs::file_time_type cached_time;
+    {
+        std::lock_guard lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            ++counters.misses;
+            return nullptr;
+        }
+        cached_time = it->second->modifiedTime;
+    }
+
+    // The stat runs unlocked; the entry may be replaced meanwhile, so look it up again.
+    std::error_code ec;
+    const auto modified_time = fs::last_write_time(directory, ec);
+
+    std::lock_guard lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++counters.misses;
+        return nullptr;
+    }
+    if (ec || modified_time != cached_time || it->second->modifiedTime != cached_time) {
+        ++counters.misses;
+        ++counters.stale;
+        counters.bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+        return nullptr;
+    }
+    ++counters.hits;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->listing;
+}
+
+bool ListingCache::contains(const fs::path &directory, const FileSystemManager::ScanOptions &options) const {
+    std::lock_guard lock(mutex);
+    return index.count(makeKey(directory, options)) != 0;
+}
+
+bool ListingCache::insert(const fs::path &directory, const FileSystemManager::ScanOptions &options,
+                          fs::file_time_type modifiedTime, Listing listing) {
+    std::string key = makeKey(directory, options);
+    const size_t bytes = estimateBytes(*listing) + key.size();
+
+    std::lock_guard lock(mutex);
+    if (auto it = index.find(key); it != index.end()) {
+        counters.bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    if (bytes > byteBudget) {
+        return false; // Would evict everything else and still not fit
+    }
+    lru.push_front(Node{key, modifiedTime, std::move(listing), bytes});
+    index.emplace(std::move(key), lru.begin());
+    counters.bytes += bytes;
+    evictOverBudget();
+    return true;
+}
+
+void ListingCache::insertFailure(const fs::path &directory, std::string reason) {
+    std::lock_guard lock(mutex);
+    failures[directory.native()] = Failure{std::move(reason), std::chrono::steady_clock::now() + failure_ttl};
+}
+
+std::optional<std::string> ListingCache::findFailure(const fs::path &directory) {
+    std::lock_guard lock(mutex);
+    auto it = failures.find(directory.native());
+    if (it == failures.end()) {
+        return std::nullopt;
+    }
+    if (it->second.expiry < std::chrono::steady_clock::now()) {
+        failures.erase(it);
+        return std::nullopt;
+    }
+    return it->second.reason;
+}
+
+void ListingCache::eraseFailure(const fs::path &directory) {
+    std::lock_guard lock(mutex);
+    failures.erase(directory.native());
+}
+
+void ListingCache::clear() {
+    std::lock_guard lock(mutex);
+    lru.clear();
+    index.clear();
+    failures.clear();
+    counters.bytes = 0;
+}
+
+ListingCache::Stats ListingCache::stats() const {
+    std::lock_guard lock(mutex);
+    Stats stats = counters;
+    stats.listings = lru.size();
+    stats.byteBudget = byteBudget;
+    return stats;
+}
+
+std::string ListingCache::makeKey(const fs::path &directory, const FileSystemManager::ScanOptions &options) {
+    std::string key = directory.native();
+    key += '\0';
+    key += options.showHidden ? 'H' : '-';
+    for (const auto &filter : options.filters) {
+        key += filter;
+        key += ',';
+    }
+    key += '\0';
+    for (const auto &policy : options.sortPolicy) {
+        key += policy;
+        key += ',';
+    }
+    return key;
+}
+
+size_t ListingCache::estimateBytes(const std::vector<fs::directory_entry> &listing) {
+    size_t bytes = sizeof(listing) + listing.capacity() * sizeof(fs::directory_entry);
+    for (const auto &entry : listing) {
+        bytes += entry.path().native().capacity();
+    }
+    return bytes;
+}
+
+void ListingCache::evictOverBudget() {
+    while (counters.bytes > byteBudget && !lru.empty()) {
+        counters.bytes -= lru.back().bytes;
+        index.erase(lru.back().key);
+        lru.pop_back();
+        ++counters.evictions;
+    }
+}
+#endif // __unix__
@@ -0,0 +1,84 @@
+// ListingCache.hpp
+#ifdef __unix__
+#pragma once
+#include "FileSystemManager.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Process-wide cache of sorted directory listings, shared by every FileSystemManager and by the
+// prefetchers. Entries are keyed by directory and scan options, validated against the directory's
+// mtime (one stat per lookup) and evicted least-recently-used first once the byte budget is exceeded.
+// The mtime only changes when names are added or removed, so file sizes and times inside a cached
+// listing can be older than the files; the renderer stats them again anyway.
+// Directories that could not be listed (unreadable, or too slow to answer) are remembered for
+// failure_ttl, so they are not asked again on every refresh.
+class ListingCache {
+public:
+    using Listing = std::shared_ptr<const std::vector<fs::directory_entry>>;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};    // Including stale entries
+        uint64_t stale{0};     // Found, but the directory changed since
+        uint64_t evictions{0};
+        size_t listings{0};
+        size_t bytes{0};
+        size_t byteBudget{0};
+    };
+
+    static constexpr size_t default_byte_budget = 32 * 1024 * 1024;
+    static constexpr auto failure_ttl = std::chrono::seconds(30);
+
+    static ListingCache &instance();
+
+    void setByteBudget(size_t bytes);
+    // The cached listing if the directory is unchanged since it was scanned, else nullptr.
+    Listing find(const fs::path &directory, const FileSystemManager::ScanOptions &options);
+    // Whether a listing is cached, without checking that it is still current (no syscalls).
+    bool contains(const fs::path &directory, const FileSystemManager::ScanOptions &options) const;
+    // modifiedTime must be read before the scan starts, so changes during the scan invalidate it.
+    // Returns false if the listing alone is over the byte budget and was not kept.
+    bool insert(const fs::path &directory, const FileSystemManager::ScanOptions &options,
+                fs::file_time_type modifiedTime, Listing listing);
+    // The negative cache: why directory could not be listed, for failure_ttl after it happened.
+    void insertFailure(const fs::path &directory, std::string reason);
+    std::optional<std::string> findFailure(const fs::path &directory);
+    void eraseFailure(const fs::path &directory);
+    void clear();
+    Stats stats() const;
+
+private:
+    struct Node {
+        std::string key;
+        fs::file_time_type modifiedTime;
+        Listing listing;
+        size_t bytes;
+    };
+
+    ListingCache() = default;
+    static std::string makeKey(const fs::path &directory, const FileSystemManager::ScanOptions &options);
+    static size_t estimateBytes(const std::vector<fs::directory_entry> &listing);
+    void evictOverBudget();
+
+    mutable std::mutex mutex;
+    std::list<Node> lru; // Most recently used first
+    std::unordered_map<std::string, std::list<Node>::iterator> index;
+    struct Failure {
+        std::string reason;
+        std::chrono::steady_clock::time_point expiry;
+    };
+    std::unordered_map<std::string, Failure> failures; // By directory
+    size_t byteBudget{default_byte_budget};
+    Stats counters{};
+};
+#endif // __unix__
@@ -0,0 +1,70 @@
+// LockFreeQueue.hpp
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+// Bounded single-producer / single-consumer ring buffer.
+// push() is only called from one thread and pop() from one other thread; neither ever blocks.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T &value) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == Capacity) {
+            return false; // full
+        }
+        slots[tail & (Capacity - 1)] = value;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> pop() {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) {
+            return std::nullopt; // empty
+        }
+        T value = std::move(slots[head & (Capacity - 1)]);
+        headIndex.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    bool empty() const {
+        return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> slots{};
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+};
+
+// Single-slot mailbox that always holds the most recent value.
+// A publish that finds an unread value replaces (drops) it, so a slow consumer only ever sees
+// the newest state instead of working through a backlog.
+template <typename T>
+class LatestMailbox {
+public:
+    LatestMailbox() = default;
+    LatestMailbox(const LatestMailbox &) = delete;
+    LatestMailbox &operator=(const LatestMailbox &) = delete;
+    ~LatestMailbox() { delete slot.exchange(nullptr, std::memory_order_acquire); }
+
+    // Returns true when an unread value was dropped.
+    bool publish(std::unique_ptr<T> value) {
+        T *dropped = slot.exchange(value.release(), std::memory_order_acq_rel);
+        delete dropped;
+        return dropped != nullptr;
+    }
+
+    std::unique_ptr<T> take() {
+        return std::unique_ptr<T>(slot.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+private:
+    std::atomic<T *> slot{nullptr};
+};
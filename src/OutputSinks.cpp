@@ -0,0 +1,33 @@
+// OutputSinks.cpp
+#ifdef __unix__
+#include "OutputSinks.hpp"
+
+#include <cerrno>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+FdOutputSink::FdOutputSink(int fd) : fd(fd) {}
+
+size_t FdOutputSink::screenRows() const {
+    winsize size{};
+    if (ioctl(fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) {
+        return size.ws_row;
+    }
+    return 24; // Not a terminal
+}
+
+void FdOutputSink::present(const std::string &bytes, uint64_t) {
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t result = write(fd, bytes.data() + written, bytes.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        written += static_cast<size_t>(result);
+    }
+}
+#endif // __unix__
@@ -0,0 +1,34 @@
+// OutputSinks.hpp
+#pragma once
+#include "IOutputSink.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Writes frames to a file descriptor (stdout by default) and sizes them to its terminal.
+class FdOutputSink : public IOutputSink {
+public:
+    explicit FdOutputSink(int fd);
+    size_t screenRows() const override;
+    void present(const std::string &bytes, uint64_t inputSequence) override;
+
+private:
+    int fd;
+};
+
+// Discards frames, only counting them. Used for headless runs and benchmarks.
+class NullOutputSink : public IOutputSink {
+public:
+    explicit NullOutputSink(size_t rows = 24) : rows(rows) {}
+    size_t screenRows() const override { return rows; }
+    void present(const std::string &bytes, uint64_t) override {
+        ++frameCount;
+        byteCount += bytes.size();
+    }
+
+    uint64_t frameCount{0};
+    uint64_t byteCount{0};
+
+private:
+    size_t rows;
+};
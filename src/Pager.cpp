@@ -0,0 +1,76 @@
+// Pager.cpp
+#ifdef __unix__
+#include "Pager.hpp"
+#include "KeyEnum.hpp"
+
+#include <algorithm>
+
+void Pager::open(std::string title, Lines content) {
+    titleText = std::move(title);
+    lines = std::move(content);
+    topLine = 0;
+}
+
+void Pager::close() {
+    titleText.clear();
+    lines.reset();
+    topLine = 0;
+}
+
+void Pager::update(Lines content) {
+    lines = std::move(content);
+}
+
+void Pager::handleKey(int key, size_t pageRows) {
+    pageRows = std::max<size_t>(pageRows, 1);
+    const long top = static_cast<long>(topLine);
+    const long page = static_cast<long>(pageRows);
+    switch (key) {
+    case 'j':
+    case KEY_ARROW_DOWN:
+    case KEY_ENTER:
+        scrollTo(top + 1, pageRows);
+        break;
+    case 'k':
+    case KEY_ARROW_UP:
+        scrollTo(top - 1, pageRows);
+        break;
+    case ' ':
+    case 'f':
+    case KEY_PAGE_DOWN:
+        scrollTo(top + page, pageRows);
+        break;
+    case 'b':
+    case KEY_PAGE_UP:
+        scrollTo(top - page, pageRows);
+        break;
+    case 'd':
+        scrollTo(top + page / 2, pageRows);
+        break;
+    case 'u':
+        scrollTo(top - page / 2, pageRows);
+        break;
+    case 'g':
+    case KEY_HOME:
+        scrollTo(0, pageRows);
+        break;
+    case 'G':
+    case KEY_END:
+        scrollTo(static_cast<long>(lines->size()), pageRows);
+        break;
+    case 'q':
+    case '?':
+    case KEY_ESC:
+        close();
+        break;
+    default:
+        break;
+    }
+}
+
+void Pager::scrollTo(long line, size_t pageRows) {
+    // The last page is kept full rather than scrolling past the end.
+    const size_t last_top = lines->size() > pageRows ? lines->size() - pageRows : 0;
+    topLine = static_cast<size_t>(std::clamp<long>(line, 0, static_cast<long>(last_top)));
+}
+#endif // __unix__
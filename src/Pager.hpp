@@ -0,0 +1,37 @@
+// Pager.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Key-driven viewer for text longer than the screen: the full help, the selection, directory stats.
+// Like LineEditor it never touches the terminal: the renderer draws lines() from top() in the rows it
+// has, and the keys are given the number of rows last drawn, so paging moves by a screenful.
+// The lines are shared, so cached text (the help) is shown without being copied or formatted again.
+class Pager {
+public:
+    using Lines = std::shared_ptr<const std::vector<std::string>>;
+
+    void open(std::string title, Lines lines);
+    void close();
+    // New text for the open pager at the same position, for views that fill in while shown.
+    void update(Lines lines);
+    // j/k and the arrows scroll a line, Space/b and the page keys a page, g/G and Home/End go to
+    // either end; q, Esc and ? close the pager.
+    void handleKey(int key, size_t pageRows);
+
+    bool isActive() const { return lines != nullptr; }
+    const std::string &title() const { return titleText; }
+    const Lines &content() const { return lines; }
+    size_t top() const { return topLine; }
+
+private:
+    std::string titleText{};
+    Lines lines{};
+    size_t topLine{0};
+
+    void scrollTo(long line, size_t pageRows);
+};
+#endif // __unix__
@@ -0,0 +1,45 @@
+// Result.hpp
+#pragma once
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+
+// Why an operation failed.
+struct Error {
+    std::string message;
+};
+
+// The value of an operation or the Error it failed with, in the manner of C++23's std::expected.
+// For failures that are routine rather than exceptional (a key without a binding, a bad line in a
+// config file), so reporting them costs a return instead of unwinding the stack.
+template <typename T>
+class [[nodiscard]] Result {
+public:
+    Result(T value) : state(std::in_place_index<0>, std::move(value)) {}
+    Result(Error error) : state(std::in_place_index<1>, std::move(error)) {}
+
+    bool hasValue() const { return state.index() == 0; }
+    explicit operator bool() const { return hasValue(); }
+    // Only valid when hasValue() (value) or not (error).
+    T &value() { return *std::get_if<0>(&state); }
+    const T &value() const { return *std::get_if<0>(&state); }
+    const Error &error() const { return *std::get_if<1>(&state); }
+
+private:
+    std::variant<T, Error> state;
+};
+
+template <>
+class [[nodiscard]] Result<void> {
+public:
+    Result() = default;
+    Result(Error error) : failure(std::move(error)) {}
+
+    bool hasValue() const { return !failure; }
+    explicit operator bool() const { return hasValue(); }
+    const Error &error() const { return *failure; }
+
+private:
+    std::optional<Error> failure;
+};
@@ -0,0 +1,140 @@
+// ScriptDriver.cpp
+#ifdef __unix__
+#include "ScriptDriver.hpp"
+#include "KeyEnum.hpp"
+#include "Keymap.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<ScriptDriver::Step> ScriptDriver::parse(std::istream &script) {
+    std::vector<Step> steps;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(script, line)) {
+        ++line_number;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        line = line.substr(start, end - start + 1);
+
+        std::string directive = line.substr(0, line.find(' '));
+        std::string argument = (directive.size() < line.size()) ? line.substr(directive.size() + 1) : "";
+
+        Step step{line, {}};
+        if (directive == "keys") {
+            step.keys = parseKeys(argument);
+        } else if (directive == "command") {
+            step.keys.push_back(':');
+            step.keys.insert(step.keys.end(), argument.begin(), argument.end());
+            step.keys.push_back(KEY_ENTER);
+        } else if (directive == "number") {
+            step.keys.assign(argument.begin(), argument.end());
+            step.keys.push_back(KEY_ENTER);
+        } else if (directive == "quit") {
+            step.keys.push_back('q');
+        } else {
+            throw std::invalid_argument(
+                "Unknown script directive at line " + std::to_string(line_number) + ": " + directive);
+        }
+        if (step.keys.empty()) {
+            throw std::invalid_argument("Empty script step at line " + std::to_string(line_number));
+        }
+        steps.push_back(std::move(step));
+    }
+    return steps;
+}
+
+std::vector<ScriptDriver::Step> ScriptDriver::load(const fs::path &scriptFile) {
+    std::ifstream script(scriptFile);
+    if (!script) {
+        throw std::runtime_error("Failed to open script: " + scriptFile.string());
+    }
+    return parse(script);
+}
+
+std::vector<int> ScriptDriver::parseKeys(const std::string &spec) {
+    std::vector<int> keys;
+    for (size_t i = 0; i < spec.size(); ++i) {
+        if (spec[i] == '<') {
+            size_t close = spec.find('>', i);
+            if (close != std::string::npos) {
+                auto key = Keymap::namedKey(std::string_view(spec).substr(i + 1, close - i - 1));
+                if (!key) {
+                    throw std::invalid_argument("Unknown key name in script: " + spec.substr(i, close - i + 1));
+                }
+                keys.push_back(*key);
+                i = close;
+                continue;
+            }
+        }
+        keys.push_back(static_cast<unsigned char>(spec[i]));
+    }
+    return keys;
+}
+
+ScriptDriver::ScriptDriver(std::vector<Step> steps, std::shared_ptr<IOutputSink> inner)
+    : steps(std::move(steps)), inner(std::move(inner)) {}
+
+bool ScriptDriver::readKey(int &key, int timeoutMs) {
+    std::unique_lock lock(mutex);
+    if (stepIndex < steps.size() && keyIndex == steps[stepIndex].keys.size()) {
+        // Everything of this step is out, wait for present() to see its frame.
+        auto step_done = [this, step = stepIndex] { return stepIndex != step; };
+        if (timeoutMs < 0) {
+            stepFinished.wait(lock, step_done);
+        } else if (!stepFinished.wait_for(lock, std::chrono::milliseconds(timeoutMs), step_done)) {
+            return false;
+        }
+    }
+    if (stepIndex >= steps.size()) {
+        closed.store(true);
+        return false;
+    }
+
+    const Step &step = steps[stepIndex];
+    if (keyIndex == 0) {
+        // frames/bytes hold the counters at step start until present() turns them into deltas.
+        current = StepTiming{step.description, step.keys.size(), {}, frameCount, byteCount};
+        currentStart = Clock::now();
+    }
+    key = step.keys[keyIndex++];
+    ++keysHanded;
+    return true;
+}
+
+void ScriptDriver::present(const std::string &bytes, uint64_t inputSequence) {
+    inner->present(bytes, inputSequence);
+
+    std::lock_guard lock(mutex);
+    ++frameCount;
+    byteCount += bytes.size();
+    lastPresent = Clock::now();
+    bool is_step_out = stepIndex < steps.size() && keyIndex == steps[stepIndex].keys.size();
+    if (is_step_out && inputSequence >= keysHanded) {
+        current.elapsed = lastPresent - currentStart;
+        current.frames = frameCount - current.frames;
+        current.bytes = byteCount - current.bytes;
+        results.push_back(current);
+        ++stepIndex;
+        keyIndex = 0;
+        stepFinished.notify_all();
+    }
+}
+
+std::vector<ScriptDriver::StepTiming> ScriptDriver::timings() const {
+    std::lock_guard lock(mutex);
+    std::vector<StepTiming> timings = results;
+    if (stepIndex < steps.size() && keyIndex > 0) {
+        StepTiming partial = current;
+        partial.elapsed = (lastPresent > currentStart) ? lastPresent - currentStart : Clock::duration{};
+        partial.frames = frameCount - current.frames;
+        partial.bytes = byteCount - current.bytes;
+        timings.push_back(partial);
+    }
+    return timings;
+}
+#endif // __unix__
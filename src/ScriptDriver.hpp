@@ -0,0 +1,81 @@
+// ScriptDriver.hpp
+#ifdef __unix__
+#pragma once
+#include "IInputSource.hpp"
+#include "IOutputSink.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+namespace fs = std::filesystem;
+
+// Replays a keystroke script through the regular selector session, without a terminal.
+// It is both the session's input source and a wrapper around its output sink: the keys of
+// a step are only handed out once the frame for the previous step has been presented, so
+// every run takes the same path and each step can be timed from first key to painted frame.
+//
+// Script format, one step per line ('#' starts a comment):
+//   keys <keys>      raw keys; <up> <down> <left> <right> <home> <end> <enter> <esc>
+//                    <space> <bs> <del> <tab> <btab> <pgup> <pgdn> name special keys,
+//                    e.g. "keys jjj<right>"
+//   command <text>   command mode, same as typing ':' <text> <enter>
+//   number <text>    number mode, same as typing <text> <enter>, e.g. "number 1-5,8"
+//   quit             finish the selection
+class ScriptDriver : public IInputSource, public IOutputSink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Step {
+        std::string description;
+        std::vector<int> keys;
+    };
+    struct StepTiming {
+        std::string description;
+        size_t keyCount{0};
+        Clock::duration elapsed{};
+        uint64_t frames{0};
+        uint64_t bytes{0};
+    };
+
+    static std::vector<Step> parse(std::istream &script);
+    static std::vector<Step> load(const fs::path &scriptFile);
+
+    ScriptDriver(std::vector<Step> steps, std::shared_ptr<IOutputSink> inner);
+
+    bool readKey(int &key, int timeoutMs) override;
+    bool isInputClosed() const override { return closed.load(); }
+
+    size_t screenRows() const override { return inner->screenRows(); }
+    void present(const std::string &bytes, uint64_t inputSequence) override;
+
+    // Per-step results of the replay so far; a step cut short by the end of the session
+    // is reported up to the last presented frame.
+    std::vector<StepTiming> timings() const;
+
+private:
+    std::vector<Step> steps;
+    std::shared_ptr<IOutputSink> inner;
+
+    mutable std::mutex mutex;
+    std::condition_variable stepFinished;
+    size_t stepIndex{0};
+    size_t keyIndex{0};
+    uint64_t keysHanded{0};
+    uint64_t frameCount{0};
+    uint64_t byteCount{0};
+    Clock::time_point lastPresent{};
+    StepTiming current{};
+    Clock::time_point currentStart{};
+    std::vector<StepTiming> results;
+    std::atomic<bool> closed{false};
+
+    static std::vector<int> parseKeys(const std::string &spec);
+};
+#endif // __unix__
@@ -0,0 +1,49 @@
+// SelectionPolicy.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fmt/core.h>
+
+// How many files a selection takes. A policy is a template argument of SelectorSession and of the
+// CommandProcessor calls that select, so each policy gets its own code and the checks it does not
+// need (the bound of an unbounded selection, the minimum of one without) compile away.
+//  - is_replacing: selecting a file while the selection is full replaces the selected one;
+//    otherwise it is refused with a message.
+//  - is_bounded:   maximum() can be reached.
+//  - maximum(), minimum(): the selection can only be finished with none or at least minimum() files.
+
+// Any number of files (selectMultipleFile).
+struct MultipleSelection {
+    static constexpr bool is_replacing = false;
+    static constexpr bool is_bounded = false;
+    constexpr size_t maximum() const { return SIZE_MAX; }
+    constexpr size_t minimum() const { return 0; }
+    std::string describe(size_t count) const { return fmt::format("Selected: {} files", count); }
+};
+
+// One file, which the next one selected replaces (selectSingleFile).
+struct SingleSelection {
+    static constexpr bool is_replacing = true;
+    static constexpr bool is_bounded = true;
+    constexpr size_t maximum() const { return 1; }
+    constexpr size_t minimum() const { return 0; }
+    std::string describe(size_t count) const { return count ? "Selected file:" : "No file selected"; }
+};
+
+// Up to, or exactly, a number of files (selectUpTo, selectExactly), e.g. two files to diff.
+struct BoundedSelection {
+    static constexpr bool is_replacing = false;
+    static constexpr bool is_bounded = true;
+    size_t least{0};
+    size_t most{1};
+    constexpr size_t maximum() const { return most; }
+    constexpr size_t minimum() const { return least; }
+    std::string describe(size_t count) const {
+        return least == most ? fmt::format("Selected: {} of {} files", count, most)
+                             : fmt::format("Selected: {} of up to {} files", count, most);
+    }
+};
+#endif // __unix__
@@ -0,0 +1,442 @@
+// SelectorSession.cpp
+#ifdef __unix__
+#include "SelectorSession.hpp"
+#include "AllocTracker.hpp"
+#include "DeadlineExecutor.hpp"
+#include "DirectoryStats.hpp"
+#include "KeyEnum.hpp"
+#include "ListingCache.hpp"
+#include "Tracer.hpp"
+
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <fmt/core.h>
+
+// How often the input thread wakes up to check for shutdown.
+constexpr int input_poll_interval_ms = 50;
+
+template <typename Policy>
+SelectorSession<Policy>::SelectorSession(FileSystemManager &fsMgr, CommandProcessor &cmdProc, Policy policy,
+                                         IInputSource &input, IOutputSink &output)
+    : fsManager(fsMgr), cmdProcessor(cmdProc), policy(policy), input(input), output(output) {
+    uiRenderer.setKeymap(cmdProcessor.getKeymap()); // Before the render thread starts
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::run() {
+    std::thread input_thread(&SelectorSession::inputLoop, this);
+    std::thread render_thread(&SelectorSession::renderLoop, this);
+
+    // Arriving candidates and tree listings wake the model like a key press does.
+    fsManager.setOnBackgroundChange([this] {
+        keysPushed.fetch_add(1, std::memory_order_release);
+        keysPushed.notify_one();
+    });
+    std::exception_ptr failure;
+    try {
+        modelLoop();
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    fsManager.setOnBackgroundChange({});
+    previewer.reset();
+
+    isStopping.store(true);
+    framesPublished.fetch_add(1);
+    framesPublished.notify_one();
+    render_thread.join();
+    output.present(uiRenderer.endSession(), keysConsumed);
+    input_thread.join(); // Notices isStopping within one poll interval
+    Tracer::instance().flush();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::recordTo(SessionState &state, std::vector<std::string> commandHistory) {
+    sessionState = &state;
+    lineEditor.setHistory(std::move(commandHistory));
+}
+
+// ---------------------------------------------------------------- input thread
+
+template <typename Policy>
+void SelectorSession<Policy>::inputLoop() {
+    AllocScope alloc_scope(AllocTracker::Input);
+    while (!isStopping.load()) {
+        int key = KEY_NULL;
+        if (!input.readKey(key, input_poll_interval_ms)) {
+            if (input.isInputClosed()) {
+                isInputClosed.store(true);
+                keysPushed.fetch_add(1);
+                keysPushed.notify_one();
+                return;
+            }
+            continue;
+        }
+        const KeyEvent event{key, FrameSnapshot::Clock::now()};
+        while (!keyQueue.push(event)) {
+            if (isStopping.load()) {
+                return;
+            }
+            std::this_thread::yield(); // The model is behind by a whole queue, let it catch up.
+        }
+        keysPushed.fetch_add(1, std::memory_order_release);
+        keysPushed.notify_one();
+    }
+}
+
+// ---------------------------------------------------------------- model thread
+
+template <typename Policy>
+void SelectorSession<Policy>::modelLoop() {
+    // Main loop – run until the CommandProcessor signals to quit.
+    while (!cmdProcessor.shouldQuit()) {
+        // Loaded before looking for arrivals, so an arrival after the look still wakes the wait below.
+        uint64_t seen = keysPushed.load(std::memory_order_acquire);
+        if (fsManager.hasBackgroundChanges()) {
+            isListingStale = true;
+        }
+        refreshIfStale();
+        publishFrame();
+        fsManager.prefetchNeighbours(cmdProcessor.getCursor());
+
+        // Wait for a key press, then drain all typeahead before publishing the next frame.
+        if (keyQueue.empty()) {
+            if (isInputClosed.load()) {
+                return;
+            }
+            keysPushed.wait(seen);
+        }
+
+        TraceSpan trace_span(Tracer::InputHandling);
+        AllocScope alloc_scope(AllocTracker::Commands);
+        int cursor_delta = 0;
+        while (!cmdProcessor.shouldQuit()) {
+            auto event = keyQueue.pop();
+            if (!event) {
+                break;
+            }
+            ++keysConsumed;
+            if (oldestPendingKey == FrameSnapshot::Clock::time_point{}) {
+                oldestPendingKey = event->time;
+            }
+            if (pager.isActive()) {
+                pager.handleKey(event->key, pagerRows.load(std::memory_order_relaxed));
+                continue;
+            }
+            if (lineEditor.isActive()) {
+                handleLineKey(event->key);
+                continue;
+            }
+            if (int step = cmdProcessor.motionDelta(event->key)) {
+                // Fold runs of repeated motions into one net cursor move.
+                cursor_delta += step;
+                continue;
+            }
+            applyCursorDelta(cursor_delta);
+            cursor_delta = 0;
+            handleKey(event->key);
+        }
+        applyCursorDelta(cursor_delta);
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::applyCursorDelta(int delta) {
+    // Moves wrap around the listing, so a key that changed directory must have its listing in first.
+    if (delta != 0) {
+        refreshIfStale();
+        cmdProcessor.moveCursor(delta);
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::refreshIfStale() {
+    // The listing only needs a rescan after keys that may change it; pure cursor motion reuses it.
+    if (isListingStale) {
+        fsManager.refreshDirectory(cmdProcessor.isShowHidden);
+        isListingStale = false;
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::handleKey(int key) {
+    refreshIfStale();
+    isListingStale = true;
+    try {
+        if (key == ':') {
+            isNumberLine = false;
+            lineEditor.begin("Command :", "", [this](const std::string &line, size_t cursor) {
+                return commandCompleter.complete(line, cursor);
+            });
+            // Most completions are in the current directory; have its listing ready by the first Tab.
+            fsManager.preloadListing(fsManager.getCurrentDirectory(), CommandCompleter::listingOptions(false));
+        } else if (key >= '0' && key <= '9') {
+            isNumberLine = true;
+            lineEditor.begin("Number ", std::string(1, static_cast<char>(key)));
+        } else if (auto result = cmdProcessor.processImmediateInput(key, policy); !result) {
+            errorMessage = result.error().message;
+        }
+    } catch (std::invalid_argument &e) {
+        errorMessage = e.what();
+    } catch (std::runtime_error &e) {
+        errorMessage = e.what();
+    }
+    checkQuit();
+    openRequestedPager();
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::handleLineKey(int key) {
+    if (lineEditor.handleKey(key) != LineEditor::Status::Accepted) {
+        return;
+    }
+    if (sessionState) {
+        sessionState->recordCommand(lineEditor.buffer());
+    }
+    refreshIfStale();
+    isListingStale = true;
+    try {
+        if (!isNumberLine) {
+            cmdProcessor.processCommandInput(lineEditor.buffer(), policy);
+        } else {
+            cmdProcessor.processNumberInput(lineEditor.buffer(), policy);
+        }
+    } catch (std::invalid_argument &e) {
+        errorMessage = e.what();
+    } catch (std::runtime_error &e) {
+        errorMessage = e.what();
+    }
+    checkQuit();
+    openRequestedPager();
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::checkQuit() {
+    if (cmdProcessor.shouldQuit()) {
+        if (auto finish = cmdProcessor.checkFinish(policy); !finish) {
+            errorMessage = finish.error().message;
+        }
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::openRequestedPager() {
+    using PagerView = CommandProcessor::PagerView;
+    const PagerView requested = std::exchange(cmdProcessor.requestedPager, PagerView::None);
+    switch (requested) {
+    case PagerView::Help:
+        pager.open("Help", UIRenderer::fullHelp(cmdProcessor.getKeymap()));
+        break;
+    case PagerView::Selection: {
+        auto lines = std::make_shared<std::vector<std::string>>();
+        for (const auto &path : cmdProcessor.getSelectedPaths()) {
+            lines->push_back(path.string());
+        }
+        std::string title = fmt::format("Selected: {} files", lines->size());
+        pager.open(std::move(title), std::move(lines));
+        break;
+    }
+    case PagerView::Stats:
+        pagedStats = DirectoryStats::instance().breakdown(fsManager.getCurrentDirectory());
+        pager.open(fmt::format("Contents of {}", fsManager.getCurrentDirectory().string()), statsPagerLines());
+        break;
+    case PagerView::None:
+        return;
+    }
+    pagerView = requested;
+}
+
+template <typename Policy>
+Pager::Lines SelectorSession<Policy>::statsPagerLines() const {
+    const bool is_counting = DirectoryStats::instance().isWalking(fsManager.getCurrentDirectory());
+    return std::make_shared<const std::vector<std::string>>(
+        UIRenderer::statsLines(pagedStats.get(), is_counting, SIZE_MAX));
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::updateStatsPager() {
+    auto stats = DirectoryStats::instance().breakdown(fsManager.getCurrentDirectory());
+    if (stats != pagedStats) {
+        pagedStats = std::move(stats);
+        pager.update(statsPagerLines());
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::publishFrame() {
+    Tracer::instance().setHudVisible(cmdProcessor.isShowPerfHud);
+    if (sessionState) {
+        sessionState->update(fsManager.getCurrentDirectory(), cmdProcessor.getCursor(), fsManager.getFilters(),
+                             fsManager.getSortPolicy(), fsManager.searchName);
+    }
+
+    auto snapshot = std::make_unique<FrameSnapshot>();
+    snapshot->inputSequence = keysConsumed;
+    snapshot->oldestKeyTime = oldestPendingKey;
+    snapshot->location = fsManager.getLocationLabel();
+    snapshot->listingProblem = fsManager.getListingProblem();
+    snapshot->expandProblem = fsManager.getExpandProblem();
+    snapshot->isSlowFilesystem = DeadlineExecutor::instance().isSlow();
+    snapshot->isCandidateList = fsManager.isCandidateList();
+    snapshot->filters = fsManager.getFilters();
+    snapshot->searchName = fsManager.searchName;
+    snapshot->isShowHidden = cmdProcessor.isShowHidden;
+    snapshot->isShowHint = cmdProcessor.isShowHint;
+    snapshot->isShowSelected = cmdProcessor.isShowSelected;
+    snapshot->isShowPerfHud = cmdProcessor.isShowPerfHud;
+    snapshot->isShowPreview = cmdProcessor.isShowPreview;
+    if (snapshot->isShowPreview) {
+        addPreview(*snapshot);
+    }
+    snapshot->isShowStats = cmdProcessor.isShowStats;
+    if (snapshot->isShowStats) {
+        snapshot->stats = DirectoryStats::instance().breakdown(fsManager.getCurrentDirectory());
+        snapshot->isCountingStats = DirectoryStats::instance().isWalking(fsManager.getCurrentDirectory());
+    }
+    snapshot->entries = fsManager.shareEntries();
+    snapshot->isTreeView = fsManager.isTreeView();
+    snapshot->treeRows = fsManager.shareTreeRows();
+    snapshot->cursor = cmdProcessor.getCursor();
+    snapshot->selectedPaths = cmdProcessor.shareSelectedPaths();
+    snapshot->selectionTitle = policy.describe(snapshot->selectedPaths->size());
+    snapshot->errorMessage = std::move(errorMessage);
+    errorMessage.clear();
+    snapshot->isEditingLine = lineEditor.isActive();
+    if (snapshot->isEditingLine) {
+        snapshot->linePrompt = lineEditor.prompt();
+        snapshot->lineBuffer = lineEditor.buffer();
+        snapshot->lineCursor = lineEditor.cursor();
+        snapshot->completion = lineEditor.completion();
+        snapshot->completionIndex = lineEditor.completionIndex();
+    }
+    if (pager.isActive()) {
+        if (pagerView == CommandProcessor::PagerView::Stats) {
+            updateStatsPager();
+        }
+        snapshot->pagerTitle = pager.title();
+        snapshot->pagerLines = pager.content();
+        snapshot->pagerTop = pager.top();
+    }
+
+    frameMailbox.publish(std::move(snapshot));
+    oldestPendingKey = {};
+    framesPublished.fetch_add(1, std::memory_order_release);
+    framesPublished.notify_one();
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::addPreview(FrameSnapshot &snapshot) {
+    const size_t cursor = cmdProcessor.getCursor();
+    if (cursor >= fsManager.entryCount()) {
+        return;
+    }
+    const auto &entry = fsManager.entryAt(cursor);
+    std::error_code ec;
+    if (!entry.is_regular_file(ec)) {
+        return;
+    }
+    if (!previewer) {
+        // A finished read wakes the model like a key press does, so the next frame shows it.
+        previewer = std::make_unique<FilePreviewer>();
+        previewer->setOnReady([this] {
+            keysPushed.fetch_add(1, std::memory_order_release);
+            keysPushed.notify_one();
+        });
+    }
+    // Only asks; the read happens on the previewer's thread, so input is never held up by it.
+    previewer->request(entry.path());
+    snapshot.previewPath = entry.path();
+    snapshot.preview = previewer->find(entry.path());
+}
+
+// ---------------------------------------------------------------- render thread
+
+template <typename Policy>
+void SelectorSession<Policy>::renderLoop() {
+    AllocScope alloc_scope(AllocTracker::Render);
+    uint64_t seen = 0;
+    while (true) {
+        framesPublished.wait(seen, std::memory_order_acquire);
+        seen = framesPublished.load(std::memory_order_acquire);
+        if (isStopping.load()) {
+            return;
+        }
+        std::unique_ptr<FrameSnapshot> snapshot = frameMailbox.take();
+        if (!snapshot) {
+            continue;
+        }
+        try {
+            drawFrame(*snapshot);
+        } catch (...) {
+            // A frame that fails to draw is skipped, the next snapshot gets another try.
+        }
+    }
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::drawFrame(const FrameSnapshot &snapshot) {
+    uiRenderer.beginFrame(output.screenRows());
+    if (snapshot.pagerLines) {
+        // Drawn like any other frame, so scrolling only rewrites the lines that changed.
+        pagerRows.store(uiRenderer.drawPager(snapshot.pagerTitle, *snapshot.pagerLines, snapshot.pagerTop),
+                        std::memory_order_relaxed);
+        presentFrame(snapshot);
+        return;
+    }
+    uiRenderer.setShowFullPaths(snapshot.isCandidateList);
+    uiRenderer.drawHeader(snapshot.location, snapshot.filters, snapshot.isShowHidden,
+                          snapshot.searchName, snapshot.isShowHint, snapshot.isShowSelected);
+    uiRenderer.drawFilesystemStatus(snapshot.listingProblem, snapshot.expandProblem, snapshot.isSlowFilesystem);
+    if (!snapshot.errorMessage.empty()) {
+        uiRenderer.drawMessage(snapshot.errorMessage);
+    }
+    if (snapshot.isShowPreview && !snapshot.previewPath.empty()) {
+        uiRenderer.drawPreview(snapshot.previewPath, snapshot.preview.get());
+    }
+    if (snapshot.isShowStats) {
+        uiRenderer.drawStats(snapshot.stats.get(), snapshot.isCountingStats);
+    }
+    uiRenderer.drawFooter(*snapshot.selectedPaths, snapshot.isShowSelected, snapshot.selectionTitle);
+    if (snapshot.isShowPerfHud) {
+        const auto cache = ListingCache::instance().stats();
+        uiRenderer.drawHud(Tracer::instance().hudLine() +
+                           fmt::format(" | cache {} hit {} miss {:.1f}M", cache.hits, cache.misses,
+                                       static_cast<double>(cache.bytes) / (1024 * 1024)));
+    }
+    if (snapshot.completion) {
+        uiRenderer.drawCompletions(snapshot.completion->candidates, snapshot.completionIndex,
+                                   snapshot.completion->total);
+    }
+    if (snapshot.isEditingLine) {
+        uiRenderer.drawPrompt(snapshot.linePrompt, snapshot.lineBuffer, snapshot.lineCursor);
+    }
+    if (snapshot.isTreeView) {
+        uiRenderer.drawFileList(snapshot.treeRows, snapshot.cursor, *snapshot.selectedPaths);
+    } else {
+        uiRenderer.drawFileList(*snapshot.entries, snapshot.cursor, *snapshot.selectedPaths);
+    }
+    presentFrame(snapshot);
+}
+
+template <typename Policy>
+void SelectorSession<Policy>::presentFrame(const FrameSnapshot &snapshot) {
+    std::string frame = uiRenderer.endFrame();
+    {
+        TraceSpan trace_span(Tracer::Present);
+        output.present(frame, snapshot.inputSequence);
+    }
+    if (Tracer::isEnabled()) {
+        Tracer::instance().endFrame(snapshot.oldestKeyTime, Tracer::Clock::now());
+    }
+}
+
+template class SelectorSession<MultipleSelection>;
+template class SelectorSession<SingleSelection>;
+template class SelectorSession<BoundedSelection>;
+#endif // __unix__
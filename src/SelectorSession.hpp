@@ -0,0 +1,105 @@
+// SelectorSession.hpp
+#ifdef __unix__
+#pragma once
+#include "CommandCompleter.hpp"
+#include "CommandProcessor.hpp"
+#include "FilePreviewer.hpp"
+#include "FileSystemManager.hpp"
+#include "FrameSnapshot.hpp"
+#include "IInputSource.hpp"
+#include "IOutputSink.hpp"
+#include "LineEditor.hpp"
+#include "LockFreeQueue.hpp"
+#include "Pager.hpp"
+#include "SelectionPolicy.hpp"
+#include "SessionState.hpp"
+#include "UIRenderer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One interactive selection, pipelined over three threads:
+//  - input:  reads keys from the IInputSource and pushes them onto a lock-free queue,
+//  - model:  the calling thread; applies key batches to FileSystemManager/CommandProcessor
+//            and publishes an immutable FrameSnapshot after each batch,
+//  - render: draws the newest snapshot into the IOutputSink. Snapshots published while it is
+//            still writing the previous frame are dropped, so a slow terminal never builds a backlog.
+// Policy (SelectionPolicy.hpp) is how many files the selection takes; the session is compiled once
+// per policy (MultipleSelection, SingleSelection and BoundedSelection are instantiated).
+template <typename Policy>
+class SelectorSession {
+public:
+    SelectorSession(FileSystemManager &fsMgr, CommandProcessor &cmdProc, Policy policy,
+                    IInputSource &input, IOutputSink &output);
+
+    // Runs until the CommandProcessor signals to quit (or the input is closed).
+    void run();
+    // Records directory, cursor, filters, sort, search and accepted lines into state as they change,
+    // starting the line history from commandHistory. The selection is recorded by whoever owns it.
+    void recordTo(SessionState &state, std::vector<std::string> commandHistory);
+
+private:
+    struct KeyEvent {
+        int key{0};
+        FrameSnapshot::Clock::time_point time{};
+    };
+
+    FileSystemManager &fsManager;
+    CommandProcessor &cmdProcessor;
+    const Policy policy;
+
+    IInputSource &input;   // Only touched by the input thread (and the render thread while it is paused).
+    IOutputSink &output;   // Only touched by the render thread.
+    UIRenderer uiRenderer; // Only touched by the render thread.
+
+    // Input -> model
+    SpscQueue<KeyEvent, 4096> keyQueue;
+    std::atomic<uint64_t> keysPushed{0}; // Also bumped by anything else that should wake the model
+    std::atomic<bool> isInputClosed{false};
+    // Model -> render
+    LatestMailbox<FrameSnapshot> frameMailbox;
+    std::atomic<uint64_t> framesPublished{0};
+    // Render -> model: how many lines the pager showed last, the page size for its keys
+    std::atomic<size_t> pagerRows{0};
+
+    std::atomic<bool> isStopping{false};
+
+    // Model thread state
+    LineEditor lineEditor;
+    Pager pager;
+    CommandProcessor::PagerView pagerView{CommandProcessor::PagerView::None};
+    std::shared_ptr<const DirectoryStats::Breakdown> pagedStats; // What the stats pager shows
+    CommandCompleter commandCompleter{fsManager};
+    bool isNumberLine{false};
+    bool isListingStale{true};
+    std::string errorMessage{};
+    uint64_t keysConsumed{0};
+    FrameSnapshot::Clock::time_point oldestPendingKey{};
+    std::unique_ptr<FilePreviewer> previewer; // Started by the first preview
+    SessionState *sessionState{nullptr};
+
+    void inputLoop();
+    void renderLoop();
+    void modelLoop();
+
+    void handleKey(int key);
+    void handleLineKey(int key);
+    // Calls off a quit the policy does not allow yet, saying why.
+    void checkQuit();
+    void refreshIfStale();
+    // Applies folded cursor motion to the current listing, refreshed first if a key changed it.
+    void applyCursorDelta(int delta);
+    void publishFrame();
+    void addPreview(FrameSnapshot &snapshot);
+    void openRequestedPager();
+    Pager::Lines statsPagerLines() const;
+    // Rebuilds the stats pager when the counts have moved on.
+    void updateStatsPager();
+
+    void drawFrame(const FrameSnapshot &snapshot);
+    void presentFrame(const FrameSnapshot &snapshot);
+};
+#endif // __unix__
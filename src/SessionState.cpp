@@ -0,0 +1,288 @@
+// SessionState.cpp
+#ifdef __unix__
+#include "SessionState.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct SessionState::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t usedBytes; // The records end here; anything after is unused capacity
+    uint64_t cursor;
+};
+
+namespace {
+constexpr char state_magic[8] = {'F', 'S', 'E', 'L', 'S', 'T', 'A', 'T'};
+
+struct RecordHeader {
+    uint32_t kind;
+    uint32_t length;
+};
+
+std::string joined(const std::vector<std::string> &values) {
+    return fmt::format("{}", fmt::join(values, ","));
+}
+
+// Calls onRecord(kind, payload) for each complete record. The payloads are used as they are, nothing
+// is parsed. Returns false (without calling onRecord) for files that are not of this format version.
+template <typename OnRecord>
+bool forEachRecord(const char *data, size_t size, uint32_t version, size_t headerSize, OnRecord &&onRecord) {
+    struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t usedBytes;
+    } prefix{};
+    if (size < sizeof(prefix)) {
+        return false;
+    }
+    std::memcpy(&prefix, data, sizeof(prefix));
+    if (std::memcmp(prefix.magic, state_magic, sizeof(state_magic)) != 0 || prefix.version != version ||
+        prefix.headerSize != headerSize || prefix.usedBytes > size || prefix.usedBytes < headerSize) {
+        return false;
+    }
+    for (size_t offset = headerSize; offset + sizeof(RecordHeader) <= prefix.usedBytes;) {
+        RecordHeader record{};
+        std::memcpy(&record, data + offset, sizeof(record));
+        offset += sizeof(record);
+        if (record.length > prefix.usedBytes - offset) {
+            break; // Damaged; keep what was read up to here
+        }
+        onRecord(record.kind, std::string_view(data + offset, record.length));
+        offset += record.length;
+    }
+    return true;
+}
+} // namespace
+
+SessionState::SessionState(const fs::path &file) : file(file) {
+    State state;
+    int existing = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (existing >= 0) {
+        struct stat status {};
+        if (::fstat(existing, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(Header)) {
+            const size_t size = static_cast<size_t>(status.st_size);
+            void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, existing, 0);
+            if (data != MAP_FAILED) {
+                state = decode(static_cast<const char *>(data), size);
+                munmap(data, size);
+            }
+        }
+        ::close(existing);
+    }
+    rewrite(state);
+    opened = std::move(state);
+}
+
+SessionState::~SessionState() {
+    if (mapped) {
+        munmap(mapped, mappedSize);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+SessionState::State SessionState::read() {
+    if (opened) {
+        State state = std::move(*opened);
+        opened.reset();
+        state.cursor = static_cast<size_t>(header().cursor);
+        return state;
+    }
+    return decode(mapped, mappedSize);
+}
+
+std::optional<fs::path> SessionState::directory() const {
+    if (opened) {
+        return opened->directory;
+    }
+    std::optional<fs::path> directory;
+    std::string_view last;
+    const bool is_valid = forEachRecord(mapped, mappedSize, format_version, sizeof(Header),
+                                        [&last](uint32_t kind, std::string_view payload) {
+                                            if (static_cast<RecordKind>(kind) == RecordKind::Directory) {
+                                                last = payload;
+                                            }
+                                        });
+    if (is_valid && last.data()) {
+        directory = fs::path(last);
+    }
+    return directory;
+}
+
+SessionState::State SessionState::decode(const char *data, size_t size) {
+    State state;
+    std::deque<std::string> history;
+    const bool is_valid = forEachRecord(data, size, format_version, sizeof(Header),
+                                        [&](uint32_t kind, std::string_view payload) {
+        switch (static_cast<RecordKind>(kind)) {
+        case RecordKind::Directory:
+            state.directory = fs::path(payload);
+            break;
+        case RecordKind::Filters:
+            state.filters = std::string(payload);
+            break;
+        case RecordKind::SortPolicy:
+            state.sortPolicy = std::string(payload);
+            break;
+        case RecordKind::SearchName:
+            state.searchName = std::string(payload);
+            break;
+        case RecordKind::Command:
+            history.emplace_back(payload);
+            if (history.size() > max_command_history) {
+                history.pop_front();
+            }
+            break;
+        case RecordKind::Select:
+            // A rewritten file lists the selection in order, so the hint makes each insert O(1).
+            state.selection.emplace_hint(state.selection.end(), payload);
+            break;
+        case RecordKind::Deselect:
+            state.selection.erase(fs::path(payload));
+            break;
+        default:
+            break; // Written by a newer version; skipped
+        }
+    });
+    if (is_valid) {
+        Header header{};
+        std::memcpy(&header, data, sizeof(header));
+        state.cursor = static_cast<size_t>(header.cursor);
+    }
+    state.commandHistory.assign(std::make_move_iterator(history.begin()), std::make_move_iterator(history.end()));
+    return state;
+}
+
+void SessionState::rewrite(const State &state) {
+    // Written next to the file and renamed over it, so a crash leaves either the old or the new one.
+    if (file.has_parent_path()) {
+        std::error_code ec;
+        fs::create_directories(file.parent_path(), ec);
+    }
+    const fs::path temporary = file.string() + ".tmp";
+    fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("Failed to create session state {}: {}", temporary.string(),
+                                             std::strerror(errno)));
+    }
+    if (!reserve(initial_capacity)) {
+        throw std::runtime_error(fmt::format("Failed to map session state {}", temporary.string()));
+    }
+    Header &new_header = header();
+    std::memcpy(new_header.magic, state_magic, sizeof(state_magic));
+    new_header.version = format_version;
+    new_header.headerSize = sizeof(Header);
+    new_header.usedBytes = sizeof(Header);
+    new_header.cursor = state.cursor;
+
+    if (state.directory) {
+        append(RecordKind::Directory, state.directory->native());
+        recordedDirectory = *state.directory;
+    }
+    if (state.filters) {
+        append(RecordKind::Filters, *state.filters);
+        recordedFilters = *state.filters;
+    }
+    if (state.sortPolicy) {
+        append(RecordKind::SortPolicy, *state.sortPolicy);
+        recordedSortPolicy = *state.sortPolicy;
+    }
+    if (state.searchName) {
+        append(RecordKind::SearchName, *state.searchName);
+        recordedSearchName = *state.searchName;
+    }
+    for (const auto &line : state.commandHistory) {
+        append(RecordKind::Command, line);
+    }
+    for (const auto &path : state.selection) {
+        append(RecordKind::Select, path.native());
+    }
+    if (isFailed || ::rename(temporary.c_str(), file.c_str()) != 0) {
+        throw std::runtime_error(fmt::format("Failed to write session state {}", file.string()));
+    }
+}
+
+void SessionState::update(const fs::path &directory, size_t cursor, const std::vector<std::string> &filters,
+                          const std::vector<std::string> &sortPolicy, const std::string &searchName) {
+    if (isFailed) {
+        return;
+    }
+    header().cursor = cursor; // Fixed place in the header, so moving the cursor never grows the file
+    if (directory != recordedDirectory) {
+        recordedDirectory = directory;
+        append(RecordKind::Directory, directory.native());
+    }
+    if (std::string value = joined(filters); value != recordedFilters) {
+        recordedFilters = std::move(value);
+        append(RecordKind::Filters, recordedFilters);
+    }
+    if (std::string value = joined(sortPolicy); value != recordedSortPolicy) {
+        recordedSortPolicy = std::move(value);
+        append(RecordKind::SortPolicy, recordedSortPolicy);
+    }
+    if (searchName != recordedSearchName) {
+        recordedSearchName = searchName;
+        append(RecordKind::SearchName, searchName);
+    }
+}
+
+void SessionState::recordSelection(const fs::path &path, bool isSelected) {
+    append(isSelected ? RecordKind::Select : RecordKind::Deselect, path.native());
+}
+
+void SessionState::recordCommand(const std::string &line) {
+    append(RecordKind::Command, line);
+}
+
+void SessionState::append(RecordKind kind, std::string_view payload) {
+    const size_t record_size = sizeof(RecordHeader) + payload.size();
+    if (isFailed || payload.size() > UINT32_MAX || !reserve(header().usedBytes + record_size)) {
+        isFailed = true;
+        return;
+    }
+    opened.reset();
+    char *end = mapped + header().usedBytes;
+    const RecordHeader record{static_cast<uint32_t>(kind), static_cast<uint32_t>(payload.size())};
+    std::memcpy(end, &record, sizeof(record));
+    std::memcpy(end + sizeof(record), payload.data(), payload.size());
+    // Counted only once it is complete, so a crash in between leaves the record out.
+    header().usedBytes += record_size;
+}
+
+bool SessionState::reserve(size_t bytes) {
+    if (bytes <= mappedSize) {
+        return true;
+    }
+    const size_t new_size = std::max({bytes, 2 * mappedSize, initial_capacity});
+    if (::ftruncate(fd, static_cast<off_t>(new_size)) != 0) {
+        return false;
+    }
+    void *data = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    if (mapped) {
+        munmap(mapped, mappedSize);
+    }
+    mapped = static_cast<char *>(data);
+    mappedSize = new_size;
+    return true;
+}
+
+SessionState::Header &SessionState::header() const {
+    return *reinterpret_cast<Header *>(mapped);
+}
+#endif // __unix__
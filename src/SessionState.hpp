@@ -0,0 +1,87 @@
+// SessionState.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace fs = std::filesystem;
+
+// The state of a selection session, kept in a memory-mapped file so the next session can resume it.
+// The file is a fixed header (magic, format version, cursor) followed by a log of binary records,
+// each a kind, a length and a payload. Changes are appended as they happen, so recording a session
+// costs a memcpy per change and no rewrite. Opening the file replays the log and writes it out again
+// compactly, so it does not grow from one session to the next.
+// One session per file at a time: a second one started on the same file takes it over.
+class SessionState {
+public:
+    static constexpr uint32_t format_version = 1;
+    static constexpr size_t max_command_history = 500;
+
+    // What a file holds; the optional fields are empty when they were never recorded.
+    struct State {
+        std::optional<fs::path> directory;
+        size_t cursor{0};
+        std::optional<std::string> filters;    // As given to :filter
+        std::optional<std::string> sortPolicy; // As given to :sort
+        std::optional<std::string> searchName;
+        std::vector<std::string> commandHistory; // Oldest first
+        std::set<fs::path> selection;
+    };
+
+    // Reads file (a missing, damaged or other-version file counts as empty) and rewrites it compactly.
+    // Throws std::runtime_error when the file cannot be written or mapped.
+    explicit SessionState(const fs::path &file);
+    ~SessionState();
+    SessionState(const SessionState &) = delete;
+    SessionState &operator=(const SessionState &) = delete;
+
+    // Everything recorded so far, including the changes of the current session. The first call
+    // hands over what was decoded on opening, unless something was recorded since.
+    State read();
+    // Just the directory of read(), without building the rest.
+    std::optional<fs::path> directory() const;
+
+    // Records the values that differ from the ones recorded last; nothing is written otherwise.
+    void update(const fs::path &directory, size_t cursor, const std::vector<std::string> &filters,
+                const std::vector<std::string> &sortPolicy, const std::string &searchName);
+    void recordSelection(const fs::path &path, bool isSelected);
+    void recordCommand(const std::string &line);
+
+private:
+    enum class RecordKind : uint32_t {
+        Directory = 1,
+        Filters,
+        SortPolicy,
+        SearchName,
+        Command,
+        Select,
+        Deselect
+    };
+    struct Header;
+
+    static constexpr size_t initial_capacity = 64 * 1024;
+
+    fs::path file;
+    int fd{-1};
+    char *mapped{nullptr};
+    size_t mappedSize{0};
+    bool isFailed{false}; // After a failed write nothing more is recorded; the session goes on
+    std::optional<State> opened; // Decoded on opening; dropped once it is out of date
+
+    fs::path recordedDirectory;
+    std::string recordedFilters;    // Joined with commas, like the payload
+    std::string recordedSortPolicy;
+    std::string recordedSearchName;
+
+    static State decode(const char *data, size_t size);
+    void rewrite(const State &state);
+    void append(RecordKind kind, std::string_view payload);
+    bool reserve(size_t bytes);
+    Header &header() const;
+};
+#endif // __unix__
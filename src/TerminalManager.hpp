@@ -1,27 +1,31 @@
 // TerminalManager.hpp
 #pragma once
 #ifdef __unix__
-#include <string>
-#include <vector>
+#include "IInputSource.hpp"
+#include "InputDecoder.hpp"
 
 #include <termios.h>
 #include <unistd.h>
 
-class TerminalManager {
+class TerminalManager : public IInputSource {
 public:
-    TerminalManager();
-    ~TerminalManager();
+    // fd is the terminal to read keys from; /dev/tty when stdin carries data.
+    explicit TerminalManager(int fd = STDIN_FILENO);
+    ~TerminalManager() override;
 
     void setRawMode();
     void setCanonicalMode();
     void restoreTerminal();
-    int readKey(); // mapping of raw key input to our enum keys
-    std::string getLineByChar();
+    // Mapping of raw key input to our enum keys. Waits at most timeoutMs (-1: forever),
+    // keys already pending (typeahead) are returned immediately.
+    bool readKey(int &key, int timeoutMs) override;
+    bool isInputClosed() const override { return inputClosed && !decoder.hasIncomplete(); }
     // (Windows version will use a different approach and may be handled elsewhere)
 private:
+    int fd;
     termios originalTermios{};
-    std::vector<std::string> commandHistory{};
-    unsigned int historyPosition{0};
-    void writeBuffer(std::string &buffer, size_t &cursor_pos, int ch);
+    InputDecoder decoder{};
+    bool inputClosed{false};
+    bool fillDecoder(int timeoutMs);
 };
-#endif // __unix__
\ No newline at end of file
+#endif // __unix__
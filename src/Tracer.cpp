@@ -0,0 +1,124 @@
+// Tracer.cpp
+#include "Tracer.hpp"
+#include "AllocTracker.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <fmt/core.h>
+#include <fmt/os.h>
+
+namespace {
+constexpr const char *span_names[Tracer::SpanCount] = {
+    "refreshDirectory", "sortEntries", "search", "inputHandling",
+    "drawHeader", "drawFileList", "drawFooter", "drawMessage", "drawPrompt",
+    "endFrame", "present", "prefetch", "preview"};
+
+uint32_t currentThreadNumber() {
+    static std::atomic<uint32_t> next_thread{1};
+    thread_local const uint32_t thread_number = next_thread.fetch_add(1);
+    return thread_number;
+}
+
+double toMs(uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+} // namespace
+
+Tracer &Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+// FILESELECTOR_TRACE is read at load time, so spans before the first instance() call are kept too.
+static const bool is_tracer_initialized = (Tracer::instance(), true);
+
+Tracer::Tracer() {
+    if (const char *path = std::getenv("FILESELECTOR_TRACE"); path && *path) {
+        traceFile = path;
+        enabled.store(true);
+    }
+}
+
+void Tracer::setHudVisible(bool visible) {
+    enabled.store(visible || !traceFile.empty(), std::memory_order_relaxed);
+}
+
+void Tracer::record(Span span, Clock::time_point start, Clock::time_point end) {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    pendingNs[span].fetch_add(static_cast<uint64_t>(duration), std::memory_order_relaxed);
+    if (traceFile.empty()) {
+        return;
+    }
+    using std::chrono::microseconds;
+    Event event{span, currentThreadNumber(),
+                std::chrono::duration_cast<microseconds>(start - origin).count(),
+                std::chrono::duration_cast<microseconds>(end - start).count()};
+    std::lock_guard lock(mutex);
+    if (events.size() < max_events) {
+        events.push_back(event);
+    } else {
+        ++droppedEvents;
+    }
+}
+
+void Tracer::endFrame(Clock::time_point keyTime, Clock::time_point paintTime) {
+    for (size_t span = 0; span < SpanCount; ++span) {
+        lastFrameNs[span] = pendingNs[span].exchange(0, std::memory_order_relaxed);
+    }
+    if (keyTime != Clock::time_point{}) {
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(paintTime - keyTime).count();
+        latencyNs[latencyCount++ % latency_samples] = static_cast<uint64_t>(latency);
+    }
+    const uint64_t allocations = AllocTracker::allocationCount();
+    lastFrameAllocations = allocations - allocationsAtFrameEnd;
+    allocationsAtFrameEnd = allocations;
+}
+
+std::string Tracer::hudLine() const {
+    const auto &f = lastFrameNs;
+    std::string line = fmt::format(
+        "refresh {:.2f} sort {:.2f} search {:.2f} input {:.2f} | header {:.2f} list {:.2f} footer {:.2f} "
+        "diff {:.2f} write {:.2f} ms",
+        toMs(f[RefreshDirectory]), toMs(f[SortEntries]), toMs(f[Search]), toMs(f[InputHandling]),
+        toMs(f[DrawHeader]), toMs(f[DrawFileList]), toMs(f[DrawFooter] + f[DrawMessage] + f[DrawPrompt]),
+        toMs(f[EndFrame]), toMs(f[Present]));
+
+    const size_t count = std::min(latencyCount, latency_samples);
+    if (count == 0) {
+        line += " | key→paint -";
+    } else {
+        std::vector<uint64_t> samples(latencyNs.begin(), latencyNs.begin() + count);
+        auto percentile = [&samples](size_t p) {
+            auto nth = samples.begin() + (samples.size() - 1) * p / 100;
+            std::nth_element(samples.begin(), nth, samples.end());
+            return toMs(*nth);
+        };
+        line += fmt::format(" | key→paint p50 {:.1f} p99 {:.1f} ms (last {})", percentile(50), percentile(99), count);
+    }
+
+    if (AllocTracker::isCompiledIn()) {
+        line += fmt::format(" | allocs {} live", lastFrameAllocations);
+        for (size_t i = 0; i < AllocTracker::SubsystemCount; ++i) {
+            auto subsystem = static_cast<AllocTracker::Subsystem>(i);
+            line += fmt::format(" {} {:.1f}K", AllocTracker::name(subsystem),
+                                static_cast<double>(AllocTracker::liveBytes(subsystem)) / 1024);
+        }
+    }
+    return line + fmt::format(" | peak rss {:.1f}M", static_cast<double>(AllocTracker::peakRssKb()) / 1024);
+}
+
+void Tracer::flush() {
+    if (traceFile.empty()) {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    auto out = fmt::output_file(traceFile);
+    out.print("{{\"displayTimeUnit\": \"ms\", \"otherData\": {{\"droppedEvents\": {}}}, \"traceEvents\": [\n", droppedEvents);
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event &e = events[i];
+        out.print("{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {}, \"dur\": {}}}{}\n",
+                  span_names[e.span], e.thread, e.startUs, e.durationUs, i + 1 < events.size() ? "," : "");
+    }
+    out.print("]}}\n");
+}
@@ -0,0 +1,198 @@
+// TreeRows.cpp
+#ifdef __unix__
+#include "TreeRows.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdexcept>
+
+struct TreeRows::Node {
+    std::shared_ptr<const Row> row; // Shared between versions, so path copies do not copy paths
+    NodePtr left;
+    NodePtr right;
+    uint32_t priority{0};
+    uint32_t minDepth{0}; // Of the whole subtree, to find where a subtree of the tree view ends
+    size_t size{1};
+};
+
+namespace {
+uint32_t randomPriority() {
+    thread_local std::minstd_rand generator{0x7265u};
+    return static_cast<uint32_t>(generator());
+}
+} // namespace
+
+TreeRows::TreeRows(std::vector<Row> rows) {
+    std::vector<std::shared_ptr<const Row>> shared_rows;
+    shared_rows.reserve(rows.size());
+    for (auto &row : rows) {
+        shared_rows.push_back(std::make_shared<const Row>(std::move(row)));
+    }
+    // Handing out priorities in descending order in pre-order keeps the heap property
+    // of a treap while building it balanced.
+    std::vector<uint32_t> priorities(shared_rows.size());
+    std::generate(priorities.begin(), priorities.end(), randomPriority);
+    std::sort(priorities.begin(), priorities.end(), std::greater<>());
+    size_t next_priority = 0;
+    root = build(shared_rows, 0, shared_rows.size(), priorities, next_priority);
+}
+
+size_t TreeRows::nodeSize(const NodePtr &node) {
+    return node ? node->size : 0;
+}
+
+TreeRows::NodePtr TreeRows::makeNode(std::shared_ptr<const Row> row, NodePtr left, NodePtr right, uint32_t priority) {
+    auto node = std::make_shared<Node>();
+    node->minDepth = row->depth;
+    node->size = 1 + nodeSize(left) + nodeSize(right);
+    if (left) {
+        node->minDepth = std::min(node->minDepth, left->minDepth);
+    }
+    if (right) {
+        node->minDepth = std::min(node->minDepth, right->minDepth);
+    }
+    node->row = std::move(row);
+    node->left = std::move(left);
+    node->right = std::move(right);
+    node->priority = priority;
+    return node;
+}
+
+TreeRows::NodePtr TreeRows::build(const std::vector<std::shared_ptr<const Row>> &rows, size_t first, size_t last,
+                                  const std::vector<uint32_t> &priorities, size_t &nextPriority) {
+    if (first == last) {
+        return nullptr;
+    }
+    const size_t middle = first + (last - first) / 2;
+    const uint32_t priority = priorities[nextPriority++];
+    NodePtr left = build(rows, first, middle, priorities, nextPriority);
+    NodePtr right = build(rows, middle + 1, last, priorities, nextPriority);
+    return makeNode(rows[middle], std::move(left), std::move(right), priority);
+}
+
+TreeRows::NodePtr TreeRows::merge(const NodePtr &left, const NodePtr &right) {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    if (left->priority > right->priority) {
+        return makeNode(left->row, left->left, merge(left->right, right), left->priority);
+    }
+    return makeNode(right->row, merge(left, right->left), right->right, right->priority);
+}
+
+std::pair<TreeRows::NodePtr, TreeRows::NodePtr> TreeRows::split(const NodePtr &node, size_t count) {
+    if (!node) {
+        return {};
+    }
+    const size_t left_size = nodeSize(node->left);
+    if (count <= left_size) {
+        auto [first, rest] = split(node->left, count);
+        return {std::move(first), makeNode(node->row, std::move(rest), node->right, node->priority)};
+    }
+    auto [first, rest] = split(node->right, count - left_size - 1);
+    return {makeNode(node->row, node->left, std::move(first), node->priority), std::move(rest)};
+}
+
+const TreeRows::Row &TreeRows::operator[](size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("Tree row index out of range");
+    }
+    const Node *node = root.get();
+    while (true) {
+        const size_t left_size = nodeSize(node->left);
+        if (index < left_size) {
+            node = node->left.get();
+        } else if (index == left_size) {
+            return *node->row;
+        } else {
+            index -= left_size + 1;
+            node = node->right.get();
+        }
+    }
+}
+
+TreeRows TreeRows::slice(size_t first, size_t count) const {
+    auto [head, tail] = split(root, first);
+    return TreeRows(split(tail, count).first);
+}
+
+TreeRows TreeRows::erase(size_t first, size_t count) const {
+    auto [head, tail] = split(root, first);
+    return TreeRows(merge(head, split(tail, count).second));
+}
+
+TreeRows TreeRows::insert(size_t position, const TreeRows &rows) const {
+    auto [head, tail] = split(root, position);
+    return TreeRows(merge(merge(head, rows.root), tail));
+}
+
+TreeRows TreeRows::replace(size_t index, Row row) const {
+    auto [head, tail] = split(root, index);
+    auto [old_row, rest] = split(tail, 1);
+    if (!old_row) {
+        throw std::out_of_range("Tree row index out of range");
+    }
+    NodePtr replaced = makeNode(std::make_shared<const Row>(std::move(row)), nullptr, nullptr, old_row->priority);
+    return TreeRows(merge(merge(head, replaced), rest));
+}
+
+size_t TreeRows::subtreeEnd(size_t index) const {
+    const size_t found = firstAtMost(root.get(), 0, index + 1, (*this)[index].depth);
+    return found == npos ? size() : found;
+}
+
+size_t TreeRows::parent(size_t index) const {
+    const uint32_t depth = (*this)[index].depth;
+    return depth == 0 ? npos : lastBelow(root.get(), 0, index, depth);
+}
+
+size_t TreeRows::firstAtMost(const Node *node, size_t offset, size_t from, uint32_t depth) {
+    // Subtrees that end before from, or hold only deeper rows, are skipped without descending.
+    if (!node || node->minDepth > depth || offset + node->size <= from) {
+        return npos;
+    }
+    const size_t own_index = offset + nodeSize(node->left);
+    if (size_t found = firstAtMost(node->left.get(), offset, from, depth); found != npos) {
+        return found;
+    }
+    if (own_index >= from && node->row->depth <= depth) {
+        return own_index;
+    }
+    return firstAtMost(node->right.get(), own_index + 1, from, depth);
+}
+
+size_t TreeRows::lastBelow(const Node *node, size_t offset, size_t before, uint32_t depth) {
+    if (!node || node->minDepth >= depth || offset >= before) {
+        return npos;
+    }
+    const size_t own_index = offset + nodeSize(node->left);
+    if (size_t found = lastBelow(node->right.get(), own_index + 1, before, depth); found != npos) {
+        return found;
+    }
+    if (own_index < before && node->row->depth < depth) {
+        return own_index;
+    }
+    return lastBelow(node->left.get(), offset, before, depth);
+}
+
+void TreeRows::forEach(size_t first, size_t count, const std::function<void(size_t, const Row &)> &visit) const {
+    visitRange(root.get(), 0, first, std::min(size(), first + count), visit);
+}
+
+void TreeRows::visitRange(const Node *node, size_t offset, size_t first, size_t last,
+                          const std::function<void(size_t, const Row &)> &visit) {
+    if (!node || offset >= last || offset + node->size <= first) {
+        return;
+    }
+    const size_t own_index = offset + nodeSize(node->left);
+    visitRange(node->left.get(), offset, first, last, visit);
+    if (own_index >= first && own_index < last) {
+        visit(own_index, *node->row);
+    }
+    visitRange(node->right.get(), own_index + 1, first, last, visit);
+}
+#endif // __unix__
@@ -0,0 +1,73 @@
+// TreeRows.hpp
+#ifdef __unix__
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+namespace fs = std::filesystem;
+
+struct FileSeries;
+
+// The visible rows of the tree view in display order, as a persistent implicit treap.
+// Every operation returns a new TreeRows and leaves the old one untouched; the two share all
+// nodes off the changed path, so an edit costs O(log n) and a published copy stays valid for
+// the render thread. Expanding or collapsing a directory is an insert or erase of the whole
+// range of its descendants, which is also O(log n) however many rows that range holds.
+class TreeRows {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    enum class State : uint8_t { Leaf, Collapsed, Loading, Expanded };
+
+    struct Row {
+        fs::directory_entry entry; // The first file of a series
+        uint32_t depth{0};
+        State state{State::Leaf};
+        std::shared_ptr<const FileSeries> series; // Set for the row of a grouped series, which expands to its files
+    };
+
+    TreeRows() = default;
+    // Builds a balanced treap in O(n).
+    explicit TreeRows(std::vector<Row> rows);
+
+    size_t size() const { return nodeSize(root); }
+    bool empty() const { return root == nullptr; }
+    const Row &operator[](size_t index) const;
+
+    TreeRows slice(size_t first, size_t count) const;
+    TreeRows erase(size_t first, size_t count) const;
+    TreeRows insert(size_t position, const TreeRows &rows) const;
+    TreeRows replace(size_t index, Row row) const;
+
+    // One past the last descendant of the row at index (the next row that is not deeper).
+    size_t subtreeEnd(size_t index) const;
+    // The closest row above index that is less deep, npos for top-level rows.
+    size_t parent(size_t index) const;
+    // Calls visit(index, row) for up to count rows from first on, in order.
+    void forEach(size_t first, size_t count, const std::function<void(size_t, const Row &)> &visit) const;
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    NodePtr root;
+
+    explicit TreeRows(NodePtr root) : root(std::move(root)) {}
+
+    static size_t nodeSize(const NodePtr &node);
+    static NodePtr makeNode(std::shared_ptr<const Row> row, NodePtr left, NodePtr right, uint32_t priority);
+    static NodePtr build(const std::vector<std::shared_ptr<const Row>> &rows, size_t first, size_t last,
+                         const std::vector<uint32_t> &priorities, size_t &nextPriority);
+    static NodePtr merge(const NodePtr &left, const NodePtr &right);
+    // The first count rows, and the rest.
+    static std::pair<NodePtr, NodePtr> split(const NodePtr &node, size_t count);
+    static size_t firstAtMost(const Node *node, size_t offset, size_t from, uint32_t depth);
+    static size_t lastBelow(const Node *node, size_t offset, size_t before, uint32_t depth);
+    static void visitRange(const Node *node, size_t offset, size_t first, size_t last,
+                           const std::function<void(size_t, const Row &)> &visit);
+};
+#endif // __unix__
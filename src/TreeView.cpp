@@ -0,0 +1,204 @@
+// TreeView.cpp
+#ifdef __unix__
+#include "TreeView.hpp"
+#include "FileSeries.hpp"
+#include "ListingCache.hpp"
+
+#include <algorithm>
+#include <fmt/core.h>
+
+TreeView::TreeView(RequestListing requestListing, HasUncached hasUncached)
+    : requestListing(std::move(requestListing)), hasUncached(std::move(hasUncached)) {}
+
+void TreeView::update(std::shared_ptr<const std::vector<fs::directory_entry>> listing,
+                      const FileSystemManager::ScanOptions &scanOptions) {
+    // Listings from the cache keep their identity, so an unchanged directory costs no rebuild.
+    if (listing != topLevel || !(scanOptions == options)) {
+        topLevel = std::move(listing);
+        options = scanOptions;
+        collapsedRows.clear();
+        loadingPaths.clear();
+        std::vector<TreeRows::Row> rows;
+        rows.reserve(topLevel->size());
+        appendRows(rows, *topLevel, 0);
+        visibleRows = TreeRows(std::move(rows));
+    }
+
+    std::vector<std::string> arrived;
+    for (const auto &path : loadingPaths) {
+        if (isSettled(path)) {
+            arrived.push_back(path);
+        }
+    }
+    for (const auto &path : arrived) {
+        loadingPaths.erase(path);
+        size_t row = findRow(path);
+        if (row != TreeRows::npos && visibleRows[row].state == TreeRows::State::Loading) {
+            expand(row); // Collapses it again if the directory failed
+        }
+    }
+}
+
+void TreeView::setSeriesGrouping(bool enabled) {
+    if (enabled != isGroupingSeries) {
+        isGroupingSeries = enabled;
+        topLevel.reset();
+    }
+}
+
+bool TreeView::hasArrivals() const {
+    return std::any_of(loadingPaths.begin(), loadingPaths.end(), [this](const std::string &path) { return isSettled(path); });
+}
+
+bool TreeView::isSettled(const std::string &path) const {
+    return ListingCache::instance().contains(path, options) || hasUncached(path, options) ||
+           ListingCache::instance().findFailure(path);
+}
+
+bool TreeView::toggle(size_t row) {
+    TreeRows::Row current = visibleRows[row];
+    const std::string key = current.entry.path().string();
+    expandProblem.clear();
+    switch (current.state) {
+    case TreeRows::State::Leaf:
+        return false;
+    case TreeRows::State::Collapsed:
+        expandedPaths.insert(key);
+        expand(row);
+        break;
+    case TreeRows::State::Loading:
+        expandedPaths.erase(key);
+        loadingPaths.erase(key);
+        current.state = TreeRows::State::Collapsed;
+        visibleRows = visibleRows.replace(row, std::move(current));
+        break;
+    case TreeRows::State::Expanded: {
+        const size_t end = visibleRows.subtreeEnd(row);
+        collapsedRows[key] = visibleRows.slice(row + 1, end - row - 1);
+        expandedPaths.erase(key);
+        current.state = TreeRows::State::Collapsed;
+        visibleRows = visibleRows.erase(row + 1, end - row - 1).replace(row, std::move(current));
+    } break;
+    }
+    return true;
+}
+
+bool TreeView::isExpanded(size_t row) const {
+    const auto state = visibleRows[row].state;
+    return state == TreeRows::State::Expanded || state == TreeRows::State::Loading;
+}
+
+void TreeView::expand(size_t row) {
+    TreeRows::Row current = visibleRows[row];
+    const std::string key = current.entry.path().string();
+    TreeRows children;
+    if (auto collapsed = collapsedRows.find(key); collapsed != collapsedRows.end()) {
+        children = std::move(collapsed->second);
+        collapsedRows.erase(collapsed);
+        current.state = TreeRows::State::Expanded;
+    } else if (current.series) {
+        std::vector<TreeRows::Row> rows;
+        rows.reserve(current.series->files.size());
+        for (const auto &file : current.series->files) {
+            rows.push_back({file, current.depth + 1, TreeRows::State::Leaf, nullptr});
+        }
+        children = TreeRows(std::move(rows));
+        current.state = TreeRows::State::Expanded;
+    } else {
+        std::vector<TreeRows::Row> rows;
+        const auto listing = childListing(current.entry.path());
+        current.state = expandedState(listing, current.entry.path());
+        if (listing) {
+            appendRows(rows, *listing, current.depth + 1);
+        }
+        children = TreeRows(std::move(rows));
+    }
+    visibleRows = visibleRows.insert(row + 1, children).replace(row, std::move(current));
+}
+
+TreeView::Listing TreeView::childListing(const fs::path &directory) {
+    auto &cache = ListingCache::instance();
+    Listing listing = cache.find(directory, options);
+    std::optional<std::string> failure = listing ? std::nullopt : cache.findFailure(directory);
+    if (!listing && !failure) {
+        // Without background scans the listing is already there (or has failed).
+        listing = requestListing(directory, options);
+        failure = listing ? std::nullopt : cache.findFailure(directory);
+    }
+    if (failure) {
+        expandedPaths.erase(directory.string());
+        expandProblem = fmt::format("{}: {}", directory.string(), *failure);
+    } else if (!listing) {
+        loadingPaths.insert(directory.string());
+    }
+    return listing;
+}
+
+TreeRows::State TreeView::expandedState(const Listing &listing, const fs::path &directory) const {
+    if (listing) {
+        return TreeRows::State::Expanded;
+    }
+    return expandedPaths.count(directory.string()) ? TreeRows::State::Loading : TreeRows::State::Collapsed;
+}
+
+void TreeView::appendRows(std::vector<TreeRows::Row> &rows, const std::vector<fs::directory_entry> &listing,
+                          uint32_t depth) {
+    const auto grouping = isGroupingSeries ? FileSeries::group(listing) : FileSeries::Grouping{};
+    std::vector<bool> is_placed(grouping.series.size(), false);
+    for (size_t position = 0; position < listing.size(); ++position) {
+        const auto &entry = listing[position];
+        std::error_code ec;
+        if (!grouping.seriesOf.empty() && grouping.seriesOf[position] != FileSeries::npos) {
+            // A series takes the place of whichever of its files the listing has first; its row
+            // stands for its first step.
+            const size_t index = grouping.seriesOf[position];
+            if (is_placed[index]) {
+                continue;
+            }
+            is_placed[index] = true;
+            const auto &series = grouping.series[index];
+            const auto &first = series->files.front();
+            if (!expandedPaths.count(first.path().string())) {
+                rows.push_back({first, depth, TreeRows::State::Collapsed, series});
+                continue;
+            }
+            rows.push_back({first, depth, TreeRows::State::Expanded, series});
+            for (const auto &file : series->files) {
+                rows.push_back({file, depth + 1, TreeRows::State::Leaf, nullptr});
+            }
+        } else if (!entry.is_directory(ec)) {
+            rows.push_back({entry, depth, TreeRows::State::Leaf, nullptr});
+        } else if (!expandedPaths.count(entry.path().string())) {
+            rows.push_back({entry, depth, TreeRows::State::Collapsed, nullptr});
+        } else {
+            const auto listing = childListing(entry.path());
+            rows.push_back({entry, depth, expandedState(listing, entry.path()), nullptr});
+            if (listing) {
+                appendRows(rows, *listing, depth + 1);
+            }
+        }
+    }
+}
+
+size_t TreeView::findRow(const fs::path &path) const {
+    const std::string &target = path.native();
+    size_t row = 0;
+    size_t end = visibleRows.size();
+    while (row < end) {
+        const TreeRows::Row &current = visibleRows[row];
+        const std::string &candidate = current.entry.path().native();
+        if (candidate == target) {
+            return row;
+        }
+        bool is_inside = target.size() > candidate.size() && target.compare(0, candidate.size(), candidate) == 0 &&
+                         target[candidate.size()] == '/';
+        if (is_inside && current.state == TreeRows::State::Expanded) {
+            end = visibleRows.subtreeEnd(row);
+            ++row;
+        } else {
+            row = visibleRows.subtreeEnd(row);
+        }
+    }
+    return TreeRows::npos;
+}
+#endif // __unix__
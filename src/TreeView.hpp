@@ -0,0 +1,76 @@
+// TreeView.hpp
+#ifdef __unix__
+#pragma once
+#include "FileSystemManager.hpp"
+#include "TreeRows.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+namespace fs = std::filesystem;
+
+// State of the tree view: the current listing as top-level rows, with directories expanded in place.
+// Child listings come from the ListingCache; a directory that is not cached is handed to
+// requestListing (usually a background scan) and shows as loading until its listing is cached, or
+// handed back by requestListing when it is too big for the cache. A directory that cannot be listed
+// collapses again, and problem() tells why.
+// Collapsing keeps the collapsed rows, so expanding the same directory again is a single insert.
+// With series grouping, the numbered files of each listing (see FileSeries) are one row that
+// expands to the files, in step order.
+class TreeView {
+public:
+    using Listing = std::shared_ptr<const std::vector<fs::directory_entry>>;
+    // Starts loading a directory, or loads it at once; returns the listing if it is there already.
+    using RequestListing = std::function<Listing(const fs::path &, const FileSystemManager::ScanOptions &)>;
+    // Whether requestListing has a listing to hand back that is not in the cache (no syscalls).
+    using HasUncached = std::function<bool(const fs::path &, const FileSystemManager::ScanOptions &)>;
+
+    TreeView(RequestListing requestListing, HasUncached hasUncached);
+
+    // Rebuilds the rows when the top-level listing or the scan options changed (expanded directories
+    // stay expanded), then expands the directories whose listings have arrived since.
+    void update(std::shared_ptr<const std::vector<fs::directory_entry>> topLevel,
+                const FileSystemManager::ScanOptions &options);
+    // Rebuilds the rows on the next update.
+    void setSeriesGrouping(bool enabled);
+    bool isSeriesGrouping() const { return isGroupingSeries; }
+    // Whether a directory waiting for its listing can be expanded, or has failed, now (no syscalls).
+    bool hasArrivals() const;
+    // The last directory that could not be expanded, and why; empty once a row is toggled again.
+    const std::string &problem() const { return expandProblem; }
+
+    const TreeRows &rows() const { return visibleRows; }
+    // Expands a collapsed directory or series row, or collapses an expanded or loading one.
+    // Returns false if the row is a file.
+    bool toggle(size_t row);
+    bool isExpanded(size_t row) const;
+
+private:
+    RequestListing requestListing;
+    HasUncached hasUncached;
+    std::shared_ptr<const std::vector<fs::directory_entry>> topLevel;
+    FileSystemManager::ScanOptions options;
+    TreeRows visibleRows;
+    std::unordered_set<std::string> expandedPaths;           // Includes the ones still loading
+    std::unordered_map<std::string, TreeRows> collapsedRows; // Descendant rows, by directory
+    std::unordered_set<std::string> loadingPaths;
+    std::string expandProblem;
+    bool isGroupingSeries{false};
+
+    // Rows for a listing, with the directories in expandedPaths expanded as far as their listings are cached.
+    void appendRows(std::vector<TreeRows::Row> &rows, const std::vector<fs::directory_entry> &listing, uint32_t depth);
+    // The listing of directory, or nullptr after asking for it to be loaded; then the directory is
+    // loading, or, if it cannot be listed, no longer expanded.
+    Listing childListing(const fs::path &directory);
+    TreeRows::State expandedState(const Listing &listing, const fs::path &directory) const;
+    // A loading directory is ready when its listing arrived or the negative cache knows it failed.
+    bool isSettled(const std::string &path) const;
+    // Index of the row showing path, found by skipping the subtrees it is not in; npos if not visible.
+    size_t findRow(const fs::path &path) const;
+    void expand(size_t row);
+};
+#endif // __unix__
@@ -1,17 +1,92 @@
 #include "UIRenderer.hpp"
+#include "DeadlineExecutor.hpp"
+#include "DirectoryStats.hpp"
+#include "DisplayWidth.hpp"
+#include "Tracer.hpp"
 #ifdef __unix__
 #include <algorithm>
-#include <cstdio>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sys/stat.h>
 UIRenderer::UIRenderer() {
 }
 
-void UIRenderer::drawHeader(const fs::path &currentDirectory,
+void UIRenderer::beginFrame(size_t rows) {
+    screenRows = rows;
+    headerLines.clear();
+    listLines.clear();
+    footerLines.clear();
+    hasPrompt = false;
+}
+
+std::string UIRenderer::endFrame() {
+    TraceSpan trace_span(Tracer::EndFrame);
+    std::vector<std::string> lines;
+    lines.reserve(headerLines.size() + listLines.size() + footerLines.size());
+    lines.insert(lines.end(), headerLines.begin(), headerLines.end());
+    lines.insert(lines.end(), listLines.begin(), listLines.end());
+    lines.insert(lines.end(), footerLines.begin(), footerLines.end());
+
+    std::string output;
+    if (needsFullRedraw) {
+        output += "\033[?7l\033[2J"; // No auto-wrap, so every line takes exactly one row
+        presentedLines.clear();
+        needsFullRedraw = false;
+    }
+    output += "\033[?25l"; // Hide the cursor while drawing
+    for (size_t row = 0; row < lines.size(); ++row) {
+        if (row < presentedLines.size() && presentedLines[row] == lines[row]) {
+            continue;
+        }
+        fmt::format_to(std::back_inserter(output), "\033[{};1H{}\033[K", row + 1, lines[row]);
+    }
+    if (lines.size() < presentedLines.size()) {
+        fmt::format_to(std::back_inserter(output), "\033[{};1H\033[J", lines.size() + 1);
+    }
+    if (hasPrompt) {
+        fmt::format_to(std::back_inserter(output), "\033[{};{}H\033[?25h", lines.size(), promptColumn);
+    } else {
+        fmt::format_to(std::back_inserter(output), "\033[{};1H", lines.size() + 1);
+    }
+    presentedLines = std::move(lines);
+    return output;
+}
+
+std::string UIRenderer::endSession() {
+    return fmt::format("\033[{};1H\033[J\033[?25h\033[?7h", presentedLines.size() + 1);
+}
+
+void UIRenderer::invalidate() {
+    needsFullRedraw = true;
+}
+
+size_t UIRenderer::listRowBudget() const {
+    // One row for the item bar and one spare row below the frame for the terminal cursor.
+    size_t used = headerLines.size() + footerLines.size() + 2;
+    return screenRows > used ? screenRows - used : 1;
+}
+
+void UIRenderer::appendLines(std::vector<std::string> &lines, const std::string &text) {
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            lines.push_back(text.substr(start));
+            break;
+        }
+        lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+void UIRenderer::drawHeader(const std::string &location,
                             const std::vector<std::string> &activeFilters,
                             bool isShowHidden,
                             const std::string &searchName,
                             bool isShowHint, bool isShowSelected) {
+    TraceSpan trace_span(Tracer::DrawHeader);
 
     constexpr const auto header_style = fmt::emphasis::bold | fg(fmt::color::light_blue);
     constexpr const auto search_style = fmt::emphasis::italic | fg(fmt::color::sea_green);
@@ -19,11 +94,14 @@ void UIRenderer::drawHeader(const fs::path &currentDirectory,
     const auto selected_style = isShowSelected ? fg(fmt::color::light_green) : fg(fmt::color::light_pink);
 
     if (isShowHint) {
-        printQuickHelp();
+        appendLines(headerLines, getQuickHelp());
     } else {
-        fmt::print(fg(fmt::color::dark_gray) | bg(fmt::color::light_gray), "Press '!' for floating help or '?' for full features\n");
+        headerLines.push_back(fmt::format(fg(fmt::color::dark_gray) | bg(fmt::color::light_gray),
+                                          "Press '{}' for floating help or '{}' for full features",
+                                          keymap.keysLabel(Keymap::Action::ToggleHint),
+                                          keymap.keysLabel(Keymap::Action::ShowHelp)));
     }
-    fmt::print(header_style, "📁 {}\n", currentDirectory.string());
+    headerLines.push_back(fmt::format(header_style, "📁 {}", location));
 
     std::string status_bar_1{};
     std::string status_bar_2{};
@@ -33,37 +111,258 @@ void UIRenderer::drawHeader(const fs::path &currentDirectory,
     status_bar_1 += getFilterStatus(activeFilters);
     status_bar_2 += fmt::format(hidden_style, "[Show Hidden? : {}] ", isShowHidden ? "YES" : "N0");
     status_bar_2 += fmt::format(selected_style, "[Show Selected? : {}] ", isShowSelected ? "YES" : "NO");
-    fmt::print("{}\n", status_bar_1);
-    fmt::print("{}\n", status_bar_2);
+    headerLines.push_back(status_bar_1);
+    headerLines.push_back(status_bar_2);
+}
+
+namespace {
+// How many files of series are selected. Only the selected paths that start with the series' stem
+// are visited, not the files of the series.
+size_t selectedInSeries(const FileSeries &series, const std::set<fs::path> &selectedPaths) {
+    if (selectedPaths.empty()) {
+        return 0;
+    }
+    const fs::path directory = series.files.front().path().parent_path();
+    const std::string prefix = (directory / series.stem).native();
+    size_t count = 0;
+    for (auto it = selectedPaths.lower_bound(directory / series.stem);
+         it != selectedPaths.end() && it->native().compare(0, prefix.size(), prefix) == 0; ++it) {
+        const std::string name = it->filename().native();
+        if (it->parent_path() != directory || name.size() <= series.stem.size() + series.suffix.size() ||
+            name.compare(name.size() - series.suffix.size(), series.suffix.size(), series.suffix) != 0) {
+            continue;
+        }
+        const auto step = std::string_view(name).substr(series.stem.size(),
+                                                        name.size() - series.stem.size() - series.suffix.size());
+        count += std::all_of(step.begin(), step.end(), [](char c) { return c >= '0' && c <= '9'; });
+    }
+    return count;
 }
 
+const char *treeMarker(TreeRows::State state) {
+    switch (state) {
+    case TreeRows::State::Collapsed:
+        return "▸ ";
+    case TreeRows::State::Loading:
+        return "⋯ ";
+    case TreeRows::State::Expanded:
+        return "▾ ";
+    default:
+        return "  ";
+    }
+}
+} // namespace
+
 void UIRenderer::drawFileList(const std::vector<fs::directory_entry> &entries,
                               size_t cursor,
-                              const std::set<fs::path> &selectedMultiPaths) {
-    constexpr const auto dir_style = fg(fmt::color::deep_sky_blue);
-    constexpr const auto file_style = fg(fmt::color::white);
-    constexpr const auto no_permission_style = fg(fmt::color::red);
-    constexpr const auto time_style = fg(fmt::color::pale_golden_rod);
-    constexpr const auto size_style = fg(fmt::color::royal_blue);
-    constexpr const auto type_style = fg(fmt::color::magenta);
+                              const std::set<fs::path> &selectedPaths) {
+    TraceSpan trace_span(Tracer::DrawFileList);
+    drawRows(listRows(entries, cursor), cursor, entries.size(), selectedPaths);
+}
 
-    std::string item_bar;
-    item_bar = fmt::format(file_style, "{:<7}  {}  {:<40}", "", "No", "File Name");
-    item_bar += fmt::format(type_style, " {:<7}", "Type");
-    item_bar += fmt::format(time_style, " {:<12}", "Modify Time", "Size");
-    item_bar += fmt::format(size_style, "  {}", "Size");
-    fmt::print("{}\n", item_bar);
+void UIRenderer::drawFileList(const TreeRows &rows,
+                              size_t cursor,
+                              const std::set<fs::path> &selectedPaths) {
+    TraceSpan trace_span(Tracer::DrawFileList);
+    drawRows(listRows(rows, cursor), cursor, rows.size(), selectedPaths);
+}
 
-    for (size_t i = 0; i < entries.size(); ++i) {
-        bool has_permission = true;
-        const auto &entry = entries[i];
-        bool is_selected = false;
+size_t UIRenderer::scrollToCursor(size_t cursor, size_t total) {
+    // Keep the cursor inside the visible window, scrolling only as far as needed.
+    const size_t row_count = std::min(listRowBudget(), total);
+    if (cursor < listTop) {
+        listTop = cursor;
+    } else if (cursor >= listTop + row_count) {
+        listTop = cursor - row_count + 1;
+    }
+    listTop = std::min(listTop, total - row_count);
+    return row_count;
+}
 
-        try {
-            is_selected = selectedMultiPaths.count(fs::canonical(entry.path()));
-        } catch (...) {
-            has_permission = false;
+std::vector<UIRenderer::ListRow> UIRenderer::listRows(const std::vector<fs::directory_entry> &entries, size_t cursor) {
+    const size_t row_count = scrollToCursor(cursor, entries.size());
+    std::vector<ListRow> rows;
+    rows.reserve(row_count);
+    for (size_t i = listTop; i < listTop + row_count; ++i) {
+        rows.push_back({&entries[i], {}});
+    }
+    return rows;
+}
+
+std::vector<UIRenderer::ListRow> UIRenderer::listRows(const TreeRows &treeRows, size_t cursor) {
+    // Only the rows on screen are looked up, so this does not grow with the number of expanded rows.
+    const size_t row_count = scrollToCursor(cursor, treeRows.size());
+    std::vector<ListRow> rows;
+    rows.reserve(row_count);
+    treeRows.forEach(listTop, row_count, [&rows](size_t, const TreeRows::Row &row) {
+        rows.push_back({&row.entry, std::string(2 * row.depth, ' ') + treeMarker(row.state), row.series.get()});
+    });
+    return rows;
+}
+
+// Shared with the worker, which may still be writing to it after the deadline.
+struct UIRenderer::StatBatch {
+    std::vector<fs::path> paths;
+    std::vector<RowMetadata> results;
+    std::atomic<size_t> done{0};
+};
+
+std::vector<std::optional<UIRenderer::RowMetadata>> UIRenderer::statRows(const std::vector<ListRow> &rows) {
+    std::vector<std::optional<RowMetadata>> metadata(rows.size());
+    // While a batch is overdue, rows it has finished use its results and the others wait for it;
+    // no new batch is started, so a hung mount holds up one worker at most.
+    if (overdueBatch) {
+        const size_t done = overdueBatch->done.load(std::memory_order_acquire);
+        if (done < overdueBatch->paths.size()) {
+            std::unordered_map<std::string, size_t> finished;
+            for (size_t i = 0; i < done; ++i) {
+                finished.emplace(overdueBatch->paths[i].native(), i);
+            }
+            for (size_t row = 0; row < rows.size(); ++row) {
+                if (auto found = finished.find(rows[row].entry->path().native()); found != finished.end()) {
+                    metadata[row] = overdueBatch->results[found->second];
+                }
+            }
+            return metadata;
+        }
+        overdueBatch.reset();
+    }
+
+    auto batch = std::make_shared<StatBatch>();
+    for (const auto &row : rows) {
+        batch->paths.push_back(row.entry->path());
+    }
+    batch->results.resize(batch->paths.size());
+    if (batch->paths.empty()) {
+        return metadata;
+    }
+    const bool is_finished = DeadlineExecutor::instance().run(
+        [batch] {
+            for (size_t i = 0; i < batch->paths.size(); ++i) {
+                RowMetadata &result = batch->results[i];
+                std::error_code ec;
+                result.canonicalPath = fs::canonical(batch->paths[i], ec);
+                struct stat status {};
+                if (::stat(batch->paths[i].c_str(), &status) == 0) {
+                    result.modifiedTime = std::chrono::system_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            std::chrono::seconds(status.st_mtim.tv_sec) +
+                            std::chrono::nanoseconds(status.st_mtim.tv_nsec)));
+                    if (S_ISREG(status.st_mode)) {
+                        result.size = static_cast<uintmax_t>(status.st_size);
+                        result.signature = ContentSniffer::instance().find(status);
+                    }
+                }
+                batch->done.store(i + 1, std::memory_order_release);
+            }
+        },
+        DeadlineExecutor::stat_deadline);
+    const size_t done = batch->done.load(std::memory_order_acquire);
+    for (size_t row = 0; row < done; ++row) {
+        metadata[row] = batch->results[row];
+    }
+    if (!is_finished && done < batch->paths.size()) {
+        overdueBatch = std::move(batch);
+    }
+    return metadata;
+}
+
+// Shared with the worker, like StatBatch.
+struct UIRenderer::SeriesBatch {
+    std::vector<std::string> keys;
+    std::vector<std::vector<fs::path>> files;
+    std::vector<uintmax_t> results;
+    std::atomic<size_t> done{0};
+};
+
+std::string UIRenderer::seriesKey(const FileSeries &series) {
+    return fmt::format("{}\n{}", series.files.front().path().native(), series.files.size());
+}
+
+void UIRenderer::sumSeriesSizes(const std::vector<ListRow> &rows) {
+    auto collect = [this](SeriesBatch &batch) {
+        const size_t done = batch.done.load(std::memory_order_acquire);
+        if (seriesBytes.size() + done > max_series_bytes) {
+            seriesBytes.clear();
+        }
+        for (size_t i = 0; i < done; ++i) {
+            seriesBytes.emplace(batch.keys[i], batch.results[i]);
+        }
+        return done == batch.keys.size();
+    };
+    if (overdueSeries) {
+        if (!collect(*overdueSeries)) {
+            return;
+        }
+        overdueSeries.reset();
+    }
+
+    auto batch = std::make_shared<SeriesBatch>();
+    for (const auto &row : rows) {
+        if (row.series) {
+            std::string key = seriesKey(*row.series);
+            if (!seriesBytes.count(key) && std::find(batch->keys.begin(), batch->keys.end(), key) == batch->keys.end()) {
+                batch->keys.push_back(std::move(key));
+                std::vector<fs::path> &paths = batch->files.emplace_back();
+                paths.reserve(row.series->files.size());
+                for (const auto &file : row.series->files) {
+                    paths.push_back(file.path());
+                }
+            }
+        }
+    }
+    if (batch->keys.empty()) {
+        return;
+    }
+    batch->results.resize(batch->keys.size());
+    const bool is_finished = DeadlineExecutor::instance().run(
+        [batch] {
+            for (size_t i = 0; i < batch->files.size(); ++i) {
+                uintmax_t bytes = 0;
+                for (const auto &path : batch->files[i]) {
+                    struct stat status {};
+                    if (::stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode)) {
+                        bytes += static_cast<uintmax_t>(status.st_size);
+                    }
+                }
+                batch->results[i] = bytes;
+                batch->done.store(i + 1, std::memory_order_release);
+            }
+        },
+        DeadlineExecutor::stat_deadline);
+    if (!collect(*batch) && !is_finished) {
+        overdueSeries = std::move(batch);
+    }
+}
+
+void UIRenderer::drawRows(const std::vector<ListRow> &rows, size_t cursor, size_t total,
+                          const std::set<fs::path> &selectedPaths) {
+    constexpr const auto type_style = fg(fmt::color::magenta);
+
+    const auto metadata = statRows(rows);
+    sumSeriesSizes(rows);
+    const bool has_header_fields = std::any_of(metadata.begin(), metadata.end(), [](const auto &row) {
+        return row && row->signature && row->signature->kind != ContentSniffer::Kind::Unknown;
+    });
+    listLines.push_back(getItemBar(listTop, rows.size(), total, has_header_fields));
+
+    for (size_t row = 0; row < rows.size(); ++row) {
+        const size_t i = listTop + row;
+        const auto &entry = *rows[row].entry;
+        if (const FileSeries *series = rows[row].series) {
+            const size_t selected = selectedInSeries(*series, selectedPaths);
+            std::string series_line = i == cursor ? "▶ " : "  ";
+            series_line += selected == 0 ? "[ ] " : selected < series->files.size() ? "[-] " : "[✓] ";
+            series_line += getFormattedSeries(*series, i, rows[row].treePrefix);
+            listLines.push_back(std::move(series_line));
+            continue;
         }
+        // The selection holds canonical paths. Rows not stat'ed in time are matched by their listed
+        // path, and assumed accessible.
+        const bool has_permission = !metadata[row] || !metadata[row]->canonicalPath.empty();
+        const bool is_selected = !selectedPaths.empty() &&
+                                 selectedPaths.count(metadata[row] && has_permission ? metadata[row]->canonicalPath
+                                                                                     : entry.path());
 
         auto selectedCheckBox = [is_selected, has_permission]() -> std::string {
             if (has_permission) {
@@ -94,105 +393,217 @@ void UIRenderer::drawFileList(const std::vector<fs::directory_entry> &entries,
         try {
             entry_line += i == cursor ? "▶ " : "  ";
             entry_line += selectedCheckBox();
-            entry_line += getFormattedFileName(entry, i, has_permission);
+            entry_line += getFormattedFileName(entry, i, has_permission, rows[row].treePrefix);
             entry_line += getFormattedFileExtn(entry);
-            entry_line += getFormattedFileTime(entry);
-            entry_line += getFormattedFileSize(entry);
+            entry_line += getFormattedFileTime(metadata[row]);
+            if (has_header_fields) {
+                entry_line += getFormattedHeaderFields(metadata[row]);
+            }
+            entry_line += getFormattedFileSize(entry, metadata[row]);
         } catch (...) {
         }
 
-        fmt::print("{}\n", entry_line);
+        listLines.push_back(std::move(entry_line));
     }
 }
-void UIRenderer::drawFileList(const std::vector<fs::directory_entry> &entries,
-                              size_t cursor,
-                              const fs::path &selectedSinglePath) {
-    constexpr const auto dir_style = fg(fmt::color::deep_sky_blue);
+
+std::string UIRenderer::getItemBar(size_t firstRow, size_t rowCount, size_t total, bool hasHeaderFields) {
     constexpr const auto file_style = fg(fmt::color::white);
-    constexpr const auto no_permission_style = fg(fmt::color::red);
     constexpr const auto time_style = fg(fmt::color::pale_golden_rod);
     constexpr const auto size_style = fg(fmt::color::royal_blue);
     constexpr const auto type_style = fg(fmt::color::magenta);
+    constexpr const auto header_style = fg(fmt::color::light_sea_green);
 
     std::string item_bar;
-    item_bar = fmt::format(file_style, "{:<7}  {}  {:<40}", "", "No", "File Name");
+    item_bar = fmt::format(file_style, "{:<7}  {}  {:<{}}", "", "No", "File Name", name_columns);
     item_bar += fmt::format(type_style, " {:<7}", "Type");
     item_bar += fmt::format(time_style, " {:<12}", "Modify Time", "Size");
+    if (hasHeaderFields) {
+        item_bar += fmt::format(header_style, "  {:<14}{:<8}", "Mesh", "Steps");
+    }
     item_bar += fmt::format(size_style, "  {}", "Size");
-    fmt::print("{}\n", item_bar);
+    if (rowCount < total) {
+        item_bar += fmt::format(fg(fmt::color::gray), "  [{}-{} of {}]", firstRow + 1, firstRow + rowCount, total);
+    }
+    return item_bar;
+}
 
-    for (size_t i = 0; i < entries.size(); ++i) {
-        bool has_permission = true;
-        const auto &entry = entries[i];
-        bool is_selected = false;
+void UIRenderer::drawFooter(const std::set<fs::path> &selectedPaths, bool showSelected, const std::string &title) {
+    TraceSpan trace_span(Tracer::DrawFooter);
+    // Only a few names are listed so the file list keeps most of the screen; ':selected' pages them all.
+    constexpr size_t max_listed_paths = 5;
 
-        try {
-            is_selected = (selectedSinglePath == entry.path());
-        } catch (...) {
-            has_permission = false;
+    footerLines.emplace_back();
+    footerLines.push_back(title);
+    if (showSelected) {
+        size_t listed = 0;
+        for (auto &f : selectedPaths) {
+            if (listed++ == max_listed_paths) {
+                footerLines.push_back(fmt::format(" ... and {} more", selectedPaths.size() - max_listed_paths));
+                break;
+            }
+            footerLines.push_back(fmt::format(" - {}", f.filename().string()));
         }
+    }
+}
 
-        auto selectedCheckBox = [is_selected, has_permission]() -> std::string {
-            if (has_permission) {
-                if (is_selected) {
-                    return "[✓] ";
-                } else {
-                    return "[ ] ";
-                }
-            } else {
-                return "[✗] ";
-            }
-        };
-        auto getFormattedFileExtn = [type_style](const fs::directory_entry &entry) -> std::string {
-            constexpr const auto type_style = fg(fmt::color::magenta);
-            std::string formatted_extension;
-            if (entry.is_directory()) {
-                formatted_extension = fmt::format(type_style, "{:<7.{}s} ", "DIR", 7);
-            } else {
-                formatted_extension = entry.path().extension().string();
-                formatted_extension = formatted_extension.substr(1);
-                std::transform(formatted_extension.begin(), formatted_extension.end(), formatted_extension.begin(), ::toupper);
-                formatted_extension = fmt::format(type_style, "{:<7.{}s} ", formatted_extension, 7);
-            }
-            return formatted_extension;
-        };
+void UIRenderer::drawMessage(const std::string &message) {
+    TraceSpan trace_span(Tracer::DrawMessage);
+    footerLines.push_back(fmt::format(fg(fmt::color::purple), "{}", message));
+}
 
-        std::string entry_line;
-        try {
-            entry_line += i == cursor ? "▶ " : "  ";
-            entry_line += selectedCheckBox();
-            entry_line += getFormattedFileName(entry, i, has_permission);
-            entry_line += getFormattedFileExtn(entry);
-            entry_line += getFormattedFileTime(entry);
-            entry_line += getFormattedFileSize(entry);
-        } catch (...) {
-        }
+void UIRenderer::drawFilesystemStatus(const std::string &listingProblem, const std::string &expandProblem,
+                                      bool isSlow) {
+    std::string status;
+    if (isSlow) {
+        status += fmt::format(fg(fmt::color::black) | bg(fmt::color::orange), "[Slow filesystem]");
+        status += ' ';
+    }
+    if (!listingProblem.empty()) {
+        status += fmt::format(fg(fmt::color::orange), "Cannot list this directory: {}", listingProblem);
+    } else if (!expandProblem.empty()) {
+        status += fmt::format(fg(fmt::color::orange), "Cannot expand {}", expandProblem);
+    }
+    if (!status.empty()) {
+        headerLines.push_back(std::move(status));
+    }
+}
 
-        fmt::print("{}\n", entry_line);
+void UIRenderer::drawPreview(const fs::path &file, const FilePreviewer::Preview *preview) {
+    constexpr size_t min_preview_rows = 3;
+    constexpr const auto title_style = fg(fmt::color::light_sky_blue) | fmt::emphasis::bold;
+    constexpr const auto text_style = fg(fmt::color::light_gray);
+    constexpr const auto error_style = fg(fmt::color::red);
+
+    const std::string name = file.filename().string();
+    if (!preview) {
+        footerLines.push_back(fmt::format(title_style, "── {} ── reading...", name));
+        return;
+    }
+    if (!preview->error.empty()) {
+        footerLines.push_back(fmt::format(title_style, "── {} ── ", name) + fmt::format(error_style, "{}", preview->error));
+        return;
+    }
+    footerLines.push_back(fmt::format(title_style, "── {} ({}{}{}) ──", name, formatByteCount(preview->fileSize),
+                                      preview->isBinary ? ", binary" : "",
+                                      preview->isTruncated ? ", start only" : ""));
+    const size_t row_budget = std::max(screenRows / 3, min_preview_rows);
+    for (size_t i = 0; i < std::min(preview->lines.size(), row_budget); ++i) {
+        footerLines.push_back(fmt::format(text_style, "  {}", preview->lines[i]));
     }
 }
 
-void UIRenderer::drawFooter(const std::set<fs::path> &selectedMultiPaths, bool showSelected) {
-    fmt::print("\nSelected: {} files\n", selectedMultiPaths.size());
-    if (showSelected) {
-        for (auto &f : selectedMultiPaths) {
-            fmt::print(" - {}\n", f.filename().string());
+void UIRenderer::drawStats(const DirectoryStats::Breakdown *stats, bool isCounting) {
+    // The largest extensions only, so the file list keeps most of the screen; ':stats all' pages them all.
+    constexpr size_t max_listed_extensions = 8;
+    const auto lines = statsLines(stats, isCounting, max_listed_extensions);
+    footerLines.insert(footerLines.end(), lines.begin(), lines.end());
+}
+
+std::vector<std::string> UIRenderer::statsLines(const DirectoryStats::Breakdown *stats, bool isCounting,
+                                                size_t maxExtensions) {
+    constexpr size_t bar_width = 30;
+    constexpr const auto stats_style = fg(fmt::color::light_sky_blue);
+    constexpr const auto bar_style = fg(fmt::color::royal_blue);
+
+    std::vector<std::string> lines;
+    const char *state = isCounting ? " (counting...)" : "";
+    if (!stats) {
+        lines.push_back(fmt::format(stats_style, "Contents: not counted yet{}", state));
+        return lines;
+    }
+    lines.push_back(fmt::format(stats_style, "Contents: {} files, {}{}", stats->total.files,
+                                formatByteCount(stats->total.bytes), state));
+
+    std::vector<std::pair<std::string, DirectoryStats::Totals>> extensions(stats->byExtension.begin(),
+                                                                           stats->byExtension.end());
+    const size_t listed = std::min(extensions.size(), maxExtensions);
+    std::partial_sort(extensions.begin(), extensions.begin() + listed, extensions.end(),
+                      [](const auto &a, const auto &b) { return a.second.bytes > b.second.bytes; });
+    const uint64_t largest = listed ? std::max<uint64_t>(extensions.front().second.bytes, 1) : 1;
+    for (size_t i = 0; i < listed; ++i) {
+        const auto &[extension, totals] = extensions[i];
+        const size_t bar = static_cast<size_t>(static_cast<double>(totals.bytes) / largest * bar_width);
+        std::string bar_text;
+        for (size_t j = 0; j < std::max<size_t>(bar, totals.bytes ? 1 : 0); ++j) {
+            bar_text += "█";
         }
+        lines.push_back(fmt::format(stats_style, "  {:<10.10} {:>8} files {:>8}  ",
+                                    extension.empty() ? "(none)" : extension, totals.files,
+                                    formatByteCount(totals.bytes)) +
+                        fmt::format(bar_style, "{}", bar_text));
+    }
+    if (extensions.size() > listed) {
+        lines.push_back(fmt::format(stats_style, "  ... and {} more extensions", extensions.size() - listed));
     }
+    return lines;
 }
 
-void UIRenderer::drawFooter(const fs::path &selectedSinglePath, bool showSelected) {
-    if (selectedSinglePath.empty()) {
-        fmt::print("\nNo file selected\n");
-    } else {
-        fmt::print("\nSelected file: \n");
-        if (showSelected) {
-            fmt::print(" - {}\n", fs::canonical(selectedSinglePath).string());
+void UIRenderer::drawHud(const std::string &line) {
+    footerLines.push_back(fmt::format(fg(fmt::color::dark_gray) | bg(fmt::color::light_gray), "{}", line));
+}
+
+void UIRenderer::drawCompletions(const std::vector<std::string> &candidates, size_t selected, size_t total) {
+    // Paths are shown by their last component, as shells do.
+    auto label = [](const std::string &candidate) {
+        const size_t end = (candidate.size() > 1 && candidate.back() == '/') ? candidate.size() - 1 : candidate.size();
+        const size_t slash = candidate.rfind('/', end - 1);
+        return (slash == std::string::npos) ? candidate : candidate.substr(slash + 1);
+    };
+    // Candidates are laid out in pages of completion_columns; the page with the selected one is shown.
+    const size_t shown_selected = (selected == LineEditor::no_candidate) ? 0 : selected;
+    size_t first = 0;
+    size_t width = 0;
+    for (size_t i = 0; i <= shown_selected && i < candidates.size(); ++i) {
+        const size_t candidate_width = DisplayWidth::of(label(candidates[i])) + 2;
+        if (width + candidate_width > completion_columns && i > first) {
+            first = i;
+            width = 0;
+        }
+        width += candidate_width;
+    }
+    std::string line = fmt::format(fmt::fg(fmt::color::gray), "{:>6}  ", total);
+    width = 0;
+    for (size_t i = first; i < candidates.size(); ++i) {
+        const std::string name = label(candidates[i]);
+        const size_t candidate_width = DisplayWidth::of(name) + 2;
+        if (width + candidate_width > completion_columns && i > first) {
+            line += fmt::format(fmt::fg(fmt::color::gray), "…");
+            break;
         }
+        width += candidate_width;
+        line += (i == selected) ? fmt::format(fmt::emphasis::reverse, "{}", name) : name;
+        line += "  ";
     }
+    footerLines.push_back(std::move(line));
+}
+
+void UIRenderer::drawPrompt(const std::string &prompt, const std::string &buffer, size_t cursor) {
+    TraceSpan trace_span(Tracer::DrawPrompt);
+    footerLines.push_back(fmt::format(fmt::fg(fmt::color::steel_blue), "{}", prompt) + buffer);
+    hasPrompt = true;
+    promptColumn = prompt.size() + cursor + 1;
 }
 
-std::string UIRenderer::getFormattedFileName(const fs::directory_entry &entry, size_t number, bool has_permission) {
+size_t UIRenderer::drawPager(const std::string &title, const std::vector<std::string> &lines, size_t top) {
+    // The title above the text, the position below it, and one spare row for the terminal cursor.
+    constexpr size_t frame_rows = 3;
+    const size_t page_rows = screenRows > frame_rows ? screenRows - frame_rows : 1;
+    top = std::min(top, lines.size() > page_rows ? lines.size() - page_rows : 0);
+    const size_t end = std::min(lines.size(), top + page_rows);
+
+    headerLines.push_back(fmt::format(fmt::emphasis::bold | fmt::emphasis::reverse, " {} ", title));
+    listLines.insert(listLines.end(), lines.begin() + static_cast<std::ptrdiff_t>(top),
+                     lines.begin() + static_cast<std::ptrdiff_t>(end));
+    listLines.resize(page_rows); // Keeps the position line at the bottom on the last page
+    footerLines.push_back(fmt::format(fg(fmt::color::dark_gray) | bg(fmt::color::light_gray),
+                                      "lines {}-{} of {}  j/k: line  Space/b: page  g/G: top/end  q: close",
+                                      lines.empty() ? 0 : top + 1, end, lines.size()));
+    return page_rows;
+}
+
+std::string UIRenderer::getFormattedFileName(const fs::directory_entry &entry, size_t number, bool has_permission,
+                                             const std::string &treePrefix) {
     constexpr const auto dir_style = fg(fmt::color::deep_sky_blue);
     constexpr const auto file_style = fg(fmt::color::white);
     constexpr const auto no_permission_style = fg(fmt::color::red);
@@ -215,19 +626,67 @@ std::string UIRenderer::getFormattedFileName(const fs::directory_entry &entry, s
         formatted_name += fmt::format(print_style, "❌ ");
     }
 
-    formatted_name += fmt::format(print_style, "{:2}  {:<40.{}s} ",
-                                  number + 1, entry.path().filename().string(), 40);
+    const std::string name = isShowFullPaths ? entry.path().string() : entry.path().filename().string();
+    formatted_name += fmt::format(print_style, "{:2}  {} ", number + 1, padName(name, treePrefix));
 
     return formatted_name;
 }
 
-std::string UIRenderer::getFormattedFileTime(const fs::directory_entry &entry) {
+std::string UIRenderer::getFormattedSeries(const FileSeries &series, size_t number, const std::string &treePrefix) {
+    constexpr const auto series_style = fg(fmt::color::light_sea_green);
+    constexpr const auto type_style = fg(fmt::color::magenta);
+    constexpr const auto size_style = fg(fmt::color::royal_blue);
+
+    std::string formatted_series = fmt::format(series_style | fmt::emphasis::bold, "📚 ");
+    formatted_series += fmt::format(series_style, "{:2}  {} ", number + 1, padName(series.label(), treePrefix));
+    formatted_series += fmt::format(type_style, "{:<7.{}s} ", "SERIES", 7);
+    formatted_series += fmt::format(series_style, "{:<14}", fmt::format("{} files", series.files.size()));
+    const auto bytes = seriesBytes.find(seriesKey(series));
+    formatted_series += bytes != seriesBytes.end() ? fmt::format(size_style, "{}", formatByteCount(bytes->second))
+                                                   : fmt::format(size_style, "  ?  ");
+    return formatted_series;
+}
+
+std::string UIRenderer::padName(const std::string &name, const std::string &treePrefix) {
+    // Padded by display width rather than by bytes, so wide and combining characters keep the columns aligned.
+    const size_t prefix_width = DisplayWidth::of(treePrefix);
+    const size_t columns = name_columns > prefix_width ? name_columns - prefix_width : 0;
+    const size_t name_width = nameWidth(name);
+    std::string cell = treePrefix;
+    if (name_width <= columns) {
+        cell += name;
+        cell.append(columns - name_width, ' ');
+    } else if (isShowFullPaths) {
+        cell += DisplayWidth::fitTail(name, columns); // Keep the end of long paths, that is where they differ.
+    } else {
+        cell += DisplayWidth::fit(name, columns);
+    }
+    return cell;
+}
+
+size_t UIRenderer::nameWidth(const std::string &name) {
+    if (DisplayWidth::isAscii(name)) {
+        return name.size();
+    }
+    if (auto found = nameWidths.find(name); found != nameWidths.end()) {
+        return found->second;
+    }
+    if (nameWidths.size() >= max_name_widths) {
+        nameWidths.clear();
+    }
+    const size_t width = DisplayWidth::of(name);
+    nameWidths.emplace(name, width);
+    return width;
+}
+
+std::string UIRenderer::getFormattedFileTime(const std::optional<RowMetadata> &metadata) {
     using namespace std::chrono;
     constexpr const auto time_style = fg(fmt::color::pale_golden_rod);
 
-    auto ftime = fs::last_write_time(entry);
-    auto system_time = system_clock::time_point(
-        duration_cast<system_clock::duration>(ftime.time_since_epoch()));
+    if (!metadata || !metadata->modifiedTime) {
+        return fmt::format(time_style, "{:<14}", "      ?");
+    }
+    const auto system_time = *metadata->modifiedTime;
     const auto now = system_clock::now();
     const auto six_months_ago = now - hours(183 * 24);
 
@@ -240,32 +699,48 @@ std::string UIRenderer::getFormattedFileTime(const fs::directory_entry &entry) {
     return formatted_time;
 }
 
-std::string UIRenderer::getFormattedFileSize(const fs::directory_entry &entry) {
+std::string UIRenderer::getFormattedFileSize(const fs::directory_entry &entry,
+                                             const std::optional<RowMetadata> &metadata) {
     constexpr const auto size_style = fg(fmt::color::royal_blue);
+
+    if (!entry.is_directory()) {
+        if (!metadata || !metadata->size) {
+            return fmt::format(size_style, "  ?  ");
+        }
+        return fmt::format(size_style, "{}", formatByteCount(*metadata->size));
+    }
+    // Directories show their recursive total once the background walk has got to them.
+    if (auto total = DirectoryStats::instance().total(entry.path())) {
+        return fmt::format(size_style, "{}", formatByteCount(total->bytes));
+    }
+    return fmt::format(size_style, "  -  ");
+}
+
+std::string UIRenderer::getFormattedHeaderFields(const std::optional<RowMetadata> &metadata) {
+    constexpr const auto header_style = fg(fmt::color::light_sea_green);
+
+    if (!metadata || !metadata->signature || metadata->signature->kind == ContentSniffer::Kind::Unknown) {
+        return fmt::format("  {:<14}{:<8}", "", "");
+    }
+    // Long values are cut so the size column stays put.
+    const auto &signature = *metadata->signature;
+    return fmt::format(header_style, "  {:<14.13}{:<8.7}", signature.mesh.empty() ? "-" : signature.mesh,
+                       signature.steps.empty() ? "-" : signature.steps);
+}
+
+std::string UIRenderer::formatByteCount(uintmax_t bytes) {
     constexpr const char *suffixes[] = {"B", "K", "M", "G", "T", "P"};
 
     int choose_suffix = 0;
-    double count;
-    bool is_dir_entry = entry.is_directory();
-    if (!is_dir_entry)
-        count = static_cast<double>(entry.file_size());
-
+    double count = static_cast<double>(bytes);
     while (count >= 1024 && choose_suffix < 5) {
         count /= 1024;
         ++choose_suffix;
     }
-
-    std::string formatted_size{};
-    if (!is_dir_entry) {
-        if (choose_suffix == 0) {
-            formatted_size += fmt::format(size_style, "{}{}", static_cast<std::uintmax_t>(count), suffixes[choose_suffix]);
-        } else {
-            formatted_size += fmt::format(size_style, "{:.1f}{}", count, suffixes[choose_suffix]);
-        }
-    } else {
-        formatted_size += fmt::format(size_style, "  -  ");
+    if (choose_suffix == 0) {
+        return fmt::format("{}{}", bytes, suffixes[choose_suffix]);
     }
-    return formatted_size;
+    return fmt::format("{:.1f}{}", count, suffixes[choose_suffix]);
 }
 
 std::string UIRenderer::getSearchStatus(const std::string &searchName) {
@@ -294,17 +769,21 @@ std::string UIRenderer::getFilterStatus(const std::vector<std::string> &activeFi
     return active_filter_status;
 }
 
-void UIRenderer::drawHelp(bool fullHelp) {
-    fmt::print("\033[2J\033[H"); // Clear screen
-    if (fullHelp) {
-        printFullHelp();
-        fullHelp = false;
-        fmt::print("\033[2J\033[H"); // Clear screen again
+Pager::Lines UIRenderer::fullHelp(const Keymap &keymap) {
+    // Formatted once per keymap; every later '?' shares the same lines.
+    static std::mutex mutex;
+    static Keymap formatted_for;
+    static Pager::Lines help;
+    std::lock_guard lock(mutex);
+    if (!help || !(keymap == formatted_for)) {
+        help = std::make_shared<const std::vector<std::string>>(formatFullHelp(keymap));
+        formatted_for = keymap;
     }
+    return help;
 }
 
-void UIRenderer::printFullHelp() {
-
+std::vector<std::string> UIRenderer::formatFullHelp(const Keymap &keymap) {
+    using Action = Keymap::Action;
     constexpr const auto title_style = fmt::emphasis::bold | fg(fmt::color::gold);
     constexpr const auto section_style = fg(fmt::color::aqua) | fmt::emphasis::underline;
     constexpr const auto subsection_style = fg(fmt::color::light_sky_blue) | fmt::emphasis::bold;
@@ -323,10 +802,17 @@ void UIRenderer::printFullHelp() {
         fmt::format(section_style, "[ Navigation & Movement ]"),
         "",
         fmt::format(subsection_style, "Basic Movement:"),
-        fmt::format("  {:<18} {}", "↑/k", "Move cursor up"),
-        fmt::format("  {:<18} {}", "↓/j", "Move cursor down"),
-        fmt::format("  {:<18} {}", "←/h/Backspace", "Go to parent directory"),
-        fmt::format("  {:<18} {}", "→/l/Space", "Enter directory (📁) / Toggle file (📄)"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::MoveUp), "Move cursor up"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::MoveDown), "Move cursor down"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::Leave), "Go to parent directory"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::Open), "Enter directory (📁) / Toggle file (📄)"),
+        "",
+        fmt::format(subsection_style, "Tree View ({}):", keymap.keysLabel(Action::ToggleTreeView)),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::Open), "Expand or collapse the directory in place"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::Leave),
+                    "Collapse, then go up one level, then to the parent directory"),
+        fmt::format(note_style, "  {:<18} {}", "  Note:",
+                    "Directories that are not cached load in the background (⋯)"),
 
         // Selection Section
         "",
@@ -347,6 +833,8 @@ void UIRenderer::printFullHelp() {
         "",
         fmt::format("  {:<18} Press <:> to start command mode", "Activation:"),
         fmt::format("  {:<18} Confirm with <Enter>, cancel with <ESC>", "Completion:"),
+        fmt::format("  {:<18} <Tab> completes commands, sort keys and paths; further <Tab>s", "Tab:"),
+        fmt::format("  {:<18} (<Shift+Tab> backwards) cycle through the candidates above the prompt", ""),
         "",
         fmt::format(subsection_style, "Path Navigation:"),
         fmt::format("  {:<18} {}", ":<path>",
@@ -355,6 +843,19 @@ void UIRenderer::printFullHelp() {
                     "Absolute path or relative path from current directory"),
         fmt::format(example_style, "  {:<18} {}", "  Example:",
                     ":~/documents  :../parent_dir  :/usr/local"),
+        fmt::format("  {:<18} {}", ":z <words>",
+                    "Jump to the most frequently and recently entered directory matching the words"),
+        fmt::format(example_style, "  {:<18} {}", "  Example:",
+                    ":z case3  :z run out"),
+
+        "",
+        fmt::format(subsection_style, "Series Operations:"),
+        fmt::format("  {:<18} {}", ":group",
+                    "Show numbered files (phi_step_000100.vts ...) as one row per series, in the tree view"),
+        fmt::format("  {:<18} {}", ":select <series>[a:b:c]",
+                    "Select the files of a series from step a to b (both included), every c steps"),
+        fmt::format(example_style, "  {:<18} {}", "  Example:",
+                    ":select phi_step[1000:50000:1000]  :select phi_step[:5000]"),
 
         "",
         fmt::format(subsection_style, "Filter Operations:"),
@@ -362,8 +863,10 @@ void UIRenderer::printFullHelp() {
                     "Show files with specified extensions"),
         fmt::format(param_style, "  {:<18} {}", "  Parameters:",
                     "Comma/space-separated list of extensions"),
+        fmt::format(param_style, "  {:<18} {}", "",
+                    "kind:mindes keeps MInDes input decks, by content (with Mesh and Steps columns)"),
         fmt::format(example_style, "  {:<18} {}", "  Example:",
-                    ":filter txt,cpp pdf  :filter "),
+                    ":filter txt,cpp pdf  :filter kind:mindes  :filter "),
         fmt::format(note_style, "  {:<18} {}", "  Note:",
                     "Empty filter resets to show all file types"),
 
@@ -389,17 +892,38 @@ void UIRenderer::printFullHelp() {
         fmt::format("    {:<16} {}", "", "dir   - Directories first"),
         fmt::format("    {:<16} {}", "", "type  - File extension"),
         fmt::format("    {:<16} {}", "", "name  - Alphabetical order"),
+        fmt::format("    {:<16} {}", "", "natural - Alphabetical, numbers by value (step_200 before step_1000)"),
+        fmt::format("    {:<16} {}", "", "iname - Alphabetical, ignoring case"),
         fmt::format("    {:<16} {}", "", "time  - Modification time"),
         fmt::format("    {:<16} {}", "", "size  - File size"),
         fmt::format(example_style, "  {:<18} {}", "  Example:",
-                    ":sort dir,name  :sort time"),
+                    ":sort dir,name  :sort time  :sort dir,natural"),
 
         "",
         fmt::format(subsection_style, "Display Settings:"),
-        fmt::format("  {:<18} {}", "H",
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::ToggleHidden),
                     "Toggle hidden files visibility"),
-        fmt::format("  {:<18} {}", "S",
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::ToggleSelected),
                     "Toggle selected files visibility"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::TogglePerfHud),
+                    "Toggle performance HUD (frame timings, key-to-paint latency)"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::ToggleTreeView),
+                    "Toggle tree view"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::TogglePreview),
+                    "Toggle the preview of the file under the cursor (text, or hex for binary files)"),
+
+        "",
+        fmt::format(subsection_style, "Directory Sizes:"),
+        fmt::format("  {:<18} {}", ":sizes",
+                    "Toggle counting directory sizes, recursively in the background"),
+        fmt::format("  {:<18} {}", ":stats",
+                    "Toggle the file count and size per extension below the list (turns :sizes on)"),
+        fmt::format(note_style, "  {:<18} {}", "  Note:",
+                    "Directories show - until their total has been counted"),
+        fmt::format(note_style, "  {:<18} {}", "  ",
+                    ":sort size orders directories by their totals as they arrive"),
+        fmt::format("  {:<18} {}", ":stats all",
+                    "Page through the counts of every extension"),
 
         "",
         fmt::format(subsection_style, "Other Commands:"),
@@ -407,45 +931,49 @@ void UIRenderer::printFullHelp() {
                     "Finish file selection"),
         fmt::format("  {:<18} {}", ":help",
                     "Open this help"),
+        fmt::format("  {:<18} {}", ":selected",
+                    "Page through the full paths of the selection"),
         // Program Operations
         "",
         fmt::format(section_style, "[ Program Operations ]"),
-        fmt::format("  {:<18} {}", "q", "Finish file selection"),
-        fmt::format("  {:<18} {}", "!", "Toggle quick help"),
-        fmt::format("  {:<18} {}", "?", "Show full help"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::Quit), "Finish file selection"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::ToggleHint), "Toggle quick help"),
+        fmt::format("  {:<18} {}", keymap.keysLabel(Action::ShowHelp), "Show full help"),
+
+        // Pager
+        "",
+        fmt::format(section_style, "[ Pager (help, :selected, :stats all) ]"),
+        fmt::format("  {:<18} {}", "j/k/↑/↓/Enter", "Scroll by one line"),
+        fmt::format("  {:<18} {}", "Space/b/PgDn/PgUp", "Scroll by one page"),
+        fmt::format("  {:<18} {}", "d/u", "Scroll by half a page"),
+        fmt::format("  {:<18} {}", "g/G/Home/End", "Go to the top or the end"),
+        fmt::format("  {:<18} {}", "q/Esc/?", "Close the pager"),
 
         // Footer
         fmt::format(title_style, "{:-^80}", "")};
 
-    FILE *pipe = popen("less -R", "w");
-    if (!pipe) {
-        throw std::runtime_error("Failed to open pipe to less.");
-    }
-
-    // Send output to less
-    for (const auto &line : contents) {
-        fprintf(pipe, "%s\n", line.c_str());
-    }
-
-    pclose(pipe);
+    return contents;
 }
-void UIRenderer::printQuickHelp() {
+
+std::string UIRenderer::getQuickHelp() {
     const auto title_style = fmt::emphasis::bold | fg(fmt::color::gold);
-    fmt::print(title_style, "\n{:-^60}\n", " HELP ");
-    fmt::print(fg(fmt::color::light_gray),
-               "\n"
-               "Navigation:\n"
-               "  {:<6} - Move up       {:<6} - Move down\n"
-               "  {:<6} - Parent dir   {:<6} - Enter dir\n"
-               "Selection:\n"
-               "  {:<6} - Toggle       {:<6} - Multi-select\n"
-               "Tools:\n"
-               "  {:<6} - Path jump    {:<6} - Toggle this help\n"
-               "  {:<6} - Full help    {:<6} - Quit\n",
-               "↑/k", "↓/j",
-               "←/h", "→/l",
-               "Space", "Numbers",
-               ":", "!", "?", "q");
-    fmt::print(title_style, "\n{:-^60}\n", "");
+    std::string quick_help = fmt::format(title_style, "{:-^60}", " HELP ");
+    quick_help += fmt::format(fg(fmt::color::light_gray),
+                              "\n"
+                              "Navigation:\n"
+                              "  {:<13} - Move up      {:<13} - Move down\n"
+                              "  {:<13} - Parent dir   {:<13} - Enter dir\n"
+                              "Selection:\n"
+                              "  {:<13} - Toggle       {:<13} - Multi-select\n"
+                              "Tools:\n"
+                              "  {:<13} - Path jump    {:<13} - Toggle this help\n"
+                              "  {:<13} - Full help    {:<13} - Quit\n",
+                              keymap.keysLabel(Keymap::Action::MoveUp), keymap.keysLabel(Keymap::Action::MoveDown),
+                              keymap.keysLabel(Keymap::Action::Leave), keymap.keysLabel(Keymap::Action::Open),
+                              keymap.keysLabel(Keymap::Action::Open), "Numbers", ":",
+                              keymap.keysLabel(Keymap::Action::ToggleHint), keymap.keysLabel(Keymap::Action::ShowHelp),
+                              keymap.keysLabel(Keymap::Action::Quit));
+    quick_help += fmt::format(title_style, "{:-^60}", "");
+    return quick_help;
 }
 #endif // __unix__
\ No newline at end of file
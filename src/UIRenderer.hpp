@@ -1,43 +1,158 @@
 // UIRenderer.hpp
 #ifdef __unix__
 #pragma once
+#include "ContentSniffer.hpp"
+#include "DirectoryStats.hpp"
+#include "FilePreviewer.hpp"
+#include "FileSeries.hpp"
+#include "Keymap.hpp"
+#include "LineEditor.hpp"
+#include "Pager.hpp"
+#include "TreeRows.hpp"
 #include <array>
+#include <chrono>
 #include <filesystem>
 #include <fmt/chrono.h>
 #include <fmt/color.h>
 #include <fmt/core.h>
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 namespace fs = std::filesystem;
 
 class UIRenderer {
 public:
     UIRenderer();
-    void drawHeader(const fs::path &currentDirectory,
+
+    // A frame is built from sections: beginFrame(), the draw* calls, then endFrame().
+    // The file list takes whatever rows the other sections leave, so draw it last.
+    void beginFrame(size_t screenRows);
+    void drawHeader(const std::string &location,
                     const std::vector<std::string> &activeFilters,
                     bool isShowHidden,
                     const std::string &searchName,
                     bool isShowHelp, bool isShowSelected);
+    // selectedPaths holds canonical paths, whatever the selection policy.
     void drawFileList(const std::vector<fs::directory_entry> &entries,
                       size_t cursor,
-                      const std::set<fs::path> &selectedMultiPaths);
-    void drawFileList(const std::vector<fs::directory_entry> &entries,
+                      const std::set<fs::path> &selectedPaths);
+    // The tree view: only the rows in the visible window are read.
+    void drawFileList(const TreeRows &rows,
                       size_t cursor,
-                      const fs::path &selectedSinglePath);
-    void drawFooter(const std::set<fs::path> &selectedMultiPaths, bool showSelected);
-    void drawFooter(const fs::path &selectedSinglePath, bool showSelected);
-    virtual void drawHelp(bool fullHelp);
+                      const std::set<fs::path> &selectedPaths);
+    // title sums the selection up (see SelectionPolicy::describe).
+    void drawFooter(const std::set<fs::path> &selectedPaths, bool showSelected, const std::string &title);
+    void drawMessage(const std::string &message);
+    // Why the directory (or a directory expanded in the tree) could not be listed, and whether
+    // filesystem calls are overdue right now.
+    void drawFilesystemStatus(const std::string &listingProblem, const std::string &expandProblem, bool isSlow);
+    // The start of a file, in up to a third of the screen; preview is null while it is being read.
+    void drawPreview(const fs::path &file, const FilePreviewer::Preview *preview);
+    // Per-extension histogram of the current directory; stats is null until it has been counted.
+    void drawStats(const DirectoryStats::Breakdown *stats, bool isCounting);
+    void drawHud(const std::string &line);
+    // One row of Tab completions, in pages that include the selected one (no_candidate for none).
+    void drawCompletions(const std::vector<std::string> &candidates, size_t selected, size_t total);
+    void drawPrompt(const std::string &prompt, const std::string &buffer, size_t cursor);
+    // A whole frame of lines from top, between a title and the position; instead of everything else.
+    // Returns how many lines fit, the page size for the pager's keys.
+    size_t drawPager(const std::string &title, const std::vector<std::string> &lines, size_t top);
+    // Returns the bytes that turn the previous frame into this one (changed lines only).
+    std::string endFrame();
+    // Returns the bytes that leave the terminal usable below the last frame.
+    std::string endSession();
+
+    // Show each entry's whole path instead of its file name (for lists not from one directory).
+    void setShowFullPaths(bool isShowFullPaths) { this->isShowFullPaths = isShowFullPaths; }
+    // The bindings the header's hint and quick help name.
+    void setKeymap(const Keymap &keymap) { this->keymap = keymap; }
+
+    // Forget what is on screen; the next frame is drawn in full.
+    void invalidate();
+
+    // The text of the full help, with the keys bound in keymap; formatted once per keymap.
+    static Pager::Lines fullHelp(const Keymap &keymap);
+    // The per-extension counts, largest first; at most maxExtensions of them.
+    static std::vector<std::string> statsLines(const DirectoryStats::Breakdown *stats, bool isCounting,
+                                               size_t maxExtensions);
 
 private:
+    struct ListRow {
+        const fs::directory_entry *entry;
+        std::string treePrefix;           // Indentation and expansion marker in the tree view
+        const FileSeries *series{nullptr}; // A grouped series, shown as one row
+    };
+    // What a row shows beyond its name, stat'ed on a DeadlineExecutor worker.
+    struct RowMetadata {
+        fs::path canonicalPath; // Empty if the path cannot be resolved
+        std::optional<std::chrono::system_clock::time_point> modifiedTime;
+        std::optional<uintmax_t> size; // Regular files only
+        ContentSniffer::SignaturePtr signature; // If a kind filter has read the file (never read here)
+    };
+
+    std::vector<std::string> headerLines{};
+    std::vector<std::string> listLines{};
+    std::vector<std::string> footerLines{};
+    std::vector<std::string> presentedLines{};
+    size_t screenRows{24};
+    size_t listTop{0};
+    bool hasPrompt{false};
+    size_t promptColumn{0};
+    bool needsFullRedraw{true};
+    bool isShowFullPaths{false};
+    Keymap keymap{Keymap::defaults()};
+    // Display widths of non-ASCII names, worked out once per name rather than on every frame.
+    std::unordered_map<std::string, size_t> nameWidths;
+    // The last stat batch if it missed its deadline: its paths are not asked again while it runs,
+    // and what it finishes late is shown by the frames after.
+    struct StatBatch;
+    std::shared_ptr<StatBatch> overdueBatch;
+    // Byte totals of the series shown so far, by seriesKey; each is summed once, on a DeadlineExecutor
+    // worker. A batch that misses its deadline is collected by a later frame, like overdueBatch.
+    struct SeriesBatch;
+    std::shared_ptr<SeriesBatch> overdueSeries;
+    std::unordered_map<std::string, uintmax_t> seriesBytes;
+
+    static constexpr size_t name_columns = 40;
+    static constexpr size_t completion_columns = 100;
+    static constexpr size_t max_name_widths = 65'536; // Then the map starts over
+    static constexpr size_t max_series_bytes = 4'096;  // Likewise
+
+    size_t listRowBudget() const;
+    // Moves listTop so the cursor is visible; returns how many rows are shown from there.
+    size_t scrollToCursor(size_t cursor, size_t total);
+    std::vector<ListRow> listRows(const std::vector<fs::directory_entry> &entries, size_t cursor);
+    std::vector<ListRow> listRows(const TreeRows &treeRows, size_t cursor);
+    // Metadata of the rows, or nullopt for rows whose stat did not finish in time (placeholders).
+    std::vector<std::optional<RowMetadata>> statRows(const std::vector<ListRow> &rows);
+    // Fills seriesBytes for the series among rows, as far as the deadline allows.
+    void sumSeriesSizes(const std::vector<ListRow> &rows);
+    // A series is told apart by its first file and its length, so one that gains a step is summed again.
+    static std::string seriesKey(const FileSeries &series);
+    void drawRows(const std::vector<ListRow> &rows, size_t cursor, size_t total,
+                  const std::set<fs::path> &selectedPaths);
+    // hasHeaderFields adds the columns of the header fields of recognised files (MInDes mesh and steps).
+    std::string getItemBar(size_t firstRow, size_t rowCount, size_t total, bool hasHeaderFields);
+    static void appendLines(std::vector<std::string> &lines, const std::string &text);
+
     std::string getFilterStatus(const std::vector<std::string> &activeFilters);
     std::string getSearchStatus(const std::string &searchName);
 
-    std::string getFormattedFileTime(const fs::directory_entry &entry);
-    std::string getFormattedFileSize(const fs::directory_entry &entry);
-    std::string getFormattedFileName(const fs::directory_entry &entry, size_t number, bool hasPermission);
+    std::string getFormattedFileTime(const std::optional<RowMetadata> &metadata);
+    std::string getFormattedFileSize(const fs::directory_entry &entry, const std::optional<RowMetadata> &metadata);
+    static std::string formatByteCount(uintmax_t bytes);
+    static std::string getFormattedHeaderFields(const std::optional<RowMetadata> &metadata);
+    size_t nameWidth(const std::string &name);
+    std::string getFormattedFileName(const fs::directory_entry &entry, size_t number, bool hasPermission,
+                                     const std::string &treePrefix);
+    // Label, file count and total size of a series row.
+    std::string getFormattedSeries(const FileSeries &series, size_t number, const std::string &treePrefix);
+    std::string padName(const std::string &name, const std::string &treePrefix);
 
-    void printFullHelp();
-    void printQuickHelp();
+    static std::vector<std::string> formatFullHelp(const Keymap &keymap);
+    std::string getQuickHelp();
 };
 #endif // __unix__
\ No newline at end of file
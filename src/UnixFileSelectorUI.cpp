@@ -3,163 +3,183 @@
 #include "UnixFileSelectorUI.hpp"
 #include "CommandProcessor.hpp"
 #include "FileSystemManager.hpp"
-#include "KeyEnum.hpp"
+#include "OutputSinks.hpp"
+#include "SelectionPolicy.hpp"
+#include "SelectorSession.hpp"
+#include "SessionState.hpp"
 #include "TerminalManager.hpp"
-#include "UIRenderer.hpp"
 
-#include <chrono>
 #include <filesystem>
-#include <iostream>
-#include <sstream>
+#include <stdexcept>
 
-#include <unistd.h> // for STDIN_FILENO
-
-#include <fmt/color.h>
-#include <fmt/core.h>
+#include <fcntl.h>
+#include <unistd.h> // for STDOUT_FILENO
 
 namespace fs = std::filesystem;
-UnixFileSelectorUI::UnixFileSelectorUI(const fs::path &start, const std::vector<std::string> &exts)
-    : startPath(start), extensions(exts) {
+
+namespace {
+struct UniqueFd {
+    int fd{-1};
+    ~UniqueFd() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+} // namespace
+
+UnixFileSelectorUI::UnixFileSelectorUI(const fs::path &start, const std::vector<std::string> &exts,
+                                       std::shared_ptr<IInputSource> input,
+                                       std::shared_ptr<IOutputSink> output)
+    : startPath(start), extensions(exts), inputSource(std::move(input)), outputSink(std::move(output)) {
 }
 
-std::vector<fs::path> UnixFileSelectorUI::selectMultipleFile() {
-    // Create instances of our components.
-    FileSystemManager fsManager(startPath, extensions);
-    UIRenderer uiRenderer;
-    CommandProcessor cmdProcessor(fsManager, uiRenderer);
-    TerminalManager termMgr; // On construction, TerminalManager sets up raw mode.
+UnixFileSelectorUI::~UnixFileSelectorUI() = default;
 
-    std::string command_buffer;
-    std::string error_message{};
+void UnixFileSelectorUI::resumeSession(const fs::path &stateFile) {
+    sessionState = std::make_unique<SessionState>(stateFile);
+}
 
-    // Main loop – run until the CommandProcessor signals to quit.
-    while (!cmdProcessor.shouldQuit()) {
-        fsManager.refreshDirectory(cmdProcessor.isShowHidden);
+void UnixFileSelectorUI::setKeymap(const fs::path &keymapFile) {
+    if (keymapFile.empty()) {
+        keymap = Keymap::defaults();
+        return;
+    }
+    auto loaded = Keymap::load(keymapFile);
+    if (!loaded) {
+        throw std::invalid_argument(loaded.error().message);
+    }
+    keymap = loaded.value();
+}
 
-        uiRenderer.drawHelp(false);
-        uiRenderer.drawHeader(fsManager.getCurrentDirectory().string(), fsManager.getFilters(),
-                              cmdProcessor.isShowHidden, fsManager.searchName, cmdProcessor.isShowHint, cmdProcessor.isShowSelected);
-        uiRenderer.drawFileList(fsManager.getEntries(), cmdProcessor.getCursor(),
-                                cmdProcessor.getSelectedMultiPaths());
-        if (!error_message.empty()) {
-            fmt::print(fg(fmt::color::purple), "\n{}", error_message);
-            error_message.clear();
-        }
-        uiRenderer.drawFooter(cmdProcessor.getSelectedMultiPaths(), cmdProcessor.isShowSelected);
-        // Wait for a key press.
-        int key = termMgr.readKey();
-        try {
-            if (key == ':') {
-                termMgr.setCanonicalMode();
-                fmt::print(fmt::fg(fmt::color::steel_blue),
-                           "Command :");
-                std::cout.flush();
-
-                command_buffer += termMgr.getLineByChar();
-                cmdProcessor.processCommandInput(command_buffer);
-                command_buffer.clear();
-                termMgr.setRawMode();
-            } else if (key >= '0' && key <= '9') {
-                termMgr.setCanonicalMode();
-                fmt::print(fmt::fg(fmt::color::steel_blue),
-                           "Number ");
-                std::cout << static_cast<char>(key) << std::flush;
-
-                command_buffer = static_cast<char>(key) + termMgr.getLineByChar();
-
-                cmdProcessor.processNumberInput(command_buffer);
-                command_buffer.clear();
-                termMgr.setRawMode();
-            } else {
-                cmdProcessor.processImmediateInput(key);
-            }
-        } catch (std::invalid_argument &e) {
-            command_buffer.clear();
-            error_message = e.what();
-            termMgr.setRawMode();
-        } catch (std::runtime_error &e) {
-            command_buffer.clear();
-            error_message = e.what();
-            termMgr.setRawMode();
+fs::path UnixFileSelectorUI::initialDirectory() const {
+    if (sessionState && candidateFd < 0) {
+        auto directory = sessionState->directory();
+        std::error_code ec;
+        if (directory && fs::is_directory(*directory, ec)) {
+            return *directory;
         }
     }
+    return startPath;
+}
 
-    // Restore terminal settings.
-    termMgr.restoreTerminal();
+std::vector<fs::path> UnixFileSelectorUI::selectMultipleFile() {
+    // Create instances of our components.
+    FileSystemManager fsManager(initialDirectory(), extensions);
+    CommandProcessor cmdProcessor(fsManager);
+    runSession(fsManager, cmdProcessor, MultipleSelection{});
 
     // Prepare the result: convert each selected fs::path into a std::string.
     std::vector<fs::path> selectedFiles;
-    for (const auto &path : cmdProcessor.getSelectedMultiPaths()) {
+    for (const auto &path : cmdProcessor.getSelectedPaths()) {
         selectedFiles.push_back(path);
     }
     return selectedFiles;
 }
 
+std::vector<fs::path> UnixFileSelectorUI::selectUpTo(size_t maxFiles) {
+    FileSystemManager fsManager(initialDirectory(), extensions);
+    CommandProcessor cmdProcessor(fsManager);
+    runSession(fsManager, cmdProcessor, BoundedSelection{0, maxFiles});
+    const auto &selected = cmdProcessor.getSelectedPaths();
+    return {selected.begin(), selected.end()};
+}
+
+std::vector<fs::path> UnixFileSelectorUI::selectExactly(size_t count) {
+    FileSystemManager fsManager(initialDirectory(), extensions);
+    CommandProcessor cmdProcessor(fsManager);
+    runSession(fsManager, cmdProcessor, BoundedSelection{count, count});
+    // The input can end before the selection is complete; that cancels it.
+    const auto &selected = cmdProcessor.getSelectedPaths();
+    if (selected.size() != count) {
+        return {};
+    }
+    return {selected.begin(), selected.end()};
+}
+
+void UnixFileSelectorUI::readCandidatesFrom(int fd, char separator) {
+    candidateFd = fd;
+    candidateSeparator = separator;
+}
+
+void UnixFileSelectorUI::selectMultipleFile(const std::function<void(const fs::path &)> &onSelected) {
+    FileSystemManager fsManager(initialDirectory(), extensions);
+    CommandProcessor cmdProcessor(fsManager);
+    runSession(fsManager, cmdProcessor, MultipleSelection{});
+
+    // Straight from the selection set, no intermediate copy.
+    for (const auto &path : cmdProcessor.getSelectedPaths()) {
+        onSelected(path);
+    }
+}
+
 fs::path UnixFileSelectorUI::selectSingleFile() {
-    // TODO: Implement single-only logic
     // Create instances of our components.
-    FileSystemManager fsManager(startPath, extensions);
-    UIRenderer uiRenderer;
-    CommandProcessor cmdProcessor(fsManager, uiRenderer);
-    TerminalManager termMgr; // On construction, TerminalManager sets up raw mode.
+    FileSystemManager fsManager(initialDirectory(), extensions);
+    CommandProcessor cmdProcessor(fsManager);
+    runSession(fsManager, cmdProcessor, SingleSelection{});
 
-    std::string command_buffer;
-    std::string error_message{};
+    const auto &selected = cmdProcessor.getSelectedPaths();
+    return selected.empty() ? fs::path() : *selected.begin();
+}
 
-    // Main loop – run until the CommandProcessor signals to quit.
-    while (!cmdProcessor.shouldQuit()) {
-        fsManager.refreshDirectory(cmdProcessor.isShowHidden);
+template <typename Policy>
+void UnixFileSelectorUI::runSession(FileSystemManager &fsManager, CommandProcessor &cmdProcessor, const Policy &policy) {
+    if (candidateFd >= 0) {
+        fsManager.readCandidates(candidateFd, candidateSeparator);
+    }
 
-        uiRenderer.drawHelp(false);
-        uiRenderer.drawHeader(fsManager.getCurrentDirectory().string(), fsManager.getFilters(),
-                              cmdProcessor.isShowHidden, fsManager.searchName, cmdProcessor.isShowHint, cmdProcessor.isShowSelected);
-        uiRenderer.drawFileList(fsManager.getEntries(), cmdProcessor.getCursor(),
-                                cmdProcessor.getSelectedSinglePath());
-        if (!error_message.empty()) {
-            fmt::print(fg(fmt::color::purple), "\n{}", error_message);
-            error_message.clear();
-        }
-        uiRenderer.drawFooter(cmdProcessor.getSelectedSinglePath(), cmdProcessor.isShowSelected);
-        // Wait for a key press.
-        int key = termMgr.readKey();
-        try {
-            if (key == ':') {
-                termMgr.setCanonicalMode();
-                fmt::print(fmt::fg(fmt::color::steel_blue),
-                           "Command :");
-                std::cout.flush();
-
-                command_buffer += termMgr.getLineByChar();
-                cmdProcessor.processCommandInput(command_buffer);
-                command_buffer.clear();
-                termMgr.setRawMode();
-            } else if (key >= '0' && key <= '9') {
-                termMgr.setCanonicalMode();
-                fmt::print(fmt::fg(fmt::color::steel_blue),
-                           "Number ");
-                std::cout << static_cast<char>(key) << std::flush;
-
-                command_buffer = static_cast<char>(key) + termMgr.getLineByChar();
-
-                cmdProcessor.processNumberInputSingle(command_buffer);
-                command_buffer.clear();
-                termMgr.setRawMode();
-            } else {
-                cmdProcessor.processImmediateInputSingle(key);
-            }
-        } catch (std::invalid_argument &e) {
-            command_buffer.clear();
-            error_message = e.what();
-            termMgr.setRawMode();
-        } catch (std::runtime_error &e) {
-            command_buffer.clear();
-            error_message = e.what();
-            termMgr.setRawMode();
+    // The terminal is only touched when nothing was injected, so headless runs need no TTY.
+    // Keys come from /dev/tty when stdin is not the terminal (e.g. it carries the candidates).
+    UniqueFd tty_input;
+    std::unique_ptr<TerminalManager> termMgr; // On construction, TerminalManager sets up raw mode.
+    IInputSource *input = inputSource.get();
+    if (!input) {
+        if (!isatty(STDIN_FILENO)) {
+            tty_input.fd = open("/dev/tty", O_RDONLY | O_CLOEXEC);
         }
+        termMgr = std::make_unique<TerminalManager>(tty_input.fd >= 0 ? tty_input.fd : STDIN_FILENO);
+        input = termMgr.get();
+    }
+    // When stdout is not the terminal (the selection is piped on), frames go to the terminal directly.
+    UniqueFd tty;
+    if (!outputSink && !isatty(STDOUT_FILENO)) {
+        tty.fd = open("/dev/tty", O_WRONLY | O_CLOEXEC);
     }
-    // Restore terminal settings.
-    termMgr.restoreTerminal();
+    FdOutputSink terminal_sink(tty.fd >= 0 ? tty.fd : STDOUT_FILENO);
+    IOutputSink *output = outputSink ? outputSink.get() : &terminal_sink;
 
-    return cmdProcessor.getSelectedSinglePath();
+    if (!keymap) {
+        const fs::path user_keymap = Keymap::defaultFile();
+        std::error_code ec;
+        setKeymap(!user_keymap.empty() && fs::exists(user_keymap, ec) ? user_keymap : fs::path());
+    }
+    cmdProcessor.setKeymap(*keymap);
+
+    fsManager.enablePrefetch();
+    SelectorSession<Policy> session(fsManager, cmdProcessor, policy, *input, *output);
+    if (sessionState) {
+        // The selection is only kept when any number of files can be selected; a bounded one starts empty.
+        SessionState::State state = sessionState->read();
+        if (state.filters) {
+            fsManager.setFilters(*state.filters);
+        }
+        if (state.sortPolicy) {
+            fsManager.setSortPolicy(*state.sortPolicy);
+        }
+        if (state.searchName) {
+            fsManager.searchName = *state.searchName;
+        }
+        fsManager.refreshDirectory(cmdProcessor.isShowHidden);
+        cmdProcessor.restore(state.cursor, !Policy::is_bounded ? std::move(state.selection) : std::set<fs::path>{});
+        if constexpr (!Policy::is_bounded) {
+            cmdProcessor.setOnSelectionChanged([this](const fs::path &path, bool isSelected) {
+                sessionState->recordSelection(path, isSelected);
+            });
+        }
+        session.recordTo(*sessionState, std::move(state.commandHistory));
+    }
+    session.run();
+    cmdProcessor.setOnSelectionChanged({});
 }
-#endif // __unix__
\ No newline at end of file
+#endif // __unix__
@@ -1,20 +1,51 @@
 #ifdef __unix__
 #pragma once
 #include "IFileSelectorUI.hpp"
+#include "IInputSource.hpp"
+#include "IOutputSink.hpp"
+#include "Keymap.hpp"
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <filesystem>
 namespace fs = std::filesystem;
 
+class CommandProcessor;
+class FileSystemManager;
+class SessionState;
+
 class UnixFileSelectorUI : public IFileSelectorUI {
 public:
-    UnixFileSelectorUI(const fs::path &start, const std::vector<std::string> &exts);
+    // Without an injected input/output the selector runs on the controlling terminal.
+    UnixFileSelectorUI(const fs::path &start, const std::vector<std::string> &exts,
+                       std::shared_ptr<IInputSource> input = nullptr,
+                       std::shared_ptr<IOutputSink> output = nullptr);
+    ~UnixFileSelectorUI() override;
     std::vector<fs::path> selectMultipleFile() override;
     fs::path selectSingleFile() override;
+    std::vector<fs::path> selectUpTo(size_t maxFiles) override;
+    std::vector<fs::path> selectExactly(size_t count) override;
+    void selectMultipleFile(const std::function<void(const fs::path &)> &onSelected) override;
+    void readCandidatesFrom(int fd, char separator) override;
+    void resumeSession(const fs::path &stateFile) override;
+    void setKeymap(const fs::path &keymapFile) override;
 
 private:
     fs::path startPath;
     std::vector<std::string> extensions;
+    std::shared_ptr<IInputSource> inputSource;
+    std::shared_ptr<IOutputSink> outputSink;
+    int candidateFd{-1};
+    char candidateSeparator{'\n'};
+    std::unique_ptr<SessionState> sessionState;
+    std::optional<Keymap> keymap; // Until set, the user's keymap file is read by the first selection
+
+    // Where a selection starts: the directory of the resumed session if it still exists, else startPath.
+    fs::path initialDirectory() const;
+    // Policy is one of SelectionPolicy.hpp.
+    template <typename Policy>
+    void runSession(FileSystemManager &fsManager, CommandProcessor &cmdProcessor, const Policy &policy);
 };
 #endif // __unix__